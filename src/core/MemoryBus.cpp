@@ -0,0 +1,136 @@
+#include "MemoryBus.hpp"
+#include <bit>
+
+
+MemoryBus::MemoryBus() {
+    unmap(0x0000, 0x10000);
+}
+
+
+void MemoryBus::mapRom(uint16_t start, uint32_t size, const uint8_t* data) {
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        const size_t page = (start + offset) >> PAGE_SHIFT;
+        page_data[page] = data + offset;
+        ram_pages[page] = nullptr;
+        devices[page] = nullptr;
+        refreshPage(page);
+    }
+}
+
+
+void MemoryBus::mapRam(uint16_t start, uint32_t size, uint8_t* data) {
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        const size_t page = (start + offset) >> PAGE_SHIFT;
+        page_data[page] = data + offset;
+        ram_pages[page] = data + offset;
+        devices[page] = nullptr;
+        refreshPage(page);
+    }
+}
+
+
+void MemoryBus::mapDevice(uint16_t start, uint32_t size, BusDevice* device) {
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        const size_t page = (start + offset) >> PAGE_SHIFT;
+        page_data[page] = nullptr;
+        ram_pages[page] = nullptr;
+        devices[page] = device;
+        refreshPage(page);
+    }
+}
+
+
+void MemoryBus::unmap(uint16_t start, uint32_t size) {
+    mapDevice(start, size, nullptr);
+}
+
+
+// ----- WATCHERS -----
+
+int MemoryBus::attachWatcher(BusWatcher* watcher) {
+    for (int slot = 0; slot < MAX_WATCHERS; ++slot) {
+        if (!watchers[slot]) {
+            watchers[slot] = watcher;
+            return slot;
+        }
+    }
+    return -1;
+}
+
+
+void MemoryBus::detachWatcher(int slot) {
+    if (slot < 0 || slot >= MAX_WATCHERS)
+        return;
+
+    for (size_t page = 0; page < PAGE_COUNT; ++page) {
+        if ((read_traps[page] | write_traps[page]) & (1u << slot))
+            releasePage(slot, static_cast<uint8_t>(page), BUS_READ | BUS_WRITE);
+    }
+    watchers[slot] = nullptr;
+}
+
+
+void MemoryBus::trapPage(int slot, uint8_t page, uint8_t access) {
+    if (slot < 0 || slot >= MAX_WATCHERS)
+        return;
+
+    if (access & BUS_READ)
+        read_traps[page] |= static_cast<uint8_t>(1u << slot);
+    if (access & BUS_WRITE)
+        write_traps[page] |= static_cast<uint8_t>(1u << slot);
+    refreshPage(page);
+}
+
+
+void MemoryBus::releasePage(int slot, uint8_t page, uint8_t access) {
+    if (slot < 0 || slot >= MAX_WATCHERS)
+        return;
+
+    if (access & BUS_READ)
+        read_traps[page] &= static_cast<uint8_t>(~(1u << slot));
+    if (access & BUS_WRITE)
+        write_traps[page] &= static_cast<uint8_t>(~(1u << slot));
+    refreshPage(page);
+}
+
+
+// A page keeps its fast pointers only while nobody traps it
+void MemoryBus::refreshPage(size_t page) {
+    read_pages[page] = read_traps[page] ? nullptr : page_data[page];
+    write_pages[page] = write_traps[page] ? nullptr : ram_pages[page];
+}
+
+
+// ----- SLOW PATH -----
+
+uint8_t MemoryBus::slowRead(uint16_t address) const {
+    const size_t page = address >> PAGE_SHIFT;
+    BusDevice* device = devices[page];
+
+    uint8_t value = 0xFF;
+    if (page_data[page])
+        value = page_data[page][address & (PAGE_SIZE - 1)];
+    else if (device)
+        value = device->read(address);
+
+    for (uint8_t traps = read_traps[page]; traps; traps &= traps - 1)
+        watchers[std::countr_zero(traps)]->onRead(address, value);
+    return value;
+}
+
+
+void MemoryBus::slowWrite(uint16_t address, uint8_t value) {
+    const size_t page = address >> PAGE_SHIFT;
+
+    // Watchers see the write before it lands, so the old value is still readable
+    for (uint8_t traps = write_traps[page]; traps; traps &= traps - 1)
+        watchers[std::countr_zero(traps)]->onWrite(address, value);
+
+    if (ram_pages[page]) {
+        ram_pages[page][address & (PAGE_SIZE - 1)] = value;
+        return;
+    }
+
+    if (devices[page])
+        devices[page]->write(address, value);
+}
@@ -0,0 +1,120 @@
+#ifndef MEMORY_BUS_HPP
+#define MEMORY_BUS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/* MemoryBus maps the 64 KB Z80 address space in 256-byte pages.
+ *
+ * ROM and RAM pages are plain pointers, so read8()/write8() are one table lookup
+ * and one load/store. Pages without a direct pointer (I/O, unmapped holes, or
+ * RAM whose writes are being trapped) take the slow path through a BusDevice.
+ * I/O ports (IN/OUT) always go to the port device.
+ *
+ * A BusWatcher can trap reads and/or writes of single pages. Trapped pages lose
+ * their fast pointer, so only accesses to those pages pay for the notification;
+ * the access itself still completes normally afterwards.
+ */
+
+class BusDevice {
+    public:
+    virtual ~BusDevice() = default;
+    virtual uint8_t read(uint16_t address) = 0;
+    virtual void write(uint16_t address, uint8_t value) = 0;
+};
+
+
+enum BusAccess : uint8_t {
+    BUS_READ = 0x01,
+    BUS_WRITE = 0x02
+};
+
+
+class BusWatcher {
+    public:
+    virtual ~BusWatcher() = default;
+    virtual void onRead(uint16_t address, uint8_t value) { (void)address; (void)value; }
+    virtual void onWrite(uint16_t address, uint8_t value) { (void)address; (void)value; }
+};
+
+
+class MemoryBus {
+    public:
+    static constexpr uint32_t PAGE_SHIFT = 8;
+    static constexpr uint32_t PAGE_SIZE = 1u << PAGE_SHIFT;
+    static constexpr uint32_t PAGE_COUNT = 0x10000 >> PAGE_SHIFT;
+    static constexpr int MAX_WATCHERS = 8;
+
+    MemoryBus();
+
+    // 'start' and 'size' must be page aligned
+    void mapRom(uint16_t start, uint32_t size, const uint8_t* data);
+    void mapRam(uint16_t start, uint32_t size, uint8_t* data);
+    void mapDevice(uint16_t start, uint32_t size, BusDevice* device);
+    void unmap(uint16_t start, uint32_t size);
+    void setPortDevice(BusDevice* device) { port_device = device; }
+
+    // Returns a slot for trapPage(), or -1 when all slots are taken
+    int attachWatcher(BusWatcher* watcher);
+    void detachWatcher(int slot);             // also releases every page the slot trapped
+    void trapPage(int slot, uint8_t page, uint8_t access);
+    void releasePage(int slot, uint8_t page, uint8_t access);
+
+    uint8_t read8(uint16_t address) const {
+        const uint8_t* page = read_pages[address >> PAGE_SHIFT];
+        if (page)
+            return page[address & (PAGE_SIZE - 1)];
+        return slowRead(address);
+    }
+
+    void write8(uint16_t address, uint8_t value) {
+        uint8_t* page = write_pages[address >> PAGE_SHIFT];
+        if (page) {
+            page[address & (PAGE_SIZE - 1)] = value;
+            return;
+        }
+        slowWrite(address, value);
+    }
+
+    uint16_t read16(uint16_t address) const {
+        return static_cast<uint16_t>(read8(address) | (read8(static_cast<uint16_t>(address + 1)) << 8));
+    }
+
+    void write16(uint16_t address, uint16_t value) {
+        write8(address, static_cast<uint8_t>(value));
+        write8(static_cast<uint16_t>(address + 1), static_cast<uint8_t>(value >> 8));
+    }
+
+    uint8_t in(uint16_t port) { return port_device ? port_device->read(port) : 0xFF; }
+    void out(uint16_t port, uint8_t value) { if (port_device) port_device->write(port, value); }
+
+    // Direct pointer to a mapped ROM/RAM page (trapped or not), nullptr for device/unmapped pages
+    const uint8_t* pageData(uint8_t page) const { return page_data[page]; }
+    bool isWritable(uint8_t page) const { return ram_pages[page] != nullptr; }
+
+    // Reads without side effects or watcher notifications; devices read as 0xFF
+    uint8_t peek8(uint16_t address) const {
+        const uint8_t* page = page_data[address >> PAGE_SHIFT];
+        return page ? page[address & (PAGE_SIZE - 1)] : 0xFF;
+    }
+
+    private:
+    uint8_t slowRead(uint16_t address) const;
+    void slowWrite(uint16_t address, uint8_t value);
+    void refreshPage(size_t page);
+
+    std::array<const uint8_t*, PAGE_COUNT> read_pages{};    // fast path; nullptr traps the read
+    std::array<const uint8_t*, PAGE_COUNT> page_data{};     // mapped ROM/RAM data
+    std::array<uint8_t*, PAGE_COUNT> write_pages{};     // fast path; nullptr traps the write
+    std::array<uint8_t*, PAGE_COUNT> ram_pages{};       // backing store of RAM pages
+    std::array<BusDevice*, PAGE_COUNT> devices{};
+    BusDevice* port_device = nullptr;
+
+    std::array<BusWatcher*, MAX_WATCHERS> watchers{};
+    std::array<uint8_t, PAGE_COUNT> read_traps{};          // bit per watcher slot
+    std::array<uint8_t, PAGE_COUNT> write_traps{};
+};
+
+
+#endif
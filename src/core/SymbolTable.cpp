@@ -0,0 +1,197 @@
+#include "SymbolTable.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+
+void SymbolTable::add(uint16_t start, uint16_t end, std::string_view name, std::string_view comment) {
+    if (symbols.size() >= NO_SYMBOL) {
+        std::cerr << "Symbol table is full, dropping " << name << "\n";
+        return;
+    }
+
+    Symbol symbol;
+    symbol.start = start;
+    symbol.end = std::max(start, end);
+    symbol.name_offset = static_cast<uint32_t>(pool.size());
+    symbol.name_length = static_cast<uint16_t>(std::min<size_t>(name.size(), 0xFFFF));
+    pool.append(name.substr(0, symbol.name_length));
+    symbol.comment_offset = static_cast<uint32_t>(pool.size());
+    symbol.comment_length = static_cast<uint16_t>(std::min<size_t>(comment.size(), 0xFFFF));
+    pool.append(comment.substr(0, symbol.comment_length));
+
+    symbols.push_back(symbol);
+}
+
+
+void SymbolTable::addLabel(uint16_t start, std::string_view name, std::string_view comment) {
+    add(start, start, name, comment);
+    if (!symbols.empty() && symbols.back().start == start)
+        symbols.back().open_ended = true;
+}
+
+
+void SymbolTable::clear() {
+    pool.clear();
+    symbols.clear();
+    segments.clear();
+}
+
+
+void SymbolTable::build() {
+    std::stable_sort(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) {
+        return a.start < b.start;
+    });
+
+    // Open-ended symbols run up to the next symbol that starts after them
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (!symbols[i].open_ended)
+            continue;
+        size_t next = i + 1;
+        while (next < symbols.size() && symbols[next].start == symbols[i].start)
+            ++next;
+        symbols[i].end = next < symbols.size() ? static_cast<uint16_t>(symbols[next].start - 1) : 0xFFFF;
+    }
+
+    // Paint the widest ranges first so the innermost symbol owns each address,
+    // then keep only the points where the owner changes
+    std::vector<uint16_t> order(symbols.size());
+    std::iota(order.begin(), order.end(), uint16_t(0));
+    std::stable_sort(order.begin(), order.end(), [this](uint16_t a, uint16_t b) {
+        return symbols[a].end - symbols[a].start > symbols[b].end - symbols[b].start;
+    });
+
+    std::vector<uint16_t> owner(0x10000, NO_SYMBOL);
+    for (uint16_t index : order)
+        std::fill(owner.begin() + symbols[index].start, owner.begin() + symbols[index].end + 1, index);
+
+    segments.clear();
+    for (uint32_t address = 0; address < owner.size(); ++address) {
+        if (address == 0 || owner[address] != owner[address - 1])
+            segments.push_back({ static_cast<uint16_t>(address), owner[address] });
+    }
+}
+
+
+const Symbol* SymbolTable::lookup(uint16_t address) const {
+    auto it = std::upper_bound(segments.begin(), segments.end(), address,
+                               [](uint16_t value, const Segment& segment) { return value < segment.start; });
+    if (it == segments.begin())
+        return nullptr;
+
+    --it;
+    return it->symbol == NO_SYMBOL ? nullptr : &symbols[it->symbol];
+}
+
+
+const Symbol* SymbolTable::at(uint16_t address) const {
+    auto it = std::lower_bound(symbols.begin(), symbols.end(), address,
+                               [](const Symbol& symbol, uint16_t value) { return symbol.start < value; });
+    return (it != symbols.end() && it->start == address) ? &*it : nullptr;
+}
+
+
+bool SymbolTable::formatAddress(std::ostream& out, uint16_t address) const {
+    const Symbol* symbol = lookup(address);
+    if (!symbol)
+        return false;
+
+    out << name(*symbol);
+    if (address != symbol->start) {
+        const std::ios_base::fmtflags flags = out.flags();
+        out << "+" << std::hex << (address - symbol->start);
+        out.flags(flags);
+    }
+    return true;
+}
+
+
+std::string SymbolTable::functionName(uint16_t address) const {
+    std::ostringstream hex;
+    hex << std::hex << std::setw(4) << std::setfill('0') << address;
+
+    // The address keeps names unique; the prefix keeps them clear of keywords and other globals
+    std::string identifier = "blk_" + hex.str();
+    const Symbol* symbol = lookup(address);
+    if (!symbol || symbol->name_length == 0)
+        return identifier;
+
+    identifier += '_';
+    for (char c : name(*symbol)) {
+        const bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        identifier += valid ? c : '_';
+    }
+    return identifier;
+}
+
+
+static bool parseHex(std::string_view text, unsigned int& value) {
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+    return !text.empty() && error == std::errc() && end == text.data() + text.size();
+}
+
+
+bool loadSymbolFile(const std::filesystem::path& symbol_file, SymbolTable& out) {
+    std::ifstream in(symbol_file);
+    if (!in) {
+        std::cerr << "Failed to open symbol file: " << symbol_file << "\n";
+        return false;
+    }
+
+    std::string line;
+    size_t line_number = 0;
+
+    while (std::getline(in, line)) {
+        ++line_number;
+
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+
+        // Everything after ';' is the comment
+        std::string comment;
+        const size_t semicolon = line.find(';');
+        if (semicolon != std::string::npos) {
+            const size_t text = line.find_first_not_of(" \t", semicolon + 1);
+            const size_t last = line.find_last_not_of(" \t\r");
+            if (text != std::string::npos && last >= text)
+                comment = line.substr(text, last - text + 1);
+            line.erase(semicolon);
+        }
+
+        std::istringstream fields(line);
+        std::string range;
+        std::string name;
+        fields >> range >> name;
+
+        // "start" or "start-end", both hex
+        const size_t dash = range.find('-');
+        const std::string_view text(range);
+        const std::string_view start_text = text.substr(0, dash);
+        const std::string_view end_text = dash == std::string::npos ? std::string_view{} : text.substr(dash + 1);
+
+        unsigned int start = 0;
+        unsigned int end = 0;
+        if (!parseHex(start_text, start) || (dash != std::string::npos && !parseHex(end_text, end))) {
+            std::cerr << "Bad symbol address on line " << line_number << " in " << symbol_file << "\n";
+            return false;
+        }
+
+        if (name.empty() || start > 0xFFFF || end > 0xFFFF || (dash != std::string::npos && end < start)) {
+            std::cerr << "Malformed symbol line " << line_number << " in " << symbol_file << "\n";
+            return false;
+        }
+
+        if (dash == std::string::npos)
+            out.addLabel(static_cast<uint16_t>(start), name, comment);
+        else
+            out.add(static_cast<uint16_t>(start), static_cast<uint16_t>(end), name, comment);
+    }
+
+    out.build();
+    return true;
+}
@@ -0,0 +1,85 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* SymbolTable names address ranges of the program: routines, tables, RAM variables.
+ *
+ * Names and comments live in one string pool; symbols are small fixed records
+ * sorted by start address. build() flattens possibly nested ranges into disjoint
+ * segments, each owned by the innermost symbol covering it, so lookup() is a
+ * binary search over 16-bit keys and never touches a string.
+ *
+ * Symbol files are plain text, one symbol per line:
+ *
+ *     0a2c-0b11  draw_maze      ; comment shown in the disassembly
+ *     2fc0       sound_irq
+ *
+ * A symbol without an end runs up to the next symbol. Blank lines and lines
+ * starting with '#' are ignored.
+ */
+
+struct Symbol {
+    uint16_t start = 0;
+    uint16_t end = 0;              // inclusive
+    uint32_t name_offset = 0;      // into the string pool
+    uint32_t comment_offset = 0;
+    uint16_t name_length = 0;
+    uint16_t comment_length = 0;
+    bool open_ended = false;       // end is taken from the next symbol
+};
+
+
+class SymbolTable {
+    public:
+    // Call build() after the last add()
+    void add(uint16_t start, uint16_t end, std::string_view name, std::string_view comment = {});
+    void addLabel(uint16_t start, std::string_view name, std::string_view comment = {});   // open ended
+    void build();
+    void clear();
+
+    // Innermost symbol covering 'address', or nullptr
+    const Symbol* lookup(uint16_t address) const;
+
+    // Symbol starting exactly at 'address', or nullptr
+    const Symbol* at(uint16_t address) const;
+
+    std::string_view name(const Symbol& symbol) const { return { pool.data() + symbol.name_offset, symbol.name_length }; }
+    std::string_view comment(const Symbol& symbol) const {
+        return { pool.data() + symbol.comment_offset, symbol.comment_length };
+    }
+
+    // Writes "name" or "name+off" (hex), or nothing and returns false when no symbol covers it
+    bool formatAddress(std::ostream& out, uint16_t address) const;
+
+    // A valid C++ identifier for code generated at 'address', unique per address:
+    // "blk_xxxx" plus "_" and the sanitized name of the symbol covering it, if any
+    std::string functionName(uint16_t address) const;
+
+    const std::vector<Symbol>& entries() const { return symbols; }
+    size_t size() const { return symbols.size(); }
+    bool empty() const { return symbols.empty(); }
+
+    private:
+    struct Segment {
+        uint16_t start;
+        uint16_t symbol;           // index into 'symbols', NO_SYMBOL for gaps
+    };
+    static constexpr uint16_t NO_SYMBOL = 0xFFFF;
+
+    std::string pool;
+    std::vector<Symbol> symbols;
+    std::vector<Segment> segments;
+};
+
+
+// Returns false (and reports the line) when the file cannot be parsed
+bool loadSymbolFile(const std::filesystem::path& symbol_file, SymbolTable& out);
+
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef Z80_ALU_HPP
+#define Z80_ALU_HPP
+
+#include <array>
+#include <cstdint>
+
+/* Z80Alu holds the flag arithmetic of every Z80 ALU operation as pure functions
+ * on values, so the interpreter and generated code share one implementation and
+ * the flags can live in a host local instead of the CPU struct.
+ */
+
+struct Z80Alu {
+    static constexpr uint8_t FLAG_C = 0x01;
+    static constexpr uint8_t FLAG_N = 0x02;
+    static constexpr uint8_t FLAG_P = 0x04;   // parity / overflow
+    static constexpr uint8_t FLAG_X = 0x08;   // undocumented copy of bit 3
+    static constexpr uint8_t FLAG_H = 0x10;
+    static constexpr uint8_t FLAG_Y = 0x20;   // undocumented copy of bit 5
+    static constexpr uint8_t FLAG_Z = 0x40;
+    static constexpr uint8_t FLAG_S = 0x80;
+
+    // Sign, zero and undocumented bits for a result
+    static constexpr std::array<uint8_t, 256> SZ_TABLE = [] {
+        std::array<uint8_t, 256> table{};
+        for (int v = 0; v < 256; ++v)
+            table[v] = static_cast<uint8_t>((v & (FLAG_S | FLAG_X | FLAG_Y)) | (v == 0 ? FLAG_Z : 0));
+        return table;
+    }();
+
+    // SZ_TABLE plus even parity
+    static constexpr std::array<uint8_t, 256> SZP_TABLE = [] {
+        std::array<uint8_t, 256> table{};
+        for (int v = 0; v < 256; ++v) {
+            int bits = 0;
+            for (int b = 0; b < 8; ++b)
+                bits += (v >> b) & 1;
+            table[v] = static_cast<uint8_t>(SZ_TABLE[v] | ((bits & 1) ? 0 : FLAG_P));
+        }
+        return table;
+    }();
+
+    // ----- 8-BIT ARITHMETIC -----
+
+    static uint8_t add8(uint8_t a, uint8_t v, uint8_t carry, uint8_t& f) {
+        const unsigned r = a + v + carry;
+        f = static_cast<uint8_t>(SZ_TABLE[r & 0xFF] | ((a ^ v ^ r) & FLAG_H) |
+                                 (((a ^ ~v) & (a ^ r) & 0x80) >> 5) | ((r >> 8) & FLAG_C));
+        return static_cast<uint8_t>(r);
+    }
+
+    static uint8_t sub8(uint8_t a, uint8_t v, uint8_t carry, uint8_t& f) {
+        const unsigned r = a - v - carry;
+        f = static_cast<uint8_t>(SZ_TABLE[r & 0xFF] | FLAG_N | ((a ^ v ^ r) & FLAG_H) |
+                                 (((a ^ v) & (a ^ r) & 0x80) >> 5) | ((r >> 8) & FLAG_C));
+        return static_cast<uint8_t>(r);
+    }
+
+    // Like SUB, but X/Y come from the operand and A is unchanged
+    static void cp8(uint8_t a, uint8_t v, uint8_t& f) {
+        sub8(a, v, 0, f);
+        f = static_cast<uint8_t>((f & ~(FLAG_X | FLAG_Y)) | (v & (FLAG_X | FLAG_Y)));
+    }
+
+    static uint8_t and8(uint8_t a, uint8_t v, uint8_t& f) {
+        const uint8_t r = a & v;
+        f = SZP_TABLE[r] | FLAG_H;
+        return r;
+    }
+
+    static uint8_t xor8(uint8_t a, uint8_t v, uint8_t& f) {
+        const uint8_t r = a ^ v;
+        f = SZP_TABLE[r];
+        return r;
+    }
+
+    static uint8_t or8(uint8_t a, uint8_t v, uint8_t& f) {
+        const uint8_t r = a | v;
+        f = SZP_TABLE[r];
+        return r;
+    }
+
+    // ALU operation by its 3-bit opcode field: ADD ADC SUB SBC AND XOR OR CP
+    static uint8_t alu8(uint8_t operation, uint8_t a, uint8_t v, uint8_t& f) {
+        switch (operation & 7) {
+        case 0: return add8(a, v, 0, f);
+        case 1: return add8(a, v, f & FLAG_C, f);
+        case 2: return sub8(a, v, 0, f);
+        case 3: return sub8(a, v, f & FLAG_C, f);
+        case 4: return and8(a, v, f);
+        case 5: return xor8(a, v, f);
+        case 6: return or8(a, v, f);
+        default: cp8(a, v, f); return a;
+        }
+    }
+
+    static uint8_t inc8(uint8_t v, uint8_t& f) {
+        const uint8_t r = static_cast<uint8_t>(v + 1);
+        f = static_cast<uint8_t>((f & FLAG_C) | SZ_TABLE[r] | ((r & 0x0F) == 0 ? FLAG_H : 0) |
+                                 (r == 0x80 ? FLAG_P : 0));
+        return r;
+    }
+
+    static uint8_t dec8(uint8_t v, uint8_t& f) {
+        const uint8_t r = static_cast<uint8_t>(v - 1);
+        f = static_cast<uint8_t>((f & FLAG_C) | FLAG_N | SZ_TABLE[r] | ((v & 0x0F) == 0 ? FLAG_H : 0) |
+                                 (r == 0x7F ? FLAG_P : 0));
+        return r;
+    }
+
+    // ----- 16-BIT ARITHMETIC -----
+
+    static uint16_t add16(uint16_t a, uint16_t v, uint8_t& f) {
+        const uint32_t r = a + v;
+        f = static_cast<uint8_t>((f & (FLAG_S | FLAG_Z | FLAG_P)) | (((a ^ v ^ r) >> 8) & FLAG_H) |
+                                 ((r >> 16) & FLAG_C) | ((r >> 8) & (FLAG_X | FLAG_Y)));
+        return static_cast<uint16_t>(r);
+    }
+
+    static uint16_t adc16(uint16_t a, uint16_t v, uint8_t& f) {
+        const uint32_t r = a + v + (f & FLAG_C);
+        f = static_cast<uint8_t>(((r >> 8) & (FLAG_S | FLAG_X | FLAG_Y)) | ((r & 0xFFFF) ? 0 : FLAG_Z) |
+                                 (((a ^ v ^ r) >> 8) & FLAG_H) |
+                                 (((a ^ ~v) & (a ^ r) & 0x8000) >> 13) | ((r >> 16) & FLAG_C));
+        return static_cast<uint16_t>(r);
+    }
+
+    static uint16_t sbc16(uint16_t a, uint16_t v, uint8_t& f) {
+        const uint32_t r = a - v - (f & FLAG_C);
+        f = static_cast<uint8_t>(FLAG_N | ((r >> 8) & (FLAG_S | FLAG_X | FLAG_Y)) |
+                                 ((r & 0xFFFF) ? 0 : FLAG_Z) | (((a ^ v ^ r) >> 8) & FLAG_H) |
+                                 (((a ^ v) & (a ^ r) & 0x8000) >> 13) | ((r >> 16) & FLAG_C));
+        return static_cast<uint16_t>(r);
+    }
+
+    // ----- ROTATES AND SHIFTS -----
+
+    // Accumulator rotates keep S, Z and P
+    static uint8_t rlca(uint8_t a, uint8_t& f) {
+        const uint8_t r = static_cast<uint8_t>((a << 1) | (a >> 7));
+        f = static_cast<uint8_t>((f & (FLAG_S | FLAG_Z | FLAG_P)) | (r & (FLAG_X | FLAG_Y)) | (a >> 7));
+        return r;
+    }
+
+    static uint8_t rrca(uint8_t a, uint8_t& f) {
+        const uint8_t r = static_cast<uint8_t>((a >> 1) | (a << 7));
+        f = static_cast<uint8_t>((f & (FLAG_S | FLAG_Z | FLAG_P)) | (r & (FLAG_X | FLAG_Y)) | (a & 1));
+        return r;
+    }
+
+    static uint8_t rla(uint8_t a, uint8_t& f) {
+        const uint8_t r = static_cast<uint8_t>((a << 1) | (f & FLAG_C));
+        f = static_cast<uint8_t>((f & (FLAG_S | FLAG_Z | FLAG_P)) | (r & (FLAG_X | FLAG_Y)) | (a >> 7));
+        return r;
+    }
+
+    static uint8_t rra(uint8_t a, uint8_t& f) {
+        const uint8_t r = static_cast<uint8_t>((a >> 1) | ((f & FLAG_C) << 7));
+        f = static_cast<uint8_t>((f & (FLAG_S | FLAG_Z | FLAG_P)) | (r & (FLAG_X | FLAG_Y)) | (a & 1));
+        return r;
+    }
+
+    // CB rotate/shift by its 3-bit opcode field: RLC RRC RL RR SLA SRA SLL SRL
+    static uint8_t shift8(uint8_t operation, uint8_t v, uint8_t& f) {
+        uint8_t r = 0;
+        uint8_t carry = 0;
+
+        switch (operation & 7) {
+        case 0: r = static_cast<uint8_t>((v << 1) | (v >> 7)); carry = v >> 7; break;
+        case 1: r = static_cast<uint8_t>((v >> 1) | (v << 7)); carry = v & 1; break;
+        case 2: r = static_cast<uint8_t>((v << 1) | (f & FLAG_C)); carry = v >> 7; break;
+        case 3: r = static_cast<uint8_t>((v >> 1) | ((f & FLAG_C) << 7)); carry = v & 1; break;
+        case 4: r = static_cast<uint8_t>(v << 1); carry = v >> 7; break;
+        case 5: r = static_cast<uint8_t>((v >> 1) | (v & 0x80)); carry = v & 1; break;
+        case 6: r = static_cast<uint8_t>((v << 1) | 1); carry = v >> 7; break;
+        default: r = static_cast<uint8_t>(v >> 1); carry = v & 1; break;
+        }
+
+        f = SZP_TABLE[r] | carry;
+        return r;
+    }
+
+    static void bit(uint8_t n, uint8_t v, uint8_t& f) {
+        const uint8_t tested = v & (1 << n);
+        f = static_cast<uint8_t>((f & FLAG_C) | FLAG_H | (v & (FLAG_X | FLAG_Y)) |
+                                 (tested ? (tested & FLAG_S) : (FLAG_Z | FLAG_P)));
+    }
+
+    // ----- MISC -----
+
+    static uint8_t daa(uint8_t a, uint8_t& f) {
+        uint8_t correction = 0;
+        uint8_t carry = f & FLAG_C;
+
+        if ((f & FLAG_H) || (a & 0x0F) > 9)
+            correction |= 0x06;
+        if (carry || a > 0x99) {
+            correction |= 0x60;
+            carry = FLAG_C;
+        }
+
+        const uint8_t r = (f & FLAG_N) ? static_cast<uint8_t>(a - correction)
+                                       : static_cast<uint8_t>(a + correction);
+        f = static_cast<uint8_t>(SZP_TABLE[r] | (f & FLAG_N) | ((a ^ r) & FLAG_H) | carry);
+        return r;
+    }
+
+    static uint8_t cpl(uint8_t a, uint8_t& f) {
+        const uint8_t r = static_cast<uint8_t>(~a);
+        f = static_cast<uint8_t>((f & (FLAG_S | FLAG_Z | FLAG_P | FLAG_C)) | FLAG_H | FLAG_N |
+                                 (r & (FLAG_X | FLAG_Y)));
+        return r;
+    }
+
+    static void scf(uint8_t a, uint8_t& f) {
+        f = static_cast<uint8_t>((f & (FLAG_S | FLAG_Z | FLAG_P)) | FLAG_C | (a & (FLAG_X | FLAG_Y)));
+    }
+
+    static void ccf(uint8_t a, uint8_t& f) {
+        f = static_cast<uint8_t>((f & (FLAG_S | FLAG_Z | FLAG_P)) | ((f & FLAG_C) ? FLAG_H : FLAG_C) |
+                                 (a & (FLAG_X | FLAG_Y)));
+    }
+
+    // Condition by its 3-bit opcode field: NZ Z NC C PO PE P M
+    static bool condition(uint8_t cc, uint8_t f) {
+        switch (cc & 7) {
+        case 0: return !(f & FLAG_Z);
+        case 1: return f & FLAG_Z;
+        case 2: return !(f & FLAG_C);
+        case 3: return f & FLAG_C;
+        case 4: return !(f & FLAG_P);
+        case 5: return f & FLAG_P;
+        case 6: return !(f & FLAG_S);
+        default: return f & FLAG_S;
+        }
+    }
+};
+
+
+#endif
@@ -0,0 +1,369 @@
+#include "Z80Analysis.hpp"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+
+static bool isInstructionStart(const Z80BasicBlock& block, uint16_t address) {
+    std::vector<Z80DecodedInstruction>::const_iterator it = std::lower_bound(
+        block.instructions.begin(), block.instructions.end(), address,
+        [](const Z80DecodedInstruction& inst, uint16_t value) { return inst.address < value; });
+    return it != block.instructions.end() && it->address == address;
+}
+
+
+static void addSuccessor(Z80BasicBlock& block, uint16_t address) {
+    if (std::find(block.successors.begin(), block.successors.end(), address) == block.successors.end())
+        block.successors.push_back(address);
+}
+
+
+Z80Analysis::Z80Analysis(std::vector<uint8_t> image, uint16_t base_address, Z80AnalysisOptions options)
+    : program(std::move(image)), base_address(base_address), analysis_options(std::move(options)) {}
+
+
+bool Z80Analysis::inImage(uint16_t address) const {
+    return static_cast<uint16_t>(address - base_address) < program.size();
+}
+
+
+bool Z80Analysis::isJumpTableRestart(uint8_t target) const {
+    const std::vector<uint8_t>& restarts = analysis_options.jump_table_restarts;
+    return std::find(restarts.begin(), restarts.end(), target) != restarts.end();
+}
+
+
+const Z80BasicBlock* Z80Analysis::blockAt(uint16_t address) const {
+    std::map<uint16_t, Z80BasicBlock>::const_iterator it = block_map.upper_bound(address);
+    if (it == block_map.begin())
+        return nullptr;
+    --it;
+
+    const Z80BasicBlock& block = it->second;
+    if (static_cast<uint16_t>(address - block.start) < static_cast<uint16_t>(block.end - block.start))
+        return &block;
+    return nullptr;
+}
+
+
+Z80BasicBlock* Z80Analysis::containingBlock(uint16_t address) {
+    return const_cast<Z80BasicBlock*>(std::as_const(*this).blockAt(address));
+}
+
+
+void Z80Analysis::analyze() {
+    block_map.clear();
+    jump_tables.clear();
+
+    discover(analysis_options.entry_points);
+    discoverInterruptHandlers();
+
+    touched_blocks.clear();
+    erased_blocks.clear();
+}
+
+
+void Z80Analysis::discover(std::vector<uint16_t> worklist) {
+    while (!worklist.empty()) {
+        const uint16_t address = worklist.back();
+        worklist.pop_back();
+
+        if (!inImage(address) || block_map.contains(address))
+            continue;
+
+        // A jump into the middle of a known block splits it instead of decoding again
+        if (splitAt(address))
+            continue;
+
+        decodeBlock(address, worklist);
+    }
+}
+
+
+std::vector<uint16_t> Z80Analysis::interruptHandlers() const {
+    std::vector<uint16_t> table_words = analysis_options.interrupt_vectors;
+
+    if (analysis_options.find_interrupt_vectors) {
+        std::set<uint8_t> i_values;
+        std::set<uint8_t> vectors;
+        for (const auto& [start, block] : block_map) {
+            for (size_t i = 1; i < block.instructions.size(); ++i) {
+                const Z80DecodedInstruction& load = block.instructions[i - 1];
+                const Z80DecodedInstruction& use = block.instructions[i];
+                if (load.prefix != Z80Prefix::None || load.opcode != 0x3E)
+                    continue;
+
+                if (use.prefix == Z80Prefix::ED && use.opcode == 0x47)
+                    i_values.insert(static_cast<uint8_t>(load.operand));
+                else if (use.prefix == Z80Prefix::None && use.opcode == 0xD3 &&
+                         static_cast<uint8_t>(use.operand) == analysis_options.interrupt_vector_port)
+                    vectors.insert(static_cast<uint8_t>(load.operand & 0xFE));
+            }
+        }
+        for (uint8_t i_value : i_values) {
+            for (uint8_t vector : vectors)
+                table_words.push_back(static_cast<uint16_t>((i_value << 8) | vector));
+        }
+    }
+
+    std::vector<uint16_t> handlers;
+    for (uint16_t word : table_words) {
+        if (!inImage(word) || !inImage(static_cast<uint16_t>(word + 1)))
+            continue;
+        const size_t offset = static_cast<uint16_t>(word - base_address);
+        const uint16_t handler = static_cast<uint16_t>(program[offset] | (program[offset + 1] << 8));
+        if (inImage(handler) && std::find(handlers.begin(), handlers.end(), handler) == handlers.end())
+            handlers.push_back(handler);
+    }
+    return handlers;
+}
+
+
+// Handlers can lead to more vector setup code, so this runs until nothing new is found
+void Z80Analysis::discoverInterruptHandlers() {
+    while (true) {
+        std::vector<uint16_t> pending = interruptHandlers();
+        std::erase_if(pending, [this](uint16_t address) { return block_map.contains(address); });
+
+        const size_t known = block_map.size();
+        discover(std::move(pending));
+        if (block_map.size() == known)
+            return;
+    }
+}
+
+
+void Z80Analysis::decodeBlock(uint16_t start, std::vector<uint16_t>& worklist) {
+    Z80BasicBlock block;
+    block.start = start;
+
+    uint16_t pc = start;
+    bool resolve_table = false;
+
+    while (true) {
+        // Stop when falling into code that is already known
+        if (pc != start) {
+            if (block_map.contains(pc) || splitAt(pc)) {
+                addSuccessor(block, pc);
+                break;
+            }
+        }
+
+        Z80DecodedInstruction inst;
+        if (!decodeZ80At(program, base_address, pc, inst))
+            break;
+
+        block.instructions.push_back(inst);
+        pc = inst.nextAddress();
+
+        if (inst.flow == Z80Flow::Next) {
+            if (!inImage(pc))
+                break;
+            continue;
+        }
+
+        switch (inst.flow) {
+        case Z80Flow::Jump:
+            addSuccessor(block, inst.target);
+            break;
+
+        case Z80Flow::JumpConditional:
+        case Z80Flow::Call:
+        case Z80Flow::CallConditional:
+            addSuccessor(block, inst.target);
+            addSuccessor(block, pc);
+            break;
+
+        case Z80Flow::Restart:
+            addSuccessor(block, inst.target);
+            if (isJumpTableRestart(static_cast<uint8_t>(inst.target)))
+                resolve_table = true;
+            else
+                addSuccessor(block, static_cast<uint16_t>(
+                    pc + analysis_options.restart_inline_bytes[inst.target >> 3]));
+            break;
+
+        case Z80Flow::ReturnConditional:
+        case Z80Flow::Halt:
+            addSuccessor(block, pc);
+            break;
+
+        default:
+            break;
+        }
+        break;
+    }
+
+    if (block.instructions.empty())
+        return;
+
+    block.end = block.last().nextAddress();
+    block.revision = next_revision++;
+
+    if (resolve_table)
+        resolveJumpTable(block.last().address, block);
+
+    std::erase_if(block.successors, [this](uint16_t address) { return !inImage(address); });
+    worklist.insert(worklist.end(), block.successors.begin(), block.successors.end());
+
+    touched_blocks.insert(start);
+    block_map.emplace(start, std::move(block));
+}
+
+
+bool Z80Analysis::splitAt(uint16_t address) {
+    Z80BasicBlock* head = containingBlock(address);
+    if (!head || head->start == address || !isInstructionStart(*head, address))
+        return false;
+
+    std::vector<Z80DecodedInstruction>::iterator split = std::find_if(
+        head->instructions.begin(), head->instructions.end(),
+        [address](const Z80DecodedInstruction& inst) { return inst.address == address; });
+
+    Z80BasicBlock tail;
+    tail.start = address;
+    tail.end = head->end;
+    tail.instructions.assign(split, head->instructions.end());
+    tail.successors = std::move(head->successors);
+    tail.revision = next_revision++;
+
+    head->instructions.erase(split, head->instructions.end());
+    head->end = address;
+    head->successors = { address };
+    head->revision = next_revision++;
+
+    touched_blocks.insert(head->start);
+    touched_blocks.insert(address);
+    block_map.emplace(address, std::move(tail));
+    return true;
+}
+
+
+/* Reads words after the RST until one of them cannot be a table entry:
+ * it points outside the image, at the reset vector, back into the table, or the
+ * table would run into the lowest handler that starts after it.
+ */
+void Z80Analysis::resolveJumpTable(uint16_t site, Z80BasicBlock& block) {
+    Z80JumpTable table;
+    table.site = site;
+    table.table_start = static_cast<uint16_t>(site + 1);
+
+    uint32_t limit = static_cast<uint32_t>(table.table_start) + analysis_options.max_jump_table_entries * 2;
+
+    for (size_t i = 0; i < analysis_options.max_jump_table_entries; ++i) {
+        const uint32_t entry_address = table.table_start + i * 2;
+        if (entry_address + 1 >= limit || !inImage(static_cast<uint16_t>(entry_address + 1)))
+            break;
+
+        const size_t offset = static_cast<uint16_t>(entry_address - base_address);
+        const uint16_t target = static_cast<uint16_t>(program[offset] | (program[offset + 1] << 8));
+
+        if (!inImage(target) || target == 0x0000)
+            break;
+        if (target >= table.table_start && target < entry_address + 2)
+            break;
+
+        if (target > table.table_start)
+            limit = std::min<uint32_t>(limit, target);
+
+        table.entries.push_back(target);
+        addSuccessor(block, target);
+    }
+
+    jump_tables[site] = std::move(table);
+}
+
+
+std::map<uint16_t, Z80BasicBlock>::iterator Z80Analysis::eraseBlock(std::map<uint16_t, Z80BasicBlock>::iterator it) {
+    if (!it->second.instructions.empty())
+        jump_tables.erase(it->second.last().address);
+
+    erased_blocks.insert(it->first);
+    return block_map.erase(it);
+}
+
+
+void Z80Analysis::removeUnreachable() {
+    std::set<uint16_t> reached;
+    std::vector<uint16_t> pending = interruptHandlers();
+    pending.insert(pending.end(), analysis_options.entry_points.begin(), analysis_options.entry_points.end());
+
+    while (!pending.empty()) {
+        const uint16_t address = pending.back();
+        pending.pop_back();
+
+        std::map<uint16_t, Z80BasicBlock>::const_iterator it = block_map.find(address);
+        if (it == block_map.end() || !reached.insert(address).second)
+            continue;
+
+        pending.insert(pending.end(), it->second.successors.begin(), it->second.successors.end());
+    }
+
+    for (std::map<uint16_t, Z80BasicBlock>::iterator it = block_map.begin(); it != block_map.end();) {
+        if (reached.contains(it->first))
+            ++it;
+        else
+            it = eraseBlock(it);
+    }
+}
+
+
+Z80PatchResult Z80Analysis::applyPatch(uint16_t address, std::span<const uint8_t> bytes) {
+    Z80PatchResult result;
+    touched_blocks.clear();
+    erased_blocks.clear();
+
+    const uint32_t low = static_cast<uint16_t>(address - base_address);
+    if (bytes.empty() || low >= program.size())
+        return result;
+
+    const uint32_t high = std::min<uint32_t>(low + static_cast<uint32_t>(bytes.size()),
+                                             static_cast<uint32_t>(program.size()));
+    std::copy(bytes.begin(), bytes.begin() + (high - low), program.begin() + low);
+
+    // ----- INVALIDATE -----
+    // A block depends on its own bytes and, for a dispatching RST, on its jump table
+    // plus the word right after it (which decided where the table stops).
+    std::vector<uint16_t> seeds;
+
+    for (std::map<uint16_t, Z80BasicBlock>::iterator it = block_map.begin(); it != block_map.end();) {
+        const Z80BasicBlock& block = it->second;
+        const uint32_t block_low = static_cast<uint16_t>(block.start - base_address);
+        const uint32_t block_high = block_low + static_cast<uint16_t>(block.end - block.start);
+
+        bool hit = block_low < high && block_high > low;
+
+        std::map<uint16_t, Z80JumpTable>::const_iterator table = jump_tables.find(block.last().address);
+        if (!hit && table != jump_tables.end()) {
+            const uint32_t table_low = static_cast<uint16_t>(table->second.table_start - base_address);
+            const uint32_t table_high = table_low + table->second.entries.size() * 2 + 2;
+            hit = table_low < high && table_high > low;
+        }
+
+        if (hit) {
+            seeds.push_back(block.start);
+            it = eraseBlock(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // ----- RE-DECODE -----
+    discover(std::move(seeds));
+    discoverInterruptHandlers();
+    removeUnreachable();
+
+    for (uint16_t start : touched_blocks) {
+        if (block_map.contains(start))
+            result.changed_blocks.push_back(start);
+    }
+    for (uint16_t start : erased_blocks) {
+        if (!block_map.contains(start))
+            result.removed_blocks.push_back(start);
+    }
+
+    touched_blocks.clear();
+    erased_blocks.clear();
+    return result;
+}
@@ -0,0 +1,118 @@
+#ifndef Z80_ANALYSIS_HPP
+#define Z80_ANALYSIS_HPP
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <span>
+#include <vector>
+#include "Z80Decoder.hpp"
+
+/* Z80Analysis owns a copy of the program image and the state derived from it:
+ * decoded instructions grouped into basic blocks, and the jump tables found after
+ * dispatching RSTs. Blocks are discovered by recursive descent from the entry points
+ * and from the IM 2 handlers: the table words named in the options, plus the ones the
+ * code selects with 'ld a,n / ld i,a' and 'ld a,n / out (port),a'.
+ *
+ * applyPatch() writes new bytes into the image and only re-decodes the blocks (and
+ * jump tables) that overlap the patched range. Blocks that become unreachable are
+ * dropped. The result lists which blocks have to be regenerated downstream.
+ */
+
+struct Z80BasicBlock {
+    uint16_t start = 0;
+    uint16_t end = 0;                                  // one past the last byte
+    std::vector<Z80DecodedInstruction> instructions;
+    std::vector<uint16_t> successors;                  // statically known next blocks
+    uint32_t revision = 0;                             // bumped when re-decoded or split
+
+    const Z80DecodedInstruction& last() const { return instructions.back(); }
+};
+
+
+struct Z80JumpTable {
+    uint16_t site = 0;                  // address of the dispatching RST
+    uint16_t table_start = 0;           // first entry, right after the RST
+    std::vector<uint16_t> entries;
+
+    uint16_t tableEnd() const { return static_cast<uint16_t>(table_start + entries.size() * 2); }
+};
+
+
+struct Z80AnalysisOptions {
+    std::vector<uint16_t> entry_points = { 0x0000, 0x0038, 0x0066 };     // reset, IM 1, NMI
+
+    // Addresses of IM 2 table words; the handlers they point at are entry points too
+    std::vector<uint16_t> interrupt_vectors;
+
+    // Port latching the IM 2 vector byte (Pac-Man: OUT (0),A); vectors set up in code are followed
+    bool find_interrupt_vectors = true;
+    uint8_t interrupt_vector_port = 0x00;
+
+    // RSTs whose handler indexes a word table stored right after the RST with A.
+    // Pac-Man's RST 20h is "pop hl; add a,a; rst 10h; ...; jp (hl)".
+    std::vector<uint8_t> jump_table_restarts = { 0x20 };
+
+    // Inline argument bytes skipped on return, indexed by RST number (RST 28h takes 2, RST 30h takes 3)
+    std::array<uint8_t, 8> restart_inline_bytes = { 0, 0, 0, 0, 0, 2, 3, 0 };
+
+    size_t max_jump_table_entries = 64;
+};
+
+
+struct Z80PatchResult {
+    std::vector<uint16_t> changed_blocks;   // new, re-decoded or split blocks
+    std::vector<uint16_t> removed_blocks;   // blocks that no longer exist
+};
+
+
+class Z80Analysis {
+    public:
+    Z80Analysis(std::vector<uint8_t> image, uint16_t base_address = 0x0000,
+                Z80AnalysisOptions options = {});
+
+    // Full analysis from the entry points; discards any previous state
+    void analyze();
+
+    // Writes 'bytes' at 'address' and re-analyses only what the bytes touch
+    Z80PatchResult applyPatch(uint16_t address, std::span<const uint8_t> bytes);
+
+    // Block containing 'address', or nullptr
+    const Z80BasicBlock* blockAt(uint16_t address) const;
+
+    // Handler addresses read from the IM 2 table words known so far
+    std::vector<uint16_t> interruptHandlers() const;
+
+    const std::map<uint16_t, Z80BasicBlock>& blocks() const { return block_map; }
+    const std::map<uint16_t, Z80JumpTable>& jumpTables() const { return jump_tables; }
+    const Z80AnalysisOptions& options() const { return analysis_options; }
+    std::span<const uint8_t> image() const { return program; }
+    uint16_t baseAddress() const { return base_address; }
+
+    private:
+    bool inImage(uint16_t address) const;
+    bool isJumpTableRestart(uint8_t target) const;
+    Z80BasicBlock* containingBlock(uint16_t address);
+    void discover(std::vector<uint16_t> worklist);
+    void discoverInterruptHandlers();
+    void decodeBlock(uint16_t start, std::vector<uint16_t>& worklist);
+    bool splitAt(uint16_t address);
+    void resolveJumpTable(uint16_t site, Z80BasicBlock& block);
+    void removeUnreachable();
+    std::map<uint16_t, Z80BasicBlock>::iterator eraseBlock(std::map<uint16_t, Z80BasicBlock>::iterator it);
+
+    std::vector<uint8_t> program;
+    uint16_t base_address;
+    Z80AnalysisOptions analysis_options;
+
+    std::map<uint16_t, Z80BasicBlock> block_map;
+    std::map<uint16_t, Z80JumpTable> jump_tables;   // keyed by site
+
+    std::set<uint16_t> touched_blocks;               // collected during one pass
+    std::set<uint16_t> erased_blocks;
+    uint32_t next_revision = 1;
+};
+
+
+#endif
@@ -0,0 +1,110 @@
+#include "Z80Classification.hpp"
+#include <algorithm>
+
+
+// This many 0xFF bytes in a row are unprogrammed EPROM, not table contents
+static constexpr size_t ERASED_FILL_RUN = 16;
+
+
+const char* byteClassName(ByteClass byte_class) {
+    switch (byte_class) {
+    case ByteClass::Code: return "code";
+    case ByteClass::Data: return "data";
+    case ByteClass::JumpTable: return "jump table";
+    default: return "unknown";
+    }
+}
+
+
+// A 16-bit operand used as an address of bytes, not as a branch target
+static bool isDataPointer(const Z80DecodedInstruction& inst) {
+    return inst.operand_size == 2 && !inst.has_target;
+}
+
+
+void Z80Classification::classify(const Z80Analysis& analysis) {
+    base_address = analysis.baseAddress();
+    image_size = analysis.image().size();
+    packed.assign((image_size + 3) / 4, 0);
+
+    auto offsetOf = [this](uint16_t address, size_t& offset) {
+        offset = static_cast<uint16_t>(address - base_address);
+        return offset < image_size;
+    };
+
+    // ----- CODE -----
+    std::vector<uint16_t> pointers;
+    for (const auto& [start, block] : analysis.blocks()) {
+        for (const Z80DecodedInstruction& inst : block.instructions) {
+            size_t offset = 0;
+            for (uint16_t i = 0; i < inst.length; ++i) {
+                if (offsetOf(static_cast<uint16_t>(inst.address + i), offset))
+                    set(offset, ByteClass::Code);
+            }
+            if (isDataPointer(inst))
+                pointers.push_back(inst.operand);
+        }
+    }
+
+    // ----- JUMP TABLES -----
+    for (const auto& [site, table] : analysis.jumpTables()) {
+        size_t offset = 0;
+        for (uint16_t address = table.table_start; address != table.tableEnd(); ++address) {
+            if (offsetOf(address, offset) && get(offset) == ByteClass::Unknown)
+                set(offset, ByteClass::JumpTable);
+        }
+    }
+
+    // ----- INLINE RST ARGUMENTS -----
+    const Z80AnalysisOptions& options = analysis.options();
+    for (const auto& [start, block] : analysis.blocks()) {
+        const Z80DecodedInstruction& last = block.last();
+        if (last.flow != Z80Flow::Restart)
+            continue;
+
+        const uint8_t inline_bytes = options.restart_inline_bytes[(last.target >> 3) & 7];
+        size_t offset = 0;
+        for (uint16_t i = 0; i < inline_bytes; ++i) {
+            if (offsetOf(static_cast<uint16_t>(last.nextAddress() + i), offset) && get(offset) == ByteClass::Unknown)
+                set(offset, ByteClass::Data);
+        }
+    }
+
+    // ----- POINTED-TO DATA -----
+    // Runs forward from each pointer until it meets code, a jump table, other data
+    // or a stretch of erased EPROM
+    std::span<const uint8_t> image = analysis.image();
+    auto isFill = [&](size_t offset) {
+        if (offset + ERASED_FILL_RUN > image_size)
+            return false;
+        return std::all_of(image.begin() + offset, image.begin() + offset + ERASED_FILL_RUN,
+                           [](uint8_t value) { return value == 0xFF; });
+    };
+
+    for (uint16_t pointer : pointers) {
+        size_t offset = 0;
+        if (!offsetOf(pointer, offset) || get(offset) == ByteClass::Code || get(offset) == ByteClass::JumpTable)
+            continue;
+
+        set(offset++, ByteClass::Data);
+        while (offset < image_size && get(offset) == ByteClass::Unknown && !isFill(offset))
+            set(offset++, ByteClass::Data);
+    }
+
+    counts.fill(0);
+    for (size_t offset = 0; offset < image_size; ++offset)
+        ++counts[static_cast<size_t>(get(offset))];
+}
+
+
+ByteClass Z80Classification::at(uint16_t address) const {
+    const size_t offset = static_cast<uint16_t>(address - base_address);
+    return offset < image_size ? get(offset) : ByteClass::Unknown;
+}
+
+
+void Z80Classification::set(size_t offset, ByteClass byte_class) {
+    const unsigned shift = (offset & 3) * 2;
+    packed[offset >> 2] = static_cast<uint8_t>((packed[offset >> 2] & ~(3u << shift)) |
+                                               (static_cast<unsigned>(byte_class) << shift));
+}
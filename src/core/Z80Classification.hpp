@@ -0,0 +1,67 @@
+#ifndef Z80_CLASSIFICATION_HPP
+#define Z80_CLASSIFICATION_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Z80Analysis.hpp"
+
+/* Z80Classification labels every byte of the program image as code, data,
+ * jump table or unknown, from a finished Z80Analysis:
+ *
+ *   code        bytes of instructions in reachable blocks
+ *   jump table  entries read after a dispatching RST
+ *   data        inline RST arguments, and bytes reached through constant
+ *               pointers (LD HL,nn / LD DE,nn / LD A,(nn) ...) that are not code;
+ *               such a region runs until the next code, jump table or erased fill
+ *   unknown     everything else: dead code, fill, data nobody points at
+ *
+ * The result is a packed bitmap, 2 bits per byte, so the whole 16 KB program
+ * fits in 4 KB. Only code bytes need to be emitted or recompiled.
+ */
+
+enum class ByteClass : uint8_t {
+    Unknown = 0,
+    Code = 1,
+    Data = 2,
+    JumpTable = 3
+};
+
+constexpr size_t BYTE_CLASS_COUNT = 4;
+
+const char* byteClassName(ByteClass byte_class);
+
+
+class Z80Classification {
+    public:
+    Z80Classification() = default;
+    explicit Z80Classification(const Z80Analysis& analysis) { classify(analysis); }
+
+    // Recomputes everything, e.g. after Z80Analysis::applyPatch()
+    void classify(const Z80Analysis& analysis);
+
+    ByteClass at(uint16_t address) const;
+    bool isCode(uint16_t address) const { return at(address) == ByteClass::Code; }
+
+    // Byte i of the image is (bitmap[i / 4] >> ((i % 4) * 2)) & 3, a ByteClass
+    std::span<const uint8_t> bitmap() const { return packed; }
+
+    size_t count(ByteClass byte_class) const { return counts[static_cast<size_t>(byte_class)]; }
+    uint16_t baseAddress() const { return base_address; }
+    size_t size() const { return image_size; }
+
+    private:
+    void set(size_t offset, ByteClass byte_class);
+    ByteClass get(size_t offset) const {
+        return static_cast<ByteClass>((packed[offset >> 2] >> ((offset & 3) * 2)) & 3);
+    }
+
+    std::vector<uint8_t> packed;
+    std::array<size_t, BYTE_CLASS_COUNT> counts{};
+    uint16_t base_address = 0;
+    size_t image_size = 0;
+};
+
+
+#endif
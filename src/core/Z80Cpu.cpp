@@ -0,0 +1,657 @@
+#include "Z80Cpu.hpp"
+#include <array>
+#include <utility>
+#include "Z80Alu.hpp"
+#include "Z80Timing.hpp"
+
+
+static constexpr uint8_t INTERRUPT_MODES[8] = { 0, 0, 1, 2, 0, 0, 1, 2 };
+
+
+Z80Cpu::Z80Cpu(MemoryBus& bus) : memory(bus) {}
+
+
+void Z80Cpu::reset() {
+    regs = Z80Registers{};
+    irq_line = false;
+    ei_delay = false;
+    total_cycles = 0;
+}
+
+
+int Z80Cpu::run(int cycles) {
+    int done = 0;
+    while (done < cycles) {
+        // Nothing can wake a halted CPU before the next interrupt, so skip ahead
+        if (regs.halted && !(irq_line && regs.iff1)) {
+            const int idle = (cycles - done + 3) & ~3;
+            regs.r = static_cast<uint8_t>((regs.r & 0x80) | ((regs.r + idle / 4) & 0x7F));
+            total_cycles += idle;
+            done += idle;
+            break;
+        }
+        done += step();
+    }
+    return done;
+}
+
+
+int Z80Cpu::step() {
+    if (interruptPending()) {
+        const int cycles = acceptInterrupt();
+        total_cycles += cycles;
+        return cycles;
+    }
+
+    if (regs.halted) {
+        ei_delay = false;
+        bumpR();
+        total_cycles += 4;
+        return 4;
+    }
+
+    return executeInstruction();
+}
+
+
+int Z80Cpu::executeInstruction() {
+    int cycles = 0;
+    ei_delay = false;
+
+    const uint8_t op = fetch8();
+    bumpR();
+
+    switch (op) {
+    case 0xCB:
+        cycles = executeCb();
+        break;
+    case 0xED:
+        cycles = executeEd();
+        break;
+    case 0xDD:
+    case 0xFD: {
+        const Index index = (op == 0xDD) ? Index::IX : Index::IY;
+        const uint8_t next = fetch8();
+        bumpR();
+
+        if (next == 0xCB) {
+            cycles = executeIndexedCb(index);
+        }
+        else if (next == 0xDD || next == 0xFD || next == 0xED) {
+            // The first prefix acts as a NOP; the next one starts a new instruction
+            --regs.pc;
+            cycles = 4;
+        }
+        else {
+            cycles = executeMain(next, index);
+        }
+        break;
+    }
+    default:
+        cycles = executeMain(op, Index::HL);
+        break;
+    }
+
+    total_cycles += cycles;
+    return cycles;
+}
+
+
+int Z80Cpu::acceptInterrupt() {
+    irq_line = false;
+    regs.halted = false;
+    regs.iff1 = regs.iff2 = false;
+    bumpR();
+    push16(regs.pc);
+
+    switch (regs.interrupt_mode) {
+    case 2:
+        regs.pc = memory.read16(static_cast<uint16_t>((regs.i << 8) | interrupt_data));
+        return 19;
+    case 1:
+        regs.pc = 0x0038;
+        return 13;
+    default:
+        // Mode 0 executes the data bus; boards put an RST there
+        regs.pc = interrupt_data & 0x38;
+        return 13;
+    }
+}
+
+
+// ----- REGISTER ACCESS -----
+
+uint16_t Z80Cpu::indexReg(Index index) const {
+    switch (index) {
+    case Index::IX: return regs.ix;
+    case Index::IY: return regs.iy;
+    default: return regs.hl();
+    }
+}
+
+
+void Z80Cpu::setIndexReg(Index index, uint16_t value) {
+    switch (index) {
+    case Index::IX: regs.ix = value; break;
+    case Index::IY: regs.iy = value; break;
+    default: regs.setHl(value); break;
+    }
+}
+
+
+// r: B C D E H L - A; with an index prefix H and L are the halves of IX/IY
+uint8_t Z80Cpu::reg8(uint8_t r, Index index) const {
+    switch (r) {
+    case 0: return regs.b;
+    case 1: return regs.c;
+    case 2: return regs.d;
+    case 3: return regs.e;
+    case 4: return static_cast<uint8_t>(indexReg(index) >> 8);
+    case 5: return static_cast<uint8_t>(indexReg(index));
+    default: return regs.a;
+    }
+}
+
+
+void Z80Cpu::setReg8(uint8_t r, Index index, uint8_t value) {
+    switch (r) {
+    case 0: regs.b = value; break;
+    case 1: regs.c = value; break;
+    case 2: regs.d = value; break;
+    case 3: regs.e = value; break;
+    case 4: setIndexReg(index, static_cast<uint16_t>((indexReg(index) & 0x00FF) | (value << 8))); break;
+    case 5: setIndexReg(index, static_cast<uint16_t>((indexReg(index) & 0xFF00) | value)); break;
+    default: regs.a = value; break;
+    }
+}
+
+
+uint16_t Z80Cpu::regPair(uint8_t p, Index index) const {
+    switch (p) {
+    case 0: return regs.bc();
+    case 1: return regs.de();
+    case 2: return indexReg(index);
+    default: return regs.sp;
+    }
+}
+
+
+void Z80Cpu::setRegPair(uint8_t p, Index index, uint16_t value) {
+    switch (p) {
+    case 0: regs.setBc(value); break;
+    case 1: regs.setDe(value); break;
+    case 2: setIndexReg(index, value); break;
+    default: regs.sp = value; break;
+    }
+}
+
+
+uint16_t Z80Cpu::memoryOperand(Index index) {
+    if (index == Index::HL)
+        return regs.hl();
+    const int8_t displacement = static_cast<int8_t>(fetch8());
+    return static_cast<uint16_t>(indexReg(index) + displacement);
+}
+
+
+// ----- UNPREFIXED / DD / FD -----
+
+int Z80Cpu::executeMain(uint8_t op, Index index) {
+    const uint8_t x = op >> 6;
+    const uint8_t y = (op >> 3) & 7;
+    const uint8_t z = op & 7;
+    const uint8_t p = y >> 1;
+    const uint8_t q = y & 1;
+    const bool indexed = index != Index::HL;
+
+    int cycles = Z80_MAIN_CYCLES[op] + (indexed ? 4 : 0);
+    uint8_t& f = regs.f;
+
+    switch (x) {
+    case 1:
+        // ----- LD r,r' / HALT -----
+        if (op == 0x76) {
+            regs.halted = true;
+        }
+        else if (z == 6) {
+            // LD H,(IX+d) loads the real H, not IXH
+            setReg8(y, Index::HL, memory.read8(memoryOperand(index)));
+            cycles += indexed ? 8 : 0;
+        }
+        else if (y == 6) {
+            memory.write8(memoryOperand(index), reg8(z, Index::HL));
+            cycles += indexed ? 8 : 0;
+        }
+        else {
+            setReg8(y, index, reg8(z, index));
+        }
+        return cycles;
+
+    case 2: {
+        // ----- ALU A,r -----
+        uint8_t value = 0;
+        if (z == 6) {
+            value = memory.read8(memoryOperand(index));
+            cycles += indexed ? 8 : 0;
+        }
+        else {
+            value = reg8(z, index);
+        }
+        regs.a = Z80Alu::alu8(y, regs.a, value, f);
+        return cycles;
+    }
+
+    case 0:
+        switch (z) {
+        case 0:
+            if (y == 0)
+                return cycles;
+            if (y == 1) {
+                std::swap(regs.a, regs.alt_a);
+                std::swap(regs.f, regs.alt_f);
+                return cycles;
+            }
+            {
+                const int8_t displacement = static_cast<int8_t>(fetch8());
+                bool taken = true;
+                if (y == 2)
+                    taken = --regs.b != 0;
+                else if (y >= 4)
+                    taken = Z80Alu::condition(y - 4, f);
+
+                if (taken) {
+                    regs.pc = static_cast<uint16_t>(regs.pc + displacement);
+                    cycles += (y == 3) ? 0 : 5;
+                }
+            }
+            return cycles;
+
+        case 1:
+            if (q == 0)
+                setRegPair(p, index, fetch16());
+            else
+                setIndexReg(index, Z80Alu::add16(indexReg(index), regPair(p, index), f));
+            return cycles;
+
+        case 2:
+            switch (y) {
+            case 0: memory.write8(regs.bc(), regs.a); break;
+            case 1: regs.a = memory.read8(regs.bc()); break;
+            case 2: memory.write8(regs.de(), regs.a); break;
+            case 3: regs.a = memory.read8(regs.de()); break;
+            case 4: memory.write16(fetch16(), indexReg(index)); break;
+            case 5: setIndexReg(index, memory.read16(fetch16())); break;
+            case 6: memory.write8(fetch16(), regs.a); break;
+            default: regs.a = memory.read8(fetch16()); break;
+            }
+            return cycles;
+
+        case 3:
+            setRegPair(p, index, static_cast<uint16_t>(regPair(p, index) + (q ? -1 : 1)));
+            return cycles;
+
+        case 4:
+        case 5:
+            if (y == 6) {
+                const uint16_t address = memoryOperand(index);
+                const uint8_t value = memory.read8(address);
+                memory.write8(address, z == 4 ? Z80Alu::inc8(value, f) : Z80Alu::dec8(value, f));
+                cycles += indexed ? 8 : 0;
+            }
+            else {
+                const uint8_t value = reg8(y, index);
+                setReg8(y, index, z == 4 ? Z80Alu::inc8(value, f) : Z80Alu::dec8(value, f));
+            }
+            return cycles;
+
+        case 6:
+            if (y == 6) {
+                const uint16_t address = memoryOperand(index);
+                memory.write8(address, fetch8());
+                cycles += indexed ? 5 : 0;
+            }
+            else {
+                setReg8(y, index, fetch8());
+            }
+            return cycles;
+
+        default:
+            switch (y) {
+            case 0: regs.a = Z80Alu::rlca(regs.a, f); break;
+            case 1: regs.a = Z80Alu::rrca(regs.a, f); break;
+            case 2: regs.a = Z80Alu::rla(regs.a, f); break;
+            case 3: regs.a = Z80Alu::rra(regs.a, f); break;
+            case 4: regs.a = Z80Alu::daa(regs.a, f); break;
+            case 5: regs.a = Z80Alu::cpl(regs.a, f); break;
+            case 6: Z80Alu::scf(regs.a, f); break;
+            default: Z80Alu::ccf(regs.a, f); break;
+            }
+            return cycles;
+        }
+
+    default:
+        switch (z) {
+        case 0:
+            if (Z80Alu::condition(y, f)) {
+                regs.pc = pop16();
+                cycles += 6;
+            }
+            return cycles;
+
+        case 1:
+            if (q == 0) {
+                const uint16_t value = pop16();
+                if (p == 3)
+                    regs.setAf(value);
+                else
+                    setRegPair(p, index, value);
+                return cycles;
+            }
+            switch (p) {
+            case 0:
+                regs.pc = pop16();
+                break;
+            case 1:
+                std::swap(regs.b, regs.alt_b);
+                std::swap(regs.c, regs.alt_c);
+                std::swap(regs.d, regs.alt_d);
+                std::swap(regs.e, regs.alt_e);
+                std::swap(regs.h, regs.alt_h);
+                std::swap(regs.l, regs.alt_l);
+                break;
+            case 2:
+                regs.pc = indexReg(index);
+                break;
+            default:
+                regs.sp = indexReg(index);
+                break;
+            }
+            return cycles;
+
+        case 2: {
+            const uint16_t target = fetch16();
+            if (Z80Alu::condition(y, f))
+                regs.pc = target;
+            return cycles;
+        }
+
+        case 3:
+            switch (y) {
+            case 0:
+                regs.pc = fetch16();
+                break;
+            case 2: {
+                const uint8_t port = fetch8();
+                memory.out(static_cast<uint16_t>((regs.a << 8) | port), regs.a);
+                break;
+            }
+            case 3: {
+                const uint8_t port = fetch8();
+                regs.a = memory.in(static_cast<uint16_t>((regs.a << 8) | port));
+                break;
+            }
+            case 4: {
+                const uint16_t value = memory.read16(regs.sp);
+                memory.write16(regs.sp, indexReg(index));
+                setIndexReg(index, value);
+                break;
+            }
+            case 5: {
+                // EX DE,HL ignores index prefixes
+                const uint16_t de = regs.de();
+                regs.setDe(regs.hl());
+                regs.setHl(de);
+                break;
+            }
+            case 6:
+                regs.iff1 = regs.iff2 = false;
+                break;
+            case 7:
+                regs.iff1 = regs.iff2 = true;
+                ei_delay = true;
+                break;
+            default:
+                break;
+            }
+            return cycles;
+
+        case 4: {
+            const uint16_t target = fetch16();
+            if (Z80Alu::condition(y, f)) {
+                push16(regs.pc);
+                regs.pc = target;
+                cycles += 7;
+            }
+            return cycles;
+        }
+
+        case 5:
+            if (q == 0) {
+                push16(p == 3 ? regs.af() : regPair(p, index));
+            }
+            else {
+                const uint16_t target = fetch16();
+                push16(regs.pc);
+                regs.pc = target;
+            }
+            return cycles;
+
+        case 6:
+            regs.a = Z80Alu::alu8(y, regs.a, fetch8(), f);
+            return cycles;
+
+        default:
+            push16(regs.pc);
+            regs.pc = static_cast<uint16_t>(y * 8);
+            return cycles;
+        }
+    }
+}
+
+
+// ----- CB -----
+
+int Z80Cpu::executeCb() {
+    const uint8_t op = fetch8();
+    bumpR();
+
+    const uint8_t x = op >> 6;
+    const uint8_t y = (op >> 3) & 7;
+    const uint8_t z = op & 7;
+
+    const bool memory_operand = z == 6;
+    const uint8_t value = memory_operand ? memory.read8(regs.hl()) : reg8(z, Index::HL);
+    uint8_t result = value;
+
+    switch (x) {
+    case 0: result = Z80Alu::shift8(y, value, regs.f); break;
+    case 1:
+        Z80Alu::bit(y, value, regs.f);
+        return memory_operand ? 12 : 8;
+    case 2: result = static_cast<uint8_t>(value & ~(1 << y)); break;
+    default: result = static_cast<uint8_t>(value | (1 << y)); break;
+    }
+
+    if (memory_operand) {
+        memory.write8(regs.hl(), result);
+        return 15;
+    }
+    setReg8(z, Index::HL, result);
+    return 8;
+}
+
+
+// DD CB d op / FD CB d op; results also land in a register unless z is 6
+int Z80Cpu::executeIndexedCb(Index index) {
+    const uint16_t address = memoryOperand(index);
+    const uint8_t op = fetch8();
+
+    const uint8_t x = op >> 6;
+    const uint8_t y = (op >> 3) & 7;
+    const uint8_t z = op & 7;
+
+    const uint8_t value = memory.read8(address);
+    uint8_t result = value;
+
+    switch (x) {
+    case 0: result = Z80Alu::shift8(y, value, regs.f); break;
+    case 1:
+        Z80Alu::bit(y, value, regs.f);
+        return 20;
+    case 2: result = static_cast<uint8_t>(value & ~(1 << y)); break;
+    default: result = static_cast<uint8_t>(value | (1 << y)); break;
+    }
+
+    memory.write8(address, result);
+    if (z != 6)
+        setReg8(z, Index::HL, result);
+    return 23;
+}
+
+
+// ----- ED -----
+
+int Z80Cpu::executeEd() {
+    const uint8_t op = fetch8();
+    bumpR();
+
+    const uint8_t x = op >> 6;
+    const uint8_t y = (op >> 3) & 7;
+    const uint8_t z = op & 7;
+    const uint8_t p = y >> 1;
+    const uint8_t q = y & 1;
+    uint8_t& f = regs.f;
+
+    if (x == 1) {
+        switch (z) {
+        case 0: {
+            const uint8_t value = memory.in(regs.bc());
+            if (y != 6)
+                setReg8(y, Index::HL, value);
+            f = static_cast<uint8_t>((f & Z80Alu::FLAG_C) | Z80Alu::SZP_TABLE[value]);
+            return 12;
+        }
+        case 1:
+            memory.out(regs.bc(), y == 6 ? 0 : reg8(y, Index::HL));
+            return 12;
+        case 2:
+            regs.setHl(q ? Z80Alu::adc16(regs.hl(), regPair(p, Index::HL), f)
+                         : Z80Alu::sbc16(regs.hl(), regPair(p, Index::HL), f));
+            return 15;
+        case 3: {
+            const uint16_t address = fetch16();
+            if (q)
+                setRegPair(p, Index::HL, memory.read16(address));
+            else
+                memory.write16(address, regPair(p, Index::HL));
+            return 20;
+        }
+        case 4:
+            regs.a = Z80Alu::sub8(0, regs.a, 0, f);
+            return 8;
+        case 5:
+            // RETN and RETI both restore IFF1 from IFF2
+            regs.pc = pop16();
+            regs.iff1 = regs.iff2;
+            return 14;
+        case 6:
+            regs.interrupt_mode = INTERRUPT_MODES[y];
+            return 8;
+        default:
+            switch (y) {
+            case 0: regs.i = regs.a; return 9;
+            case 1: regs.r = regs.a; return 9;
+            case 2:
+            case 3:
+                regs.a = (y == 2) ? regs.i : regs.r;
+                f = static_cast<uint8_t>((f & Z80Alu::FLAG_C) | Z80Alu::SZ_TABLE[regs.a] |
+                                         (regs.iff2 ? Z80Alu::FLAG_P : 0));
+                return 9;
+            case 4:
+            case 5: {
+                const uint8_t value = memory.read8(regs.hl());
+                if (y == 4) {
+                    memory.write8(regs.hl(), static_cast<uint8_t>((regs.a << 4) | (value >> 4)));
+                    regs.a = static_cast<uint8_t>((regs.a & 0xF0) | (value & 0x0F));
+                }
+                else {
+                    memory.write8(regs.hl(), static_cast<uint8_t>((value << 4) | (regs.a & 0x0F)));
+                    regs.a = static_cast<uint8_t>((regs.a & 0xF0) | (value >> 4));
+                }
+                f = static_cast<uint8_t>((f & Z80Alu::FLAG_C) | Z80Alu::SZP_TABLE[regs.a]);
+                return 18;
+            }
+            default:
+                return 8;
+            }
+        }
+    }
+
+    if (x != 2 || z > 3 || y < 4)
+        return 8;
+
+    // ----- BLOCK INSTRUCTIONS -----
+    const bool repeat = y >= 6;
+    const int16_t delta = (y & 1) ? -1 : 1;
+
+    switch (z) {
+    case 0: {
+        const uint8_t value = memory.read8(regs.hl());
+        memory.write8(regs.de(), value);
+        regs.setHl(static_cast<uint16_t>(regs.hl() + delta));
+        regs.setDe(static_cast<uint16_t>(regs.de() + delta));
+        regs.setBc(static_cast<uint16_t>(regs.bc() - 1));
+
+        const uint8_t n = static_cast<uint8_t>(value + regs.a);
+        f = static_cast<uint8_t>((f & (Z80Alu::FLAG_S | Z80Alu::FLAG_Z | Z80Alu::FLAG_C)) |
+                                 (regs.bc() ? Z80Alu::FLAG_P : 0) | (n & Z80Alu::FLAG_X) |
+                                 ((n << 4) & Z80Alu::FLAG_Y));
+        if (repeat && regs.bc()) {
+            regs.pc -= 2;
+            return 21;
+        }
+        return 16;
+    }
+    case 1: {
+        const uint8_t value = memory.read8(regs.hl());
+        const uint8_t result = static_cast<uint8_t>(regs.a - value);
+        regs.setHl(static_cast<uint16_t>(regs.hl() + delta));
+        regs.setBc(static_cast<uint16_t>(regs.bc() - 1));
+
+        const uint8_t half = (regs.a ^ value ^ result) & Z80Alu::FLAG_H;
+        const uint8_t n = static_cast<uint8_t>(result - (half ? 1 : 0));
+        f = static_cast<uint8_t>((f & Z80Alu::FLAG_C) | Z80Alu::FLAG_N |
+                                 (Z80Alu::SZ_TABLE[result] & (Z80Alu::FLAG_S | Z80Alu::FLAG_Z)) | half |
+                                 (regs.bc() ? Z80Alu::FLAG_P : 0) | (n & Z80Alu::FLAG_X) |
+                                 ((n << 4) & Z80Alu::FLAG_Y));
+        if (repeat && regs.bc() && result != 0) {
+            regs.pc -= 2;
+            return 21;
+        }
+        return 16;
+    }
+    case 2: {
+        memory.write8(regs.hl(), memory.in(regs.bc()));
+        regs.setHl(static_cast<uint16_t>(regs.hl() + delta));
+        --regs.b;
+        f = static_cast<uint8_t>(Z80Alu::SZ_TABLE[regs.b] | Z80Alu::FLAG_N);
+        if (repeat && regs.b) {
+            regs.pc -= 2;
+            return 21;
+        }
+        return 16;
+    }
+    default: {
+        const uint8_t value = memory.read8(regs.hl());
+        --regs.b;
+        memory.out(regs.bc(), value);
+        regs.setHl(static_cast<uint16_t>(regs.hl() + delta));
+        f = static_cast<uint8_t>(Z80Alu::SZ_TABLE[regs.b] | Z80Alu::FLAG_N);
+        if (repeat && regs.b) {
+            regs.pc -= 2;
+            return 21;
+        }
+        return 16;
+    }
+    }
+}
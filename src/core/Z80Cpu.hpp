@@ -0,0 +1,104 @@
+#ifndef Z80_CPU_HPP
+#define Z80_CPU_HPP
+
+#include <cstdint>
+#include "MemoryBus.hpp"
+
+/* Z80Cpu is the reference interpreter. It executes one instruction per step()
+ * against a MemoryBus and counts T-states, which is what the machine uses to
+ * pace frames. A raised IRQ line is held until the CPU acknowledges the
+ * interrupt, then released.
+ */
+
+struct Z80Registers {
+    uint8_t a = 0xFF, f = 0xFF;
+    uint8_t b = 0, c = 0, d = 0, e = 0, h = 0, l = 0;
+    uint8_t alt_a = 0xFF, alt_f = 0xFF;
+    uint8_t alt_b = 0, alt_c = 0, alt_d = 0, alt_e = 0, alt_h = 0, alt_l = 0;
+    uint16_t ix = 0xFFFF, iy = 0xFFFF, sp = 0xFFFF, pc = 0x0000;
+    uint8_t i = 0, r = 0;
+    uint8_t interrupt_mode = 0;
+    bool iff1 = false, iff2 = false;
+    bool halted = false;
+
+    uint16_t af() const { return static_cast<uint16_t>((a << 8) | f); }
+    uint16_t bc() const { return static_cast<uint16_t>((b << 8) | c); }
+    uint16_t de() const { return static_cast<uint16_t>((d << 8) | e); }
+    uint16_t hl() const { return static_cast<uint16_t>((h << 8) | l); }
+    void setAf(uint16_t v) { a = static_cast<uint8_t>(v >> 8); f = static_cast<uint8_t>(v); }
+    void setBc(uint16_t v) { b = static_cast<uint8_t>(v >> 8); c = static_cast<uint8_t>(v); }
+    void setDe(uint16_t v) { d = static_cast<uint8_t>(v >> 8); e = static_cast<uint8_t>(v); }
+    void setHl(uint16_t v) { h = static_cast<uint8_t>(v >> 8); l = static_cast<uint8_t>(v); }
+};
+
+
+class Z80Cpu {
+    public:
+    explicit Z80Cpu(MemoryBus& bus);
+
+    void reset();
+
+    // Executes one instruction, or accepts a pending interrupt; returns T-states
+    int step();
+
+    // Executes the instruction at PC, without looking at interrupts or HALT;
+    // this is the interpreter fallback for generated code
+    int executeInstruction();
+
+    // Generated code calls this once an instruction has run after an interpreted EI
+    void endInterruptDelay() { ei_delay = false; }
+
+    // True between an EI and the instruction after it, which runs before any interrupt
+    bool interruptDelayed() const { return ei_delay; }
+
+    // Steps until at least 'cycles' T-states have run; returns the T-states used
+    int run(int cycles);
+
+    // Maskable interrupt; the data byte is what the board puts on the bus during acknowledge
+    void setIrqLine(bool asserted) { irq_line = asserted; }
+    void setInterruptData(uint8_t data) { interrupt_data = data; }
+    bool irqLine() const { return irq_line; }
+
+    // True when the next step() accepts an interrupt instead of executing at PC
+    bool interruptPending() const { return irq_line && regs.iff1 && !ei_delay; }
+
+    MemoryBus& bus() { return memory; }
+
+    Z80Registers regs;
+    uint64_t total_cycles = 0;
+
+    private:
+    enum class Index : uint8_t { HL, IX, IY };
+
+    uint8_t fetch8() { return memory.read8(regs.pc++); }
+    uint16_t fetch16() {
+        const uint16_t value = memory.read16(regs.pc);
+        regs.pc += 2;
+        return value;
+    }
+    void bumpR() { regs.r = static_cast<uint8_t>((regs.r & 0x80) | ((regs.r + 1) & 0x7F)); }
+    void push16(uint16_t value) { regs.sp -= 2; memory.write16(regs.sp, value); }
+    uint16_t pop16() { const uint16_t value = memory.read16(regs.sp); regs.sp += 2; return value; }
+
+    uint16_t indexReg(Index index) const;
+    void setIndexReg(Index index, uint16_t value);
+    uint8_t reg8(uint8_t r, Index index) const;
+    void setReg8(uint8_t r, Index index, uint8_t value);
+    uint16_t regPair(uint8_t p, Index index) const;      // BC DE HL SP
+    void setRegPair(uint8_t p, Index index, uint16_t value);
+    uint16_t memoryOperand(Index index);                  // (HL) or (IX+d) with d fetched
+
+    int acceptInterrupt();
+    int executeMain(uint8_t op, Index index);
+    int executeCb();
+    int executeIndexedCb(Index index);
+    int executeEd();
+
+    MemoryBus& memory;
+    bool irq_line = false;
+    bool ei_delay = false;
+    uint8_t interrupt_data = 0xFF;
+};
+
+
+#endif
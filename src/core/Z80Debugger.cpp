@@ -0,0 +1,248 @@
+#include "Z80Debugger.hpp"
+#include <algorithm>
+#include <iomanip>
+#include "Z80Decoder.hpp"
+
+
+Z80Debugger::Z80Debugger(Z80Cpu& cpu) : cpu(cpu), bus(cpu.bus()) {
+    watcher_slot = bus.attachWatcher(this);
+}
+
+
+Z80Debugger::~Z80Debugger() {
+    bus.detachWatcher(watcher_slot);
+}
+
+
+// ----- BREAKPOINTS -----
+
+void Z80Debugger::addBreakpoint(uint16_t pc) {
+    if (!breakpoints.test(pc)) {
+        breakpoints.set(pc);
+        ++breakpoint_count;
+    }
+}
+
+
+void Z80Debugger::removeBreakpoint(uint16_t pc) {
+    if (breakpoints.test(pc)) {
+        breakpoints.reset(pc);
+        --breakpoint_count;
+    }
+}
+
+
+void Z80Debugger::clearBreakpoints() {
+    breakpoints.reset();
+    breakpoint_count = 0;
+}
+
+
+// ----- WATCHPOINTS -----
+
+void Z80Debugger::addWatchpoint(uint16_t start, uint16_t length, uint8_t access) {
+    if (length == 0 || !(access & (BUS_READ | BUS_WRITE)))
+        return;
+
+    refreshBackingPages();
+    watches.push_back({ backingAddress(start), length, access });
+    retrapPages();
+}
+
+
+void Z80Debugger::removeWatchpoint(uint16_t start) {
+    refreshBackingPages();
+    const uint16_t backing_start = backingAddress(start);
+    std::erase_if(watches, [backing_start](const Watchpoint& w) { return w.start == backing_start; });
+    retrapPages();
+}
+
+
+void Z80Debugger::clearWatchpoints() {
+    watches.clear();
+    retrapPages();
+}
+
+
+// Mirrors share one backing store; every page maps to the lowest page that shares it
+void Z80Debugger::refreshBackingPages() {
+    for (size_t page = 0; page < MemoryBus::PAGE_COUNT; ++page) {
+        backing_page[page] = static_cast<uint8_t>(page);
+        const uint8_t* data = bus.pageData(static_cast<uint8_t>(page));
+        for (size_t first = 0; data && first < page; ++first) {
+            if (bus.pageData(static_cast<uint8_t>(first)) == data) {
+                backing_page[page] = static_cast<uint8_t>(first);
+                break;
+            }
+        }
+    }
+}
+
+
+uint16_t Z80Debugger::backingAddress(uint16_t address) const {
+    return static_cast<uint16_t>((backing_page[address >> MemoryBus::PAGE_SHIFT] << MemoryBus::PAGE_SHIFT) |
+                                 (address & (MemoryBus::PAGE_SIZE - 1)));
+}
+
+
+// Traps exactly the pages some watchpoint covers, and their mirrors, for the accesses it watches
+void Z80Debugger::retrapPages() {
+    refreshBackingPages();
+
+    std::array<uint8_t, MemoryBus::PAGE_COUNT> wanted{};     // by backing page
+    for (const Watchpoint& w : watches) {
+        const uint32_t last = std::min<uint32_t>(w.start + w.length - 1u, 0xFFFF);
+        for (uint32_t page = w.start >> MemoryBus::PAGE_SHIFT; page <= (last >> MemoryBus::PAGE_SHIFT); ++page)
+            wanted[backing_page[page]] |= w.access;
+    }
+
+    for (size_t page = 0; page < MemoryBus::PAGE_COUNT; ++page) {
+        const uint8_t access = wanted[backing_page[page]];
+        bus.releasePage(watcher_slot, static_cast<uint8_t>(page), static_cast<uint8_t>(~access));
+        if (access)
+            bus.trapPage(watcher_slot, static_cast<uint8_t>(page), access);
+    }
+}
+
+
+void Z80Debugger::onRead(uint16_t address, uint8_t value) {
+    checkWatch(address, value, BUS_READ);
+}
+
+
+void Z80Debugger::onWrite(uint16_t address, uint8_t value) {
+    checkWatch(address, value, BUS_WRITE);
+}
+
+
+void Z80Debugger::checkWatch(uint16_t address, uint8_t value, uint8_t access) {
+    // Keep the first hit of an instruction; it stops once the instruction completes
+    if (pending_watch.reason != DebugStopReason::None)
+        return;
+
+    const uint16_t backing = backingAddress(address);
+    for (const Watchpoint& w : watches) {
+        if ((w.access & access) && w.contains(backing)) {
+            pending_watch = { DebugStopReason::Watchpoint, 0, address, value, access };
+            return;
+        }
+    }
+}
+
+
+// ----- TRACE -----
+
+void Z80Debugger::setTraceDepth(size_t depth) {
+    trace.assign(depth, TraceEntry{});
+    clearTrace();
+}
+
+
+const TraceEntry& Z80Debugger::traceEntry(size_t index) const {
+    const size_t oldest = (trace_head + trace.size() - trace_count) % trace.size();
+    return trace[(oldest + index) % trace.size()];
+}
+
+
+void Z80Debugger::record() {
+    TraceEntry& entry = trace[trace_head];
+    const Z80Registers& regs = cpu.regs;
+
+    entry.pc = regs.pc;
+    for (size_t i = 0; i < entry.bytes.size(); ++i)
+        entry.bytes[i] = bus.peek8(static_cast<uint16_t>(regs.pc + i));
+    entry.af = regs.af();
+    entry.bc = regs.bc();
+    entry.de = regs.de();
+    entry.hl = regs.hl();
+    entry.sp = regs.sp;
+    entry.cycle = cpu.total_cycles;
+
+    trace_head = (trace_head + 1) % trace.size();
+    trace_count = std::min(trace_count + 1, trace.size());
+}
+
+
+void Z80Debugger::writeTrace(std::ostream& out, const SymbolTable* symbols) const {
+    const std::ios_base::fmtflags flags = out.flags();
+    const char fill = out.fill();
+
+    for (size_t i = 0; i < trace_count; ++i) {
+        const TraceEntry& entry = traceEntry(i);
+
+        out << std::hex << std::setfill('0') << std::setw(4) << entry.pc;
+        if (symbols) {
+            out << " <";
+            if (!symbols->formatAddress(out, entry.pc))
+                out << "?";
+            out << ">";
+        }
+        out << ": ";
+
+        Z80DecodedInstruction inst;
+        if (decodeZ80At(entry.bytes, entry.pc, entry.pc, inst))
+            formatZ80Instruction(out, inst);
+        else
+            out << "??";
+
+        out << std::hex << std::setfill('0')
+            << "  AF=" << std::setw(4) << entry.af << " BC=" << std::setw(4) << entry.bc
+            << " DE=" << std::setw(4) << entry.de << " HL=" << std::setw(4) << entry.hl
+            << " SP=" << std::setw(4) << entry.sp << std::dec << "  @" << entry.cycle << "\n";
+    }
+
+    out.flags(flags);
+    out.fill(fill);
+}
+
+
+// ----- EXECUTION -----
+
+int Z80Debugger::run(int cycles) {
+    stop = {};
+    int done = 0;
+
+    while (done < cycles) {
+        // Breakpoints and the trace only look at real instruction fetches,
+        // not at interrupt acknowledges or at a CPU idling in HALT
+        const bool fetching = !cpu.regs.halted && !cpu.interruptPending();
+
+        if (fetching) {
+            if (breakpoints.test(cpu.regs.pc) && !resume_over_breakpoint) {
+                stop = { DebugStopReason::Breakpoint, cpu.regs.pc };
+                resume_over_breakpoint = true;
+                return done;
+            }
+            if (!trace.empty())
+                record();
+        }
+
+        resume_over_breakpoint = false;
+        done += cpu.step();
+
+        if (pending_watch.reason != DebugStopReason::None) {
+            stop = pending_watch;
+            stop.pc = cpu.regs.pc;
+            pending_watch = {};
+            return done;
+        }
+    }
+    return done;
+}
+
+
+int Z80Debugger::stepInstruction() {
+    stop = {};
+    if (!trace.empty() && !cpu.regs.halted && !cpu.interruptPending())
+        record();
+
+    const int cycles = cpu.step();
+    resume_over_breakpoint = false;
+
+    if (pending_watch.reason != DebugStopReason::None) {
+        stop = pending_watch;
+        stop.pc = cpu.regs.pc;
+        pending_watch = {};
+    }
+    return cycles;
+}
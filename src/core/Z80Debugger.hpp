@@ -0,0 +1,128 @@
+#ifndef Z80_DEBUGGER_HPP
+#define Z80_DEBUGGER_HPP
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "MemoryBus.hpp"
+#include "SymbolTable.hpp"
+#include "Z80Cpu.hpp"
+
+/* Z80Debugger is the backend for PC breakpoints, memory watchpoints and an
+ * instruction trace.
+ *
+ * It only costs something while armed(). Until then the machine keeps calling
+ * Z80Cpu::run() directly, and no bus page is trapped. Once armed, frames run
+ * through run() here, one instruction at a time, so breakpoints and the trace
+ * see every PC. Watchpoints trap only the pages they cover; every other page
+ * keeps its fast pointer. A watchpoint covers every mirror of its addresses
+ * (Pac-Man RAM at 0x4000 is also seen at 0xC000): pages are matched through
+ * their backing store, and watches are kept at the lowest mirror.
+ *
+ * The trace is a fixed ring of the last N instructions. Each entry keeps the
+ * instruction bytes as they were when executed, so it can be rendered with
+ * the disassembler tables later even if the code has been overwritten since.
+ */
+
+enum class DebugStopReason : uint8_t {
+    None,
+    Breakpoint,
+    Watchpoint
+};
+
+struct DebugStop {
+    DebugStopReason reason = DebugStopReason::None;
+    uint16_t pc = 0;             // next instruction to execute
+    uint16_t address = 0;        // watchpoint: accessed address
+    uint8_t value = 0;           // watchpoint: value read or written
+    uint8_t access = 0;          // watchpoint: BUS_READ or BUS_WRITE
+};
+
+struct Watchpoint {
+    uint16_t start = 0;
+    uint16_t length = 1;
+    uint8_t access = BUS_WRITE;
+
+    bool contains(uint16_t address) const { return static_cast<uint16_t>(address - start) < length; }
+};
+
+struct TraceEntry {
+    uint16_t pc = 0;
+    std::array<uint8_t, 4> bytes{};
+    uint16_t af = 0, bc = 0, de = 0, hl = 0, sp = 0;
+    uint64_t cycle = 0;
+};
+
+
+class Z80Debugger : private BusWatcher {
+    public:
+    explicit Z80Debugger(Z80Cpu& cpu);
+    ~Z80Debugger() override;
+
+    Z80Debugger(const Z80Debugger&) = delete;
+    Z80Debugger& operator=(const Z80Debugger&) = delete;
+
+    // ----- BREAKPOINTS -----
+    void addBreakpoint(uint16_t pc);
+    void removeBreakpoint(uint16_t pc);
+    void clearBreakpoints();
+    bool hasBreakpoint(uint16_t pc) const { return breakpoints.test(pc); }
+
+    // ----- WATCHPOINTS -----
+    void addWatchpoint(uint16_t start, uint16_t length, uint8_t access = BUS_WRITE);
+    void removeWatchpoint(uint16_t start);
+    void clearWatchpoints();
+    const std::vector<Watchpoint>& watchpoints() const { return watches; }
+
+    // ----- TRACE -----
+    // Keeps the last 'depth' instructions; 0 turns tracing off
+    void setTraceDepth(size_t depth);
+    size_t traceSize() const { return trace_count; }
+    const TraceEntry& traceEntry(size_t index) const;     // 0 = oldest
+    void clearTrace() { trace_head = 0; trace_count = 0; }
+    void writeTrace(std::ostream& out, const SymbolTable* symbols = nullptr) const;
+
+    // ----- EXECUTION -----
+    bool armed() const { return breakpoint_count > 0 || !watches.empty() || !trace.empty(); }
+
+    // Runs like Z80Cpu::run() but stops before a breakpoint or after a watched access.
+    // Returns the T-states used; lastStop() tells why it returned early.
+    int run(int cycles);
+
+    // Executes exactly one instruction, ignoring breakpoints
+    int stepInstruction();
+
+    const DebugStop& lastStop() const { return stop; }
+
+    private:
+    void onRead(uint16_t address, uint8_t value) override;
+    void onWrite(uint16_t address, uint8_t value) override;
+    void checkWatch(uint16_t address, uint8_t value, uint8_t access);
+    void retrapPages();
+    void refreshBackingPages();
+    uint16_t backingAddress(uint16_t address) const;
+    void record();
+
+    Z80Cpu& cpu;
+    MemoryBus& bus;
+    int watcher_slot = -1;
+
+    std::bitset<0x10000> breakpoints;
+    size_t breakpoint_count = 0;
+    bool resume_over_breakpoint = false;
+
+    std::vector<Watchpoint> watches;                 // start at the lowest mirror
+    DebugStop pending_watch;
+    std::array<uint8_t, MemoryBus::PAGE_COUNT> backing_page{};     // lowest page sharing the same store
+
+    std::vector<TraceEntry> trace;
+    size_t trace_head = 0;
+    size_t trace_count = 0;
+
+    DebugStop stop;
+};
+
+
+#endif
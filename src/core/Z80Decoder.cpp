@@ -0,0 +1,195 @@
+#include "Z80Decoder.hpp"
+#include <iomanip>
+#include <string_view>
+
+
+// Opcodes in the IX/IY tables that address memory through (IX+d)/(IY+d)
+static bool usesIndexDisplacement(uint8_t opcode) {
+    if (opcode == 0x34 || opcode == 0x35 || opcode == 0x36)
+        return true;
+    if (opcode == 0x76)
+        return false;
+    if (opcode >= 0x40 && opcode <= 0x7F)
+        return (opcode & 0x07) == 0x06 || (opcode & 0xF8) == 0x70;
+    if (opcode >= 0x80 && opcode <= 0xBF)
+        return (opcode & 0x07) == 0x06;
+    return false;
+}
+
+
+static void classifyFlow(Z80DecodedInstruction& inst) {
+    const uint8_t op = inst.opcode;
+
+    switch (inst.prefix) {
+    case Z80Prefix::None:
+        if (op == 0xC3) {
+            inst.flow = Z80Flow::Jump;
+            inst.target = inst.operand;
+        }
+        else if ((op & 0xC7) == 0xC2) {
+            inst.flow = Z80Flow::JumpConditional;
+            inst.target = inst.operand;
+        }
+        else if (op == 0x18 || op == 0x10 || op == 0x20 || op == 0x28 || op == 0x30 || op == 0x38) {
+            inst.flow = (op == 0x18) ? Z80Flow::Jump : Z80Flow::JumpConditional;
+            inst.target = static_cast<uint16_t>(inst.nextAddress() + static_cast<int8_t>(inst.operand));
+        }
+        else if (op == 0xCD) {
+            inst.flow = Z80Flow::Call;
+            inst.target = inst.operand;
+        }
+        else if ((op & 0xC7) == 0xC4) {
+            inst.flow = Z80Flow::CallConditional;
+            inst.target = inst.operand;
+        }
+        else if ((op & 0xC7) == 0xC7) {
+            inst.flow = Z80Flow::Restart;
+            inst.target = op & 0x38;
+        }
+        else if (op == 0xC9) {
+            inst.flow = Z80Flow::Return;
+            return;
+        }
+        else if ((op & 0xC7) == 0xC0) {
+            inst.flow = Z80Flow::ReturnConditional;
+            return;
+        }
+        else if (op == 0xE9) {
+            inst.flow = Z80Flow::JumpIndirect;
+            return;
+        }
+        else if (op == 0x76) {
+            inst.flow = Z80Flow::Halt;
+            return;
+        }
+        else {
+            return;
+        }
+        inst.has_target = true;
+        return;
+
+    case Z80Prefix::ED:
+        if (op == 0x45 || op == 0x4D)
+            inst.flow = Z80Flow::Return;
+        return;
+
+    case Z80Prefix::DD:
+    case Z80Prefix::FD:
+        if (op == 0xE9)
+            inst.flow = Z80Flow::JumpIndirect;
+        return;
+
+    default:
+        return;
+    }
+}
+
+
+bool decodeZ80At(std::span<const uint8_t> code, uint16_t base_address, uint16_t address,
+                 Z80DecodedInstruction& out) {
+    const size_t offset = static_cast<uint16_t>(address - base_address);
+    if (offset >= code.size())
+        return false;
+
+    const size_t available = code.size() - offset;
+    const uint8_t* bytes = code.data() + offset;
+
+    out = Z80DecodedInstruction{};
+    out.address = address;
+
+    size_t prefix_bytes = 0;
+    const Z80Instruction* table = MAIN_INSTRUCTION_TABLE;
+
+    // ----- PREFIX CHECK -----
+    switch (bytes[0]) {
+    case 0xCB: table = BIT_INSTRUCTION_TABLE;  out.prefix = Z80Prefix::CB; prefix_bytes = 1; break;
+    case 0xDD: table = IX_INSTRUCTION_TABLE;   out.prefix = Z80Prefix::DD; prefix_bytes = 1; break;
+    case 0xED: table = MISC_INSTRUCTION_TABLE; out.prefix = Z80Prefix::ED; prefix_bytes = 1; break;
+    case 0xFD: table = IY_INSTRUCTION_TABLE;   out.prefix = Z80Prefix::FD; prefix_bytes = 1; break;
+    default: break;
+    }
+
+    if (available <= prefix_bytes)
+        return false;
+
+    // DD CB d op / FD CB d op: the displacement comes before the final opcode byte
+    if ((out.prefix == Z80Prefix::DD || out.prefix == Z80Prefix::FD) && bytes[1] == 0xCB) {
+        if (available < 4)
+            return false;
+        out.prefix = (out.prefix == Z80Prefix::DD) ? Z80Prefix::DDCB : Z80Prefix::FDCB;
+        out.opcode = bytes[3];
+        out.info = &BIT_INSTRUCTION_TABLE[out.opcode];
+        out.displacement = static_cast<int8_t>(bytes[2]);
+        out.has_displacement = true;
+        out.length = 4;
+        return true;
+    }
+
+    out.opcode = bytes[prefix_bytes];
+    out.info = &table[out.opcode];
+
+    const size_t total_length = out.info->length + prefix_bytes;
+    if (total_length > available)
+        return false;
+    out.length = static_cast<uint8_t>(total_length);
+
+    // ----- HANDLE IMMEDIATES -----
+    const uint8_t* operands = bytes + prefix_bytes + 1;
+    size_t operand_bytes = out.info->length - 1;
+
+    if ((out.prefix == Z80Prefix::DD || out.prefix == Z80Prefix::FD) &&
+        operand_bytes > 0 && usesIndexDisplacement(out.opcode)) {
+        out.displacement = static_cast<int8_t>(operands[0]);
+        out.has_displacement = true;
+        ++operands;
+        --operand_bytes;
+    }
+
+    if (operand_bytes == 1) {
+        out.operand = operands[0];
+        out.operand_size = 1;
+    }
+    else if (operand_bytes == 2) {
+        out.operand = static_cast<uint16_t>(operands[0] | (operands[1] << 8));
+        out.operand_size = 2;
+    }
+
+    classifyFlow(out);
+    return true;
+}
+
+
+void formatZ80Instruction(std::ostream& out, const Z80DecodedInstruction& inst) {
+    std::string_view mnemonic = inst.info->mnemonic;
+
+    // The bit table only knows (HL); indexed bit operations print (IX+d)/(IY+d) instead
+    if (inst.prefix == Z80Prefix::DDCB || inst.prefix == Z80Prefix::FDCB) {
+        const size_t hl = mnemonic.find("(HL)");
+        if (hl != std::string_view::npos) {
+            out << mnemonic.substr(0, hl)
+                << (inst.prefix == Z80Prefix::DDCB ? "(IX+d)" : "(IY+d)")
+                << mnemonic.substr(hl + 4);
+        }
+        else {
+            out << mnemonic;
+        }
+    }
+    else {
+        out << mnemonic;
+    }
+
+    const std::ios_base::fmtflags flags = out.flags();
+    const char fill = out.fill('0');
+    out << std::hex;
+
+    if (inst.has_displacement)
+        out << " #" << std::setw(2) << static_cast<int>(static_cast<uint8_t>(inst.displacement));
+
+    if (inst.operand_size == 1)
+        out << " #" << std::setw(2) << static_cast<int>(inst.operand);
+    else if (inst.operand_size == 2)
+        out << " #" << std::setw(4) << inst.operand;
+
+    out.fill(fill);
+    out.flags(flags);
+}
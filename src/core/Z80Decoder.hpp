@@ -0,0 +1,140 @@
+#ifndef Z80_DECODER_HPP
+#define Z80_DECODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include "Z80InstructionTable.hpp"
+
+/* Z80Decoder turns raw bytes into instruction records without copying or allocating.
+ * The bytes are viewed through a std::span together with the address of its first byte,
+ * so a routine, a RAM window or a patched region can be decoded in place.
+ * decodeZ80At() decodes a single instruction at any PC; Z80DecodeView walks a range lazily.
+ */
+
+enum class Z80Prefix : uint8_t {
+    None,
+    CB,      // bit table
+    DD,      // IX table
+    ED,      // misc table
+    FD,      // IY table
+    DDCB,    // IX bit table: DD CB d op
+    FDCB     // IY bit table: FD CB d op
+};
+
+// How an instruction hands control to the next one
+enum class Z80Flow : uint8_t {
+    Next,                // falls through to address + length
+    Jump,                // JP nn, JR e
+    JumpConditional,     // JP cc,nn  JR cc,e  DJNZ e
+    JumpIndirect,        // JP (HL), JP (IX), JP (IY)
+    Call,                // CALL nn
+    CallConditional,     // CALL cc,nn
+    Restart,             // RST p
+    Return,              // RET, RETI, RETN
+    ReturnConditional,   // RET cc
+    Halt                 // HALT
+};
+
+struct Z80DecodedInstruction {
+    const Z80Instruction* info = nullptr;   // table entry holding the mnemonic
+    uint16_t address = 0;
+    uint16_t operand = 0;                    // immediate byte/word following the opcode
+    uint16_t target = 0;                     // branch destination when has_target is set
+    int8_t displacement = 0;                 // (IX+d)/(IY+d) offset
+    uint8_t opcode = 0;                      // opcode byte after any prefixes
+    uint8_t length = 0;                      // total bytes including prefixes
+    uint8_t operand_size = 0;                // 0, 1 or 2 immediate bytes
+    Z80Prefix prefix = Z80Prefix::None;
+    Z80Flow flow = Z80Flow::Next;
+    bool has_displacement = false;
+    bool has_target = false;
+
+    uint16_t nextAddress() const { return static_cast<uint16_t>(address + length); }
+    bool endsBlock() const { return flow != Z80Flow::Next; }
+};
+
+
+// Decodes the instruction at 'address'. 'code' holds the bytes starting at 'base_address'.
+// Returns false when the address is outside the span or the instruction runs past its end.
+bool decodeZ80At(std::span<const uint8_t> code, uint16_t base_address, uint16_t address,
+                 Z80DecodedInstruction& out);
+
+// Writes "MNEMONIC #operand" for a decoded instruction (no address, no newline)
+void formatZ80Instruction(std::ostream& out, const Z80DecodedInstruction& inst);
+
+
+class Z80DecodeIterator {
+    public:
+    using value_type = Z80DecodedInstruction;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    Z80DecodeIterator() = default;
+    Z80DecodeIterator(std::span<const uint8_t> code, uint16_t base_address, size_t offset)
+        : code(code), base_address(base_address), offset(offset) { decodeCurrent(); }
+
+    const Z80DecodedInstruction& operator*() const { return current; }
+    const Z80DecodedInstruction* operator->() const { return &current; }
+
+    Z80DecodeIterator& operator++() {
+        offset += current.length;
+        decodeCurrent();
+        return *this;
+    }
+
+    Z80DecodeIterator operator++(int) {
+        Z80DecodeIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    bool operator==(const Z80DecodeIterator& other) const {
+        return code.data() == other.code.data() && offset == other.offset && valid == other.valid;
+    }
+
+    bool operator==(std::default_sentinel_t) const { return !valid; }
+
+    private:
+    void decodeCurrent() {
+        valid = offset < code.size() &&
+                decodeZ80At(code, base_address, static_cast<uint16_t>(base_address + offset), current);
+    }
+
+    std::span<const uint8_t> code;
+    uint16_t base_address = 0;
+    size_t offset = 0;
+    bool valid = false;
+    Z80DecodedInstruction current;
+};
+
+
+// Linear sweep over a byte range; stops at the end of the span or at a truncated instruction
+class Z80DecodeView : public std::ranges::view_interface<Z80DecodeView> {
+    public:
+    Z80DecodeView() = default;
+    Z80DecodeView(std::span<const uint8_t> code, uint16_t base_address, uint16_t start_address)
+        : code(code), base_address(base_address),
+          start_offset(static_cast<uint16_t>(start_address - base_address)) {}
+    Z80DecodeView(std::span<const uint8_t> code, uint16_t base_address)
+        : Z80DecodeView(code, base_address, base_address) {}
+
+    Z80DecodeIterator begin() const { return {code, base_address, start_offset}; }
+    std::default_sentinel_t end() const { return std::default_sentinel; }
+
+    private:
+    std::span<const uint8_t> code;
+    uint16_t base_address = 0;
+    size_t start_offset = 0;
+};
+
+
+inline Z80DecodeView decodeZ80(std::span<const uint8_t> code, uint16_t base_address = 0x0000) {
+    return {code, base_address};
+}
+
+
+#endif
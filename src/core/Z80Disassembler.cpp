@@ -1,10 +1,10 @@
 #include "Z80Disassembler.hpp"
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <filesystem>
-#include <cstring>   // for std::strcmp
-#include "Z80InstructionTable.hpp"
+#include "Z80Decoder.hpp"
 
 
 std::vector<uint8_t> loadRomFile(const std::string& rom_path) {
@@ -32,98 +32,124 @@ std::vector<uint8_t> loadRomFile(const std::string& rom_path) {
 }
 
 
-void disassembleZ80(const std::vector<uint8_t>& code,
-                    const std::filesystem::path& output_asm)
-{
-    std::ofstream out(output_asm);
-
-    if (!out) {
-        std::cerr << "Failed to create asm file\n";
+static void writeLabel(std::ostream& out, uint16_t address, const SymbolTable* symbols) {
+    if (!symbols)
         return;
+
+    if (const Symbol* symbol = symbols->at(address)) {
+        out << "\n" << symbols->name(*symbol) << ":";
+        if (symbol->comment_length)
+            out << "    ; " << symbols->comment(*symbol);
+        out << "\n";
     }
+}
 
-    uint16_t pc = 0x0000;
-    size_t i = 0;
 
-    while (i < code.size()) {
+static void writeInstruction(std::ostream& out, const Z80DecodedInstruction& inst, const SymbolTable* symbols) {
+    // ----- PRINT LABEL -----
+    writeLabel(out, inst.address, symbols);
 
-        uint8_t opcode = code[i];
-        const Z80Instruction* inst = nullptr;
-        size_t prefix_bytes = 0;
+    // ----- PRINT ADDRESS -----
+    out << std::hex << std::setw(4) << std::setfill('0')
+        << inst.address << ": ";
 
-        const Z80Instruction& mainInst = MAIN_INSTRUCTION_TABLE[opcode];
+    // ----- PRINT MNEMONIC + IMMEDIATES -----
+    formatZ80Instruction(out, inst);
 
-        // ----- PREFIX CHECK -----
+    // ----- NAME BRANCH TARGET -----
+    if (symbols && inst.has_target && symbols->lookup(inst.target)) {
+        out << "    ; ";
+        symbols->formatAddress(out, inst.target);
+    }
 
-        if (opcode == 0xCB &&
-            std::strcmp(mainInst.mnemonic, "BIT TABLE") == 0)
-        {
-            if (i + 1 >= code.size()) break;
+    out << "\n";
+}
 
-            uint8_t next = code[i + 1];
-            inst = &BIT_INSTRUCTION_TABLE[next];
-            prefix_bytes = 1;
-        }
-        else if (opcode == 0xDD &&
-                 std::strcmp(mainInst.mnemonic, "IX TABLE") == 0)
-        {
-            if (i + 1 >= code.size()) break;
-
-            uint8_t next = code[i + 1];
-            inst = &IX_INSTRUCTION_TABLE[next];
-            prefix_bytes = 1;
-        }
-        else if (opcode == 0xED &&
-                 std::strcmp(mainInst.mnemonic, "MISC TABLE") == 0)
-        {
-            if (i + 1 >= code.size()) break;
-
-            uint8_t next = code[i + 1];
-            inst = &MISC_INSTRUCTION_TABLE[next];
-            prefix_bytes = 1;
-        }
-        else if (opcode == 0xFD &&
-                 std::strcmp(mainInst.mnemonic, "IY TABLE") == 0)
-        {
-            if (i + 1 >= code.size()) break;
-
-            uint8_t next = code[i + 1];
-            inst = &IY_INSTRUCTION_TABLE[next];
-            prefix_bytes = 1;
+
+void disassembleZ80(std::span<const uint8_t> code, uint16_t base_address, std::ostream& out,
+                    const SymbolTable* symbols) {
+    for (const Z80DecodedInstruction& inst : decodeZ80(code, base_address))
+        writeInstruction(out, inst, symbols);
+}
+
+
+// Writes the bytes in [begin, end) that are not part of any block, grouped by class
+static void writeNonCode(std::ostream& out, const Z80Analysis& analysis, const Z80Classification& classification,
+                         uint32_t begin, uint32_t end, const SymbolTable* symbols) {
+    std::span<const uint8_t> image = analysis.image();
+    const uint16_t base = analysis.baseAddress();
+
+    uint32_t address = begin;
+    while (address < end) {
+        const ByteClass byte_class = classification.at(static_cast<uint16_t>(address));
+        uint32_t run_end = address + 1;
+        while (run_end < end && classification.at(static_cast<uint16_t>(run_end)) == byte_class)
+            ++run_end;
+
+        if (byte_class == ByteClass::Unknown) {
+            out << std::hex << std::setfill('0') << "; " << std::setw(4) << address << "-" << std::setw(4)
+                << (run_end - 1) << " not referenced (" << std::dec << (run_end - address) << " bytes)\n";
+            address = run_end;
+            continue;
         }
-        else
-        {
-            inst = &mainInst;
+
+        // DW for jump table entries, DB rows of up to 8 bytes otherwise
+        const uint32_t step = byte_class == ByteClass::JumpTable ? 2 : 8;
+        for (uint32_t row = address; row < run_end; row += step) {
+            writeLabel(out, static_cast<uint16_t>(row), symbols);
+            out << std::hex << std::setw(4) << std::setfill('0') << row << ": ";
+
+            if (byte_class == ByteClass::JumpTable && row + 1 < run_end) {
+                const uint16_t entry = static_cast<uint16_t>(image[row - base] | (image[row + 1 - base] << 8));
+                out << "DW #" << std::setw(4) << entry;
+                if (symbols && symbols->lookup(entry)) {
+                    out << "    ; ";
+                    symbols->formatAddress(out, entry);
+                }
+            }
+            else {
+                out << "DB";
+                for (uint32_t i = row; i < std::min(row + step, run_end); ++i)
+                    out << (i == row ? " #" : ", #") << std::setw(2) << static_cast<int>(image[i - base]);
+            }
+            out << "\n";
         }
+        address = run_end;
+    }
+}
 
-        if (!inst) break;
 
-        // ----- PRINT ADDRESS -----
-        out << std::hex << std::setw(4) << std::setfill('0')
-            << pc << ": ";
+void disassembleReachable(const Z80Analysis& analysis, const Z80Classification& classification,
+                          std::ostream& out, const SymbolTable* symbols) {
+    uint32_t cursor = analysis.baseAddress();
 
-        // ----- PRINT MNEMONIC -----
-        out << inst->mnemonic;
+    for (const auto& [start, block] : analysis.blocks()) {
+        if (start > cursor)
+            writeNonCode(out, analysis, classification, cursor, start, symbols);
 
-        size_t total_length = inst->length + prefix_bytes;
+        for (const Z80DecodedInstruction& inst : block.instructions)
+            writeInstruction(out, inst, symbols);
+        cursor = std::max<uint32_t>(cursor, block.end);
+    }
 
-        // ----- HANDLE IMMEDIATES -----
-        if (inst->length == 2) {
-            uint8_t imm = code[i + 1 + prefix_bytes];
-            out << " #" << std::setw(2) << (int)imm;
-        }
-        else if (inst->length == 3) {
-            uint16_t imm =
-                code[i + 1 + prefix_bytes] |
-                (code[i + 2 + prefix_bytes] << 8);
-            out << " #" << std::setw(4) << imm;
-        }
+    const uint32_t image_end = analysis.baseAddress() + static_cast<uint32_t>(analysis.image().size());
+    if (cursor < image_end)
+        writeNonCode(out, analysis, classification, cursor, image_end, symbols);
+}
 
-        out << "\n";
 
-        i += total_length;
-        pc += total_length;
+void disassembleZ80(const std::vector<uint8_t>& code,
+                    const std::filesystem::path& output_asm,
+                    const SymbolTable* symbols)
+{
+    std::ofstream out(output_asm);
+
+    if (!out) {
+        std::cerr << "Failed to create asm file\n";
+        return;
     }
 
+    disassembleZ80(code, 0x0000, out, symbols);
+
     std::cout << "Disassembly written to " << output_asm << "\n";
 }
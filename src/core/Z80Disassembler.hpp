@@ -1,8 +1,14 @@
 #ifndef Z80_DISASSEMBLER_HPP
 #define Z80_DISASSEMBLER_HPP
 
+#include <cstdint>
 #include <vector>
+#include <span>
+#include <ostream>
 #include <filesystem>
+#include "SymbolTable.hpp"
+#include "Z80Analysis.hpp"
+#include "Z80Classification.hpp"
 
 
 std::vector<uint8_t> loadRomFile(const std::string& rom_path);
@@ -11,7 +17,20 @@ std::vector<uint8_t> loadRomFile(const std::string& rom_path);
 void changeInstructionTable(const std::vector<uint8_t>& code);
 
 
-void disassembleZ80(const std::vector<uint8_t>& code, const std::filesystem::path& output_asm);
+void disassembleZ80(const std::vector<uint8_t>& code, const std::filesystem::path& output_asm,
+                    const SymbolTable* symbols = nullptr);
+
+
+// Streams the disassembly of any byte range; 'base_address' is the address of code[0].
+// With symbols, labels and comments are written above their routines and branch targets are named.
+void disassembleZ80(std::span<const uint8_t> code, uint16_t base_address, std::ostream& out,
+                    const SymbolTable* symbols = nullptr);
+
+
+// Writes only the reachable code found by the analysis. Data and jump tables become
+// DB/DW lines; bytes nobody references are summarized as one comment per range.
+void disassembleReachable(const Z80Analysis& analysis, const Z80Classification& classification,
+                          std::ostream& out, const SymbolTable* symbols = nullptr);
 
 
 #endif
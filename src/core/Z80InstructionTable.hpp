@@ -420,100 +420,100 @@ static const Z80Instruction IY_INSTRUCTION_TABLE[256] = {
 
 static const Z80Instruction BIT_INSTRUCTION_TABLE[256] = {
     // 0x00
-    {"RLC B",2},{"RLC C",2},{"RLC D",2},{"RLC E",2},
-    {"RLC H",2},{"RLC L",2},{"RLC (HL)",2},{"RLC A",2},
-    {"RRC B",2},{"RRC C",2},{"RRC D",2},{"RRC E",2},
-    {"RRC H",2},{"RRC L",2},{"RRC (HL)",2},{"RRC A",2},
+    {"RLC B",1},{"RLC C",1},{"RLC D",1},{"RLC E",1},
+    {"RLC H",1},{"RLC L",1},{"RLC (HL)",1},{"RLC A",1},
+    {"RRC B",1},{"RRC C",1},{"RRC D",1},{"RRC E",1},
+    {"RRC H",1},{"RRC L",1},{"RRC (HL)",1},{"RRC A",1},
 
     // 0x10
-    {"RL B",2},{"RL C",2},{"RL D",2},{"RL E",2},
-    {"RL H",2},{"RL L",2},{"RL (HL)",2},{"RL A",2},
-    {"RR B",2},{"RR C",2},{"RR D",2},{"RR E",2},
-    {"RR H",2},{"RR L",2},{"RR (HL)",2},{"RR A",2},
+    {"RL B",1},{"RL C",1},{"RL D",1},{"RL E",1},
+    {"RL H",1},{"RL L",1},{"RL (HL)",1},{"RL A",1},
+    {"RR B",1},{"RR C",1},{"RR D",1},{"RR E",1},
+    {"RR H",1},{"RR L",1},{"RR (HL)",1},{"RR A",1},
 
     // 0x20
-    {"SLA B",2},{"SLA C",2},{"SLA D",2},{"SLA E",2},
-    {"SLA H",2},{"SLA L",2},{"SLA (HL)",2},{"SLA A",2},
-    {"SRA B",2},{"SRA C",2},{"SRA D",2},{"SRA E",2},
-    {"SRA H",2},{"SRA L",2},{"SRA (HL)",2},{"SRA A",2},
+    {"SLA B",1},{"SLA C",1},{"SLA D",1},{"SLA E",1},
+    {"SLA H",1},{"SLA L",1},{"SLA (HL)",1},{"SLA A",1},
+    {"SRA B",1},{"SRA C",1},{"SRA D",1},{"SRA E",1},
+    {"SRA H",1},{"SRA L",1},{"SRA (HL)",1},{"SRA A",1},
 
     // 0x30
     {"NOP",1},{"NOP",1},{"NOP",1},{"NOP",1},
     {"NOP",1},{"NOP",1},{"NOP",1},{"NOP",1},
-    {"SRL B",2},{"SRL C",2},{"SRL D",2},{"SRL E",2},
-    {"SRL H",2},{"SRL L",2},{"SRL (HL)",2},{"SRL A",2},
+    {"SRL B",1},{"SRL C",1},{"SRL D",1},{"SRL E",1},
+    {"SRL H",1},{"SRL L",1},{"SRL (HL)",1},{"SRL A",1},
 
     // 0x40
-    {"BIT 0,B",2},{"BIT 0,C",2},{"BIT 0,D",2},{"BIT 0,E",2},
-    {"BIT 0,H",2},{"BIT 0,L",2},{"BIT 0,(HL)",2},{"BIT 0,A",2},
-    {"BIT 1,B",2},{"BIT 1,C",2},{"BIT 1,D",2},{"BIT 1,E",2},
-    {"BIT 1,H",2},{"BIT 1,L",2},{"BIT 1,(HL)",2},{"BIT 1,A",2},
+    {"BIT 0,B",1},{"BIT 0,C",1},{"BIT 0,D",1},{"BIT 0,E",1},
+    {"BIT 0,H",1},{"BIT 0,L",1},{"BIT 0,(HL)",1},{"BIT 0,A",1},
+    {"BIT 1,B",1},{"BIT 1,C",1},{"BIT 1,D",1},{"BIT 1,E",1},
+    {"BIT 1,H",1},{"BIT 1,L",1},{"BIT 1,(HL)",1},{"BIT 1,A",1},
 
     // 0x50
-    {"BIT 2,B",2},{"BIT 2,C",2},{"BIT 2,D",2},{"BIT 2,E",2},
-    {"BIT 2,H",2},{"BIT 2,L",2},{"BIT 2,(HL)",2},{"BIT 2,A",2},
-    {"BIT 3,B",2},{"BIT 3,C",2},{"BIT 3,D",2},{"BIT 3,E",2},
-    {"BIT 3,H",2},{"BIT 3,L",2},{"BIT 3,(HL)",2},{"BIT 3,A",2},
+    {"BIT 2,B",1},{"BIT 2,C",1},{"BIT 2,D",1},{"BIT 2,E",1},
+    {"BIT 2,H",1},{"BIT 2,L",1},{"BIT 2,(HL)",1},{"BIT 2,A",1},
+    {"BIT 3,B",1},{"BIT 3,C",1},{"BIT 3,D",1},{"BIT 3,E",1},
+    {"BIT 3,H",1},{"BIT 3,L",1},{"BIT 3,(HL)",1},{"BIT 3,A",1},
 
     // 0x60
-    {"BIT 4,B",2},{"BIT 4,C",2},{"BIT 4,D",2},{"BIT 4,E",2},
-    {"BIT 4,H",2},{"BIT 4,L",2},{"BIT 4,(HL)",2},{"BIT 4,A",2},
-    {"BIT 5,B",2},{"BIT 5,C",2},{"BIT 5,D",2},{"BIT 5,E",2},
-    {"BIT 5,H",2},{"BIT 5,L",2},{"BIT 5,(HL)",2},{"BIT 5,A",2},
+    {"BIT 4,B",1},{"BIT 4,C",1},{"BIT 4,D",1},{"BIT 4,E",1},
+    {"BIT 4,H",1},{"BIT 4,L",1},{"BIT 4,(HL)",1},{"BIT 4,A",1},
+    {"BIT 5,B",1},{"BIT 5,C",1},{"BIT 5,D",1},{"BIT 5,E",1},
+    {"BIT 5,H",1},{"BIT 5,L",1},{"BIT 5,(HL)",1},{"BIT 5,A",1},
 
     // 0x70
-    {"BIT 6,B",2},{"BIT 6,C",2},{"BIT 6,D",2},{"BIT 6,E",2},
-    {"BIT 6,H",2},{"BIT 6,L",2},{"BIT 6,(HL)",2},{"BIT 6,A",2},
-    {"BIT 7,B",2},{"BIT 7,C",2},{"BIT 7,D",2},{"BIT 7,E",2},
-    {"BIT 7,H",2},{"BIT 7,L",2},{"BIT 7,(HL)",2},{"BIT 7,A",2},
+    {"BIT 6,B",1},{"BIT 6,C",1},{"BIT 6,D",1},{"BIT 6,E",1},
+    {"BIT 6,H",1},{"BIT 6,L",1},{"BIT 6,(HL)",1},{"BIT 6,A",1},
+    {"BIT 7,B",1},{"BIT 7,C",1},{"BIT 7,D",1},{"BIT 7,E",1},
+    {"BIT 7,H",1},{"BIT 7,L",1},{"BIT 7,(HL)",1},{"BIT 7,A",1},
 
     // 0x80
-    {"RES 0,B",2},{"RES 0,C",2},{"RES 0,D",2},{"RES 0,E",2},
-    {"RES 0,H",2},{"RES 0,L",2},{"RES 0,(HL)",2},{"RES 0,A",2},
-    {"RES 1,B",2},{"RES 1,C",2},{"RES 1,D",2},{"RES 1,E",2},
-    {"RES 1,H",2},{"RES 1,L",2},{"RES 1,(HL)",2},{"RES 1,A",2},
+    {"RES 0,B",1},{"RES 0,C",1},{"RES 0,D",1},{"RES 0,E",1},
+    {"RES 0,H",1},{"RES 0,L",1},{"RES 0,(HL)",1},{"RES 0,A",1},
+    {"RES 1,B",1},{"RES 1,C",1},{"RES 1,D",1},{"RES 1,E",1},
+    {"RES 1,H",1},{"RES 1,L",1},{"RES 1,(HL)",1},{"RES 1,A",1},
 
     // 0x90
-    {"RES 2,B",2},{"RES 2,C",2},{"RES 2,D",2},{"RES 2,E",2},
-    {"RES 2,H",2},{"RES 2,L",2},{"RES 2,(HL)",2},{"RES 2,A",2},
-    {"RES 3,B",2},{"RES 3,C",2},{"RES 3,D",2},{"RES 3,E",2},
-    {"RES 3,H",2},{"RES 3,L",2},{"RES 3,(HL)",2},{"RES 3,A",2},
+    {"RES 2,B",1},{"RES 2,C",1},{"RES 2,D",1},{"RES 2,E",1},
+    {"RES 2,H",1},{"RES 2,L",1},{"RES 2,(HL)",1},{"RES 2,A",1},
+    {"RES 3,B",1},{"RES 3,C",1},{"RES 3,D",1},{"RES 3,E",1},
+    {"RES 3,H",1},{"RES 3,L",1},{"RES 3,(HL)",1},{"RES 3,A",1},
 
     // 0xA0
-    {"RES 4,B",2},{"RES 4,C",2},{"RES 4,D",2},{"RES 4,E",2},
-    {"RES 4,H",2},{"RES 4,L",2},{"RES 4,(HL)",2},{"RES 4,A",2},
-    {"RES 5,B",2},{"RES 5,C",2},{"RES 5,D",2},{"RES 5,E",2},
-    {"RES 5,H",2},{"RES 5,L",2},{"RES 5,(HL)",2},{"RES 5,A",2},
+    {"RES 4,B",1},{"RES 4,C",1},{"RES 4,D",1},{"RES 4,E",1},
+    {"RES 4,H",1},{"RES 4,L",1},{"RES 4,(HL)",1},{"RES 4,A",1},
+    {"RES 5,B",1},{"RES 5,C",1},{"RES 5,D",1},{"RES 5,E",1},
+    {"RES 5,H",1},{"RES 5,L",1},{"RES 5,(HL)",1},{"RES 5,A",1},
 
     // 0xB0
-    {"RES 6,B",2},{"RES 6,C",2},{"RES 6,D",2},{"RES 6,E",2},
-    {"RES 6,H",2},{"RES 6,L",2},{"RES 6,(HL)",2},{"RES 6,A",2},
-    {"RES 7,B",2},{"RES 7,C",2},{"RES 7,D",2},{"RES 7,E",2},
-    {"RES 7,H",2},{"RES 7,L",2},{"RES 7,(HL)",2},{"RES 7,A",2},
+    {"RES 6,B",1},{"RES 6,C",1},{"RES 6,D",1},{"RES 6,E",1},
+    {"RES 6,H",1},{"RES 6,L",1},{"RES 6,(HL)",1},{"RES 6,A",1},
+    {"RES 7,B",1},{"RES 7,C",1},{"RES 7,D",1},{"RES 7,E",1},
+    {"RES 7,H",1},{"RES 7,L",1},{"RES 7,(HL)",1},{"RES 7,A",1},
 
     // 0xC0
-    {"SET 0,B",2},{"SET 0,C",2},{"SET 0,D",2},{"SET 0,E",2},
-    {"SET 0,H",2},{"SET 0,L",2},{"SET 0,(HL)",2},{"SET 0,A",2},
-    {"SET 1,B",2},{"SET 1,C",2},{"SET 1,D",2},{"SET 1,E",2},
-    {"SET 1,H",2},{"SET 1,L",2},{"SET 1,(HL)",2},{"SET 1,A",2},
+    {"SET 0,B",1},{"SET 0,C",1},{"SET 0,D",1},{"SET 0,E",1},
+    {"SET 0,H",1},{"SET 0,L",1},{"SET 0,(HL)",1},{"SET 0,A",1},
+    {"SET 1,B",1},{"SET 1,C",1},{"SET 1,D",1},{"SET 1,E",1},
+    {"SET 1,H",1},{"SET 1,L",1},{"SET 1,(HL)",1},{"SET 1,A",1},
 
     // 0xD0
-    {"SET 2,B",2},{"SET 2,C",2},{"SET 2,D",2},{"SET 2,E",2},
-    {"SET 2,H",2},{"SET 2,L",2},{"SET 2,(HL)",2},{"SET 2,A",2},
-    {"SET 3,B",2},{"SET 3,C",2},{"SET 3,D",2},{"SET 3,E",2},
-    {"SET 3,H",2},{"SET 3,L",2},{"SET 3,(HL)",2},{"SET 3,A",2},
+    {"SET 2,B",1},{"SET 2,C",1},{"SET 2,D",1},{"SET 2,E",1},
+    {"SET 2,H",1},{"SET 2,L",1},{"SET 2,(HL)",1},{"SET 2,A",1},
+    {"SET 3,B",1},{"SET 3,C",1},{"SET 3,D",1},{"SET 3,E",1},
+    {"SET 3,H",1},{"SET 3,L",1},{"SET 3,(HL)",1},{"SET 3,A",1},
 
     // 0xE0
-    {"SET 4,B",2},{"SET 4,C",2},{"SET 4,D",2},{"SET 4,E",2},
-    {"SET 4,H",2},{"SET 4,L",2},{"SET 4,(HL)",2},{"SET 4,A",2},
-    {"SET 5,B",2},{"SET 5,C",2},{"SET 5,D",2},{"SET 5,E",2},
-    {"SET 5,H",2},{"SET 5,L",2},{"SET 5,(HL)",2},{"SET 5,A",2},
+    {"SET 4,B",1},{"SET 4,C",1},{"SET 4,D",1},{"SET 4,E",1},
+    {"SET 4,H",1},{"SET 4,L",1},{"SET 4,(HL)",1},{"SET 4,A",1},
+    {"SET 5,B",1},{"SET 5,C",1},{"SET 5,D",1},{"SET 5,E",1},
+    {"SET 5,H",1},{"SET 5,L",1},{"SET 5,(HL)",1},{"SET 5,A",1},
 
     // 0xF0
-    {"SET 6,B",2},{"SET 6,C",2},{"SET 6,D",2},{"SET 6,E",2},
-    {"SET 6,H",2},{"SET 6,L",2},{"SET 6,(HL)",2},{"SET 6,A",2},
-    {"SET 7,B",2},{"SET 7,C",2},{"SET 7,D",2},{"SET 7,E",2},
-    {"SET 7,H",2},{"SET 7,L",2},{"SET 7,(HL)",2},{"SET 7,A",2}
+    {"SET 6,B",1},{"SET 6,C",1},{"SET 6,D",1},{"SET 6,E",1},
+    {"SET 6,H",1},{"SET 6,L",1},{"SET 6,(HL)",1},{"SET 6,A",1},
+    {"SET 7,B",1},{"SET 7,C",1},{"SET 7,D",1},{"SET 7,E",1},
+    {"SET 7,H",1},{"SET 7,L",1},{"SET 7,(HL)",1},{"SET 7,A",1}
 };
 
 
@@ -0,0 +1,48 @@
+#ifndef Z80_TIMING_HPP
+#define Z80_TIMING_HPP
+
+#include <array>
+#include <cstdint>
+
+/* Base T-states of unprefixed opcodes, shared by the interpreter and the code
+ * generator. Taken conditional branches add their extra cost on top:
+ * JR cc/DJNZ +5, CALL cc +7, RET cc +6. DD/FD add 4 (8 more with a displacement).
+ */
+
+constexpr std::array<uint8_t, 256> Z80_MAIN_CYCLES = [] {
+    constexpr uint8_t low[64] = {
+        4, 10,  7,  6,  4,  4,  7,  4,  4, 11,  7,  6,  4,  4,  7,  4,   // 0x00
+        8, 10,  7,  6,  4,  4,  7,  4, 12, 11,  7,  6,  4,  4,  7,  4,   // 0x10
+        7, 10, 16,  6,  4,  4,  7,  4,  7, 11, 16,  6,  4,  4,  7,  4,   // 0x20
+        7, 10, 13,  6, 11, 11, 10,  4,  7, 11, 13,  6,  4,  4,  7,  4    // 0x30
+    };
+    constexpr uint8_t high[64] = {
+        5, 10, 10, 10, 10, 11,  7, 11,  5, 10, 10,  0, 10, 17,  7, 11,   // 0xC0
+        5, 10, 10, 11, 10, 11,  7, 11,  5,  4, 10, 11, 10,  0,  7, 11,   // 0xD0
+        5, 10, 10, 19, 10, 11,  7, 11,  5,  4, 10,  4, 10,  0,  7, 11,   // 0xE0
+        5, 10, 10,  4, 10, 11,  7, 11,  5,  6, 10,  4, 10,  0,  7, 11    // 0xF0
+    };
+
+    std::array<uint8_t, 256> table{};
+    for (int op = 0; op < 64; ++op) {
+        table[op] = low[op];
+        table[0xC0 + op] = high[op];
+    }
+    // LD r,r' and ALU r: 4, or 7 when (HL) is involved
+    for (int op = 0x40; op < 0xC0; ++op) {
+        const bool memory = (op & 7) == 6 || (op < 0x80 && ((op >> 3) & 7) == 6);
+        table[op] = memory ? 7 : 4;
+    }
+    table[0x76] = 4;
+    return table;
+}();
+
+// CB-prefixed opcodes: 8 on registers; on (HL) 12 for BIT and 15 otherwise
+constexpr uint8_t z80CbCycles(uint8_t op) {
+    if ((op & 7) != 6)
+        return 8;
+    return (op >> 6) == 1 ? 12 : 15;
+}
+
+
+#endif
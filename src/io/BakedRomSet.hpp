@@ -0,0 +1,38 @@
+#ifndef BAKED_ROM_SET_HPP
+#define BAKED_ROM_SET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include "../recomp/Z80BlockRuntime.hpp"
+
+/* A BakedRomSet is one ROM set and everything derived from it, compiled into the
+ * executable. PacmanBake (CMake option PACMAN_BAKE_ROMS) writes it at build time:
+ * the program image, tile and sprite pens as decodeGraphics() produces them, the
+ * color LUT, and the generated blocks of the analysed program. Startup then reads
+ * no files and decodes nothing; the tables are constant data, paged in on use.
+ *
+ * The generated blocks are only valid for 'program'. Without baking the build
+ * links a stub and bakedRomSet() returns nullptr.
+ */
+
+struct BakedRomSet {
+    std::string_view set_name;
+    std::span<const uint8_t> program;
+    uint32_t program_crc32 = 0;
+    std::span<const uint8_t> tiles;             // tile_count x 8 x 8 pens
+    std::span<const uint8_t> sprites;           // sprite_count x 16 x 16 pens
+    size_t tile_count = 0;
+    size_t sprite_count = 0;
+    std::span<const uint32_t> colors;           // ColorLut::colors
+    std::span<const uint8_t> color_indices;     // ColorLut::color_indices
+    std::span<const uint32_t> rgba;             // ColorLut::rgba
+    std::span<const Z80GeneratedBlock> blocks;
+};
+
+
+const BakedRomSet* bakedRomSet();
+
+
+#endif
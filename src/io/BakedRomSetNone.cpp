@@ -0,0 +1,7 @@
+#include "BakedRomSet.hpp"
+
+
+// Linked when PACMAN_BAKE_ROMS is off; assets come from the ROM folder at runtime
+const BakedRomSet* bakedRomSet() {
+    return nullptr;
+}
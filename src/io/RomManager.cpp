@@ -1,45 +1,61 @@
 #include "RomManager.hpp"
+#include "../utils/Crc32.hpp"
 
 
-RomManager::RomManager(const std::string& rom_folder_path) : rom_folder(rom_folder_path){}
+RomManager::RomManager(const std::string& rom_folder_path, RomSetDescription rom_set)
+    : rom_folder(rom_folder_path), rom_set(std::move(rom_set)) {}
 
 
 bool RomManager::verifyRequiredRoms() const {
-    for (const std::string& file : required_files) {
-        std::filesystem::path full_path = std::filesystem::path(rom_folder) / file;
+    for (const RomFileSpec& file : rom_set.files) {
+        std::filesystem::path full_path = std::filesystem::path(rom_folder) / file.name;
 
         if (!std::filesystem::exists(full_path)) {
-            std::cerr << "Rom file not found: " << file << "\n";
+            std::cerr << "Rom file not found: " << file.name << "\n";
             return false;
         }
 
-        std::cout << "Rom file found: " << file << "\n";
+        std::cout << "Rom file found: " << file.name << "\n";
     }
     return true;
 }
 
 
-std::unordered_map<std::string, std::vector<uint8_t>> RomManager::loadRoms() const {
-    std::unordered_map<std::string, std::vector<uint8_t>> rom_data;
+bool RomManager::loadRegions(RomSetImage& image, RomCache* cache) const {
+    RomCache local_cache;
+    RomCache& files = cache ? *cache : local_cache;
 
-    for (const std::string& file : required_files) {
-        std::filesystem::path full_path = std::filesystem::path(rom_folder) / file;
+    image.set_name = rom_set.name;
+    image.files.clear();
+    for (size_t r = 0; r < ROM_REGION_COUNT; ++r)
+        image.regions[r].assign(rom_set.regionSize(static_cast<RomRegion>(r)), 0xFF);
 
-        std::ifstream rom_file(full_path, std::ios::binary);
+    for (const RomFileSpec& file : rom_set.files) {
+        std::filesystem::path full_path = std::filesystem::path(rom_folder) / file.name;
 
-        if (!rom_file) {
-            std::cerr << "Rom file not found: " << file << "\n";
+        RomData data = files.load(full_path);
+        if (!data) {
+            std::cerr << "Rom file not found: " << file.name << "\n";
+            return false;
         }
 
-        std::vector<uint8_t> data (
-            (std::istreambuf_iterator<char>(rom_file)),
-            std::istreambuf_iterator<char>()
-            );
+        if (data->size() != file.size) {
+            std::cerr << "Rom file " << file.name << " is " << data->size()
+                      << " bytes, expected " << file.size << "\n";
+            return false;
+        }
 
-        rom_data[file] = data;
+        // A bad dump still loads; the mismatch is only reported
+        if (file.check_crc && crc32(*data) != file.crc32) {
+            std::cerr << "Warning: CRC mismatch for " << file.name << " (expected "
+                      << std::hex << file.crc32 << ", got " << crc32(*data) << std::dec << ")\n";
+        }
 
-        std::cout << "Loaded ROM: " << file
-                  << " (" << data.size() << " bytes)\n";
+        std::vector<uint8_t>& region = image.regions[static_cast<size_t>(file.region)];
+        std::copy(data->begin(), data->end(), region.begin() + file.load_address);
+        image.files[file.name] = data;
     }
-    return rom_data;
-}
\ No newline at end of file
+
+    std::cout << "Loaded rom set: " << rom_set.name << " (" << rom_set.description << ")\n";
+    return true;
+}
@@ -3,36 +3,28 @@
 
 #include <string>
 #include <vector>
-#include <unordered_map>
 #include <filesystem>
 #include <iostream>
 #include <fstream>
+#include "RomSet.hpp"
 
-/* RomManager initializes with the folder path where the rom files are located.
+/* RomManager initializes with the folder path where the rom files are located
+ * and the description of the rom set expected there (Midway Pac-Man by default).
  * We check that all the required rom files exist.
- * Load the roms into memory.
+ * Load the roms into memory as assembled memory regions.
+ * Several managers can share one RomCache to load sets concurrently.
  */
 
 class RomManager {
     public:
-    RomManager(const std::string& rom_folder_path);
+    RomManager(const std::string& rom_folder_path, RomSetDescription rom_set = pacmanRomSet());
     bool verifyRequiredRoms() const;
-    std::unordered_map<std::string, std::vector<uint8_t>> loadRoms() const;
+    bool loadRegions(RomSetImage& image, RomCache* cache = nullptr) const;
+    const RomSetDescription& romSet() const { return rom_set; }
 
     private:
     std::string rom_folder;
-    std::vector<std::string> required_files = {
-        "pacman.6e",                           // Code ROM1
-        "pacman.6f",                           // Code ROM2
-        "pacman.6h",                           // Code ROM3
-        "pacman.6j",                           // Code ROM4
-        "82s123.7f",                           // Color ROM
-        "82s126.4a",                           // Palette ROM
-        "pacman.5e",                           // Tile ROM
-        "pacman.5f",                           // Sprite ROM
-        "82s126.1m",                           // Sound ROM 1
-        "82s126.3m"                            // Sound ROM 2
-    };
+    RomSetDescription rom_set;
 };
 
 
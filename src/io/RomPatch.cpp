@@ -0,0 +1,65 @@
+#include "RomPatch.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+std::vector<RomPatch> loadRomPatches(const std::filesystem::path& patch_file) {
+    std::ifstream in(patch_file);
+    if (!in) {
+        std::cerr << "Failed to open patch file: " << patch_file << "\n";
+        return {};
+    }
+
+    std::vector<RomPatch> patches;
+    std::string line;
+    size_t line_number = 0;
+
+    while (std::getline(in, line)) {
+        ++line_number;
+
+        // strip comments
+        const size_t comment = line.find_first_of(";#");
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                std::cerr << "Malformed patch line " << line_number << " in " << patch_file << "\n";
+                return {};
+            }
+            continue;
+        }
+
+        RomPatch patch;
+        std::istringstream fields(line);
+        unsigned int value = 0;
+
+        fields >> std::hex >> value;
+        if (!fields || value > 0xFFFF || line.find_first_not_of(" \t", static_cast<size_t>(fields.tellg())) != colon) {
+            std::cerr << "Bad patch address on line " << line_number << " in " << patch_file << "\n";
+            return {};
+        }
+        patch.address = static_cast<uint16_t>(value);
+
+        fields.seekg(static_cast<std::streamoff>(colon + 1));
+        while (fields >> std::hex >> value) {
+            if (value > 0xFF) {
+                std::cerr << "Bad patch byte on line " << line_number << " in " << patch_file << "\n";
+                return {};
+            }
+            patch.bytes.push_back(static_cast<uint8_t>(value));
+        }
+
+        // Extraction stops at the first token that is not hex; only the end of the line may stop it
+        if (!fields.eof() || patch.bytes.empty()) {
+            std::cerr << "Bad patch byte on line " << line_number << " in " << patch_file << "\n";
+            return {};
+        }
+        patches.push_back(std::move(patch));
+    }
+
+    return patches;
+}
@@ -0,0 +1,26 @@
+#ifndef ROM_PATCH_HPP
+#define ROM_PATCH_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/* A RomPatch is a run of bytes written over the program image at a CPU address.
+ * Patch files are plain text, one patch per line:
+ *
+ *     3a5c: 00 00 c9      ; comment
+ *
+ * Blank lines and lines starting with ';' or '#' are ignored.
+ */
+
+struct RomPatch {
+    uint16_t address = 0;
+    std::vector<uint8_t> bytes;
+};
+
+
+// Returns an empty vector (and reports the line) when the file cannot be parsed
+std::vector<RomPatch> loadRomPatches(const std::filesystem::path& patch_file);
+
+
+#endif
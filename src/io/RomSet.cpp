@@ -0,0 +1,258 @@
+#include "RomSet.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "../utils/Crc32.hpp"
+
+
+static constexpr std::array<const char*, ROM_REGION_COUNT> REGION_NAMES = {
+    "code", "tiles", "sprites", "color", "sound"
+};
+
+
+const char* romRegionName(RomRegion region) {
+    return REGION_NAMES[static_cast<size_t>(region)];
+}
+
+
+uint32_t RomSetDescription::regionSize(RomRegion region) const {
+    uint32_t size = 0;
+    for (const RomFileSpec& file : files) {
+        if (file.region == region)
+            size = std::max(size, file.load_address + file.size);
+    }
+    return size;
+}
+
+
+std::vector<std::string> RomSetDescription::filesInRegion(RomRegion region) const {
+    std::vector<const RomFileSpec*> matching;
+    for (const RomFileSpec& file : files) {
+        if (file.region == region)
+            matching.push_back(&file);
+    }
+
+    std::sort(matching.begin(), matching.end(),
+              [](const RomFileSpec* a, const RomFileSpec* b) { return a->load_address < b->load_address; });
+
+    std::vector<std::string> names;
+    for (const RomFileSpec* file : matching)
+        names.push_back(file->name);
+    return names;
+}
+
+
+static RomFileSpec rom(RomRegion region, const char* name, uint32_t load_address, uint32_t size,
+                       uint32_t crc = 0) {
+    return { name, region, load_address, size, crc, crc != 0 };
+}
+
+
+// PROMs shared by every revision below
+static void addCommonProms(RomSetDescription& set, const char* color, const char* palette,
+                           const char* sound1, const char* sound2) {
+    set.files.push_back(rom(RomRegion::Color, color,   0x0000, 0x0020, 0x2fc650bd));
+    set.files.push_back(rom(RomRegion::Color, palette, 0x0020, 0x0100, 0x3eb3a8e4));
+    set.files.push_back(rom(RomRegion::Sound, sound1,  0x0000, 0x0100, 0xa9cc86bf));
+    set.files.push_back(rom(RomRegion::Sound, sound2,  0x0100, 0x0100, 0x77245b66));
+}
+
+
+RomSetDescription pacmanRomSet() {
+    RomSetDescription set;
+    set.name = "pacman";
+    set.description = "Pac-Man (Midway)";
+    set.files = {
+        rom(RomRegion::Code,    "pacman.6e", 0x0000, 0x1000, 0xc1e6ab10),
+        rom(RomRegion::Code,    "pacman.6f", 0x1000, 0x1000, 0x1a6fb2d4),
+        rom(RomRegion::Code,    "pacman.6h", 0x2000, 0x1000, 0xbcdd1beb),
+        rom(RomRegion::Code,    "pacman.6j", 0x3000, 0x1000, 0x817d94e3),
+        rom(RomRegion::Tiles,   "pacman.5e", 0x0000, 0x1000, 0x0c944964),
+        rom(RomRegion::Sprites, "pacman.5f", 0x0000, 0x1000, 0x958fedf9)
+    };
+    addCommonProms(set, "82s123.7f", "82s126.4a", "82s126.1m", "82s126.3m");
+    return set;
+}
+
+
+RomSetDescription puckmanRomSet() {
+    RomSetDescription set;
+    set.name = "puckman";
+    set.description = "Puck Man (Japan set 1)";
+    set.files = {
+        rom(RomRegion::Code,    "pm1_prg1.6e", 0x0000, 0x0800, 0xf36e88ab),
+        rom(RomRegion::Code,    "pm1_prg2.6k", 0x0800, 0x0800, 0x618bd9b3),
+        rom(RomRegion::Code,    "pm1_prg3.6f", 0x1000, 0x0800, 0x7d177853),
+        rom(RomRegion::Code,    "pm1_prg4.6m", 0x1800, 0x0800, 0xd3e8914c),
+        rom(RomRegion::Code,    "pm1_prg5.6h", 0x2000, 0x0800, 0x6bf4f625),
+        rom(RomRegion::Code,    "pm1_prg6.6n", 0x2800, 0x0800, 0xa948ce83),
+        rom(RomRegion::Code,    "pm1_prg7.6j", 0x3000, 0x0800, 0xb6289b26),
+        rom(RomRegion::Code,    "pm1_prg8.6p", 0x3800, 0x0800, 0x17a88c13),
+        rom(RomRegion::Tiles,   "pm1_chg1.5e", 0x0000, 0x0800, 0x2066a0b7),
+        rom(RomRegion::Tiles,   "pm1_chg2.5h", 0x0800, 0x0800, 0x3591b89d),
+        rom(RomRegion::Sprites, "pm1_chg3.5f", 0x0000, 0x0800, 0x9e39323a),
+        rom(RomRegion::Sprites, "pm1_chg4.5j", 0x0800, 0x0800, 0x1b1d9096)
+    };
+    addCommonProms(set, "pm1-1.7f", "pm1-4.4a", "pm1-3.1m", "pm1-2.3m");
+    return set;
+}
+
+
+// Bootleg Ms. Pac-Man: plain (unencrypted) program ROMs, with the extra code at 0x8000
+RomSetDescription mspacmanBootlegRomSet() {
+    RomSetDescription set;
+    set.name = "mspacmab";
+    set.description = "Ms. Pac-Man (bootleg)";
+    set.files = {
+        rom(RomRegion::Code,    "boot1", 0x0000, 0x1000, 0xd16b31b7),
+        rom(RomRegion::Code,    "boot2", 0x1000, 0x1000, 0x0d32de5e),
+        rom(RomRegion::Code,    "boot3", 0x2000, 0x1000, 0x1821ee0b),
+        rom(RomRegion::Code,    "boot4", 0x3000, 0x1000, 0x165a9dd8),
+        rom(RomRegion::Code,    "boot5", 0x8000, 0x1000, 0x8c3e6de6),
+        rom(RomRegion::Code,    "boot6", 0x9000, 0x1000, 0x368cb165),
+        rom(RomRegion::Tiles,   "5e",    0x0000, 0x1000, 0x5c281d01),
+        rom(RomRegion::Sprites, "5f",    0x0000, 0x1000, 0x615af909)
+    };
+    addCommonProms(set, "82s123.7f", "82s126.4a", "82s126.1m", "82s126.3m");
+    return set;
+}
+
+
+const std::vector<RomSetDescription>& builtinRomSets() {
+    static const std::vector<RomSetDescription> sets = {
+        pacmanRomSet(),
+        puckmanRomSet(),
+        mspacmanBootlegRomSet()
+    };
+    return sets;
+}
+
+
+const RomSetDescription* findBuiltinRomSet(const std::string& name) {
+    for (const RomSetDescription& set : builtinRomSets()) {
+        if (set.name == name)
+            return &set;
+    }
+    return nullptr;
+}
+
+
+static bool parseRegion(const std::string& text, RomRegion& region) {
+    for (size_t i = 0; i < ROM_REGION_COUNT; ++i) {
+        if (text == REGION_NAMES[i]) {
+            region = static_cast<RomRegion>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool loadRomSetDescription(const std::filesystem::path& description_file, RomSetDescription& out) {
+    std::ifstream in(description_file);
+    if (!in) {
+        std::cerr << "Failed to open rom set description: " << description_file << "\n";
+        return false;
+    }
+
+    RomSetDescription set;
+    std::string line;
+    size_t line_number = 0;
+
+    while (std::getline(in, line)) {
+        ++line_number;
+
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword))
+            continue;
+
+        if (keyword == "set") {
+            fields >> set.name;
+        }
+        else if (keyword == "description") {
+            std::getline(fields >> std::ws, set.description);
+        }
+        else if (keyword == "rom") {
+            std::string region, name, crc;
+            RomFileSpec file;
+
+            fields >> region >> name >> std::hex >> file.load_address >> file.size >> crc;
+            if (!fields || !parseRegion(region, file.region)) {
+                std::cerr << "Malformed rom entry on line " << line_number
+                          << " in " << description_file << "\n";
+                return false;
+            }
+
+            file.name = name;
+            if (crc != "-") {
+                std::from_chars_result parsed = std::from_chars(crc.data(), crc.data() + crc.size(),
+                                                                file.crc32, 16);
+                if (parsed.ec != std::errc() || parsed.ptr != crc.data() + crc.size()) {
+                    std::cerr << "Bad CRC '" << crc << "' on line " << line_number
+                              << " in " << description_file << "\n";
+                    return false;
+                }
+                file.check_crc = true;
+            }
+            set.files.push_back(file);
+        }
+        else {
+            std::cerr << "Unknown keyword '" << keyword << "' on line " << line_number
+                      << " in " << description_file << "\n";
+            return false;
+        }
+    }
+
+    if (set.name.empty() || set.files.empty()) {
+        std::cerr << "Rom set description has no name or files: " << description_file << "\n";
+        return false;
+    }
+
+    out = std::move(set);
+    return true;
+}
+
+
+RomData RomCache::load(const std::filesystem::path& path) {
+    const std::string key = std::filesystem::absolute(path).lexically_normal().string();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<std::string, RomData>::const_iterator it = by_path.find(key);
+        if (it != by_path.end())
+            return it->second;
+    }
+
+    // Read outside the lock so different sets can load in parallel
+    std::ifstream rom_file(path, std::ios::binary);
+    if (!rom_file)
+        return nullptr;
+
+    std::vector<uint8_t> data(
+        (std::istreambuf_iterator<char>(rom_file)),
+        std::istreambuf_iterator<char>()
+        );
+
+    const uint64_t content_key = (static_cast<uint64_t>(data.size()) << 32) | crc32(data);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    RomData& shared = by_content[content_key];
+    if (!shared) {
+        shared = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+        return by_path.emplace(key, shared).first->second;
+    }
+
+    // Same size and CRC is only a candidate; a collision keeps its own buffer
+    if (!std::ranges::equal(*shared, data))
+        return by_path.emplace(key, std::make_shared<const std::vector<uint8_t>>(std::move(data))).first->second;
+
+    return by_path.emplace(key, shared).first->second;
+}
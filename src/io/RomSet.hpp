@@ -0,0 +1,107 @@
+#ifndef ROM_SET_HPP
+#define ROM_SET_HPP
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* A RomSetDescription lists every file of one board revision: its name, size,
+ * CRC-32, the memory region it belongs to and where in that region it is loaded.
+ * Descriptions are built in (pacman, puckman, mspacmab) or read from a text file:
+ *
+ *     # comment
+ *     set pacman
+ *     description Pac-Man (Midway)
+ *     rom code    pacman.6e  0x0000 0x1000 c1e6ab10
+ *     rom color   82s126.4a  0x0020 0x0100 3eb3a8e4
+ *     rom sound   82s126.1m  0x0000 0x0100 -            (- = CRC not checked)
+ *
+ * Regions follow the board: code, tiles, sprites, color (color PROM at 0x00,
+ * palette PROM at 0x20) and sound (waveform PROMs).
+ */
+
+enum class RomRegion : uint8_t {
+    Code,
+    Tiles,
+    Sprites,
+    Color,
+    Sound,
+    Count
+};
+
+constexpr size_t ROM_REGION_COUNT = static_cast<size_t>(RomRegion::Count);
+
+const char* romRegionName(RomRegion region);
+
+
+struct RomFileSpec {
+    std::string name;
+    RomRegion region = RomRegion::Code;
+    uint32_t load_address = 0;          // offset inside the region
+    uint32_t size = 0;
+    uint32_t crc32 = 0;
+    bool check_crc = false;
+};
+
+
+struct RomSetDescription {
+    std::string name;
+    std::string description;
+    std::vector<RomFileSpec> files;
+
+    // Bytes needed to hold every file of a region
+    uint32_t regionSize(RomRegion region) const;
+
+    // Names of the files in a region, ordered by load address
+    std::vector<std::string> filesInRegion(RomRegion region) const;
+};
+
+
+// Built-in descriptions
+RomSetDescription pacmanRomSet();
+RomSetDescription puckmanRomSet();
+RomSetDescription mspacmanBootlegRomSet();
+const std::vector<RomSetDescription>& builtinRomSets();
+const RomSetDescription* findBuiltinRomSet(const std::string& name);
+
+// Returns false (and reports the line) when the file cannot be parsed
+bool loadRomSetDescription(const std::filesystem::path& description_file, RomSetDescription& out);
+
+
+using RomData = std::shared_ptr<const std::vector<uint8_t>>;
+
+/* RomCache shares loaded files between sets and threads. A file is read once per
+ * path, and files with identical contents share one buffer (size and CRC find the
+ * candidate, the bytes confirm it), so the PROMs common to every Pac-Man revision
+ * are only held once per process.
+ */
+class RomCache {
+    public:
+    RomData load(const std::filesystem::path& path);
+
+    private:
+    std::mutex mutex;
+    std::unordered_map<std::string, RomData> by_path;
+    std::unordered_map<uint64_t, RomData> by_content;   // (size << 32) | crc32
+};
+
+
+// Memory regions assembled from a set; unused bytes are 0xFF like an unprogrammed EPROM
+struct RomSetImage {
+    std::string set_name;
+    std::array<std::vector<uint8_t>, ROM_REGION_COUNT> regions;
+    std::unordered_map<std::string, RomData> files;
+
+    std::span<const uint8_t> region(RomRegion region) const {
+        return regions[static_cast<size_t>(region)];
+    }
+};
+
+
+#endif
@@ -0,0 +1,130 @@
+#include "PacmanMachine.hpp"
+#include <algorithm>
+
+
+PacmanMachine::PacmanMachine(std::span<const uint8_t> program, uint8_t* ram)
+    : program(program), ram_block(ram ? ram : owned_ram.data()), processor(memory), ports(processor) {
+
+    // A15 is not decoded on Pac-Man, so the upper half mirrors the lower one.
+    // The Ms. Pac-Man bootleg puts extra program ROM at 0x8000 instead.
+    const uint32_t low_size = std::min<uint32_t>(static_cast<uint32_t>(program.size()), 0x4000) & ~0xFFu;
+    memory.mapRom(0x0000, low_size, program.data());
+
+    if (program.size() > 0x8000) {
+        const uint32_t high_size = std::min<uint32_t>(static_cast<uint32_t>(program.size()) - 0x8000, 0x4000) & ~0xFFu;
+        memory.mapRom(0x8000, high_size, program.data() + 0x8000);
+    }
+    else {
+        memory.mapRom(0x8000, low_size, program.data());
+    }
+
+    for (uint16_t base : { uint16_t(0x4000), uint16_t(0xC000) }) {
+        memory.mapRam(base, 0x0800, ram_block);
+        memory.mapDevice(base + 0x0800, 0x0400, this);
+        memory.mapRam(base + 0x0C00, 0x0400, ram_block + 0x0C00);
+        memory.mapDevice(base + 0x1000, 0x0100, this);
+    }
+
+    memory.setPortDevice(&ports);
+    reset();
+}
+
+
+void PacmanMachine::reset() {
+    std::fill(ram_block, ram_block + PACMAN_RAM_SIZE, 0);
+    sound_registers.fill(0);
+    sprite_coords.fill(0);
+    irq_enabled = false;
+    flip_screen = false;
+    frames = 0;
+    frame_cycles_left = 0;
+    frame_end_pending = false;
+    processor.reset();
+
+    // RAM was cleared behind the bus
+    if (executor)
+        executor->flush();
+}
+
+
+bool PacmanMachine::runFrame() {
+    // After a stop on the frame's last instruction only the frame end is left
+    if (!frame_end_pending) {
+        // A frame resumed after a debugger stop keeps its remaining budget;
+        // otherwise the last instruction's overshoot is carried into this frame
+        if (frame_cycles_left <= 0)
+            frame_cycles_left += PACMAN_CYCLES_PER_FRAME;
+
+        if (debugger && debugger->armed()) {
+            frame_cycles_left -= debugger->run(frame_cycles_left);
+            if (debugger->lastStop().reason != DebugStopReason::None) {
+                frame_end_pending = frame_cycles_left <= 0;
+                return false;
+            }
+        }
+        else if (executor) {
+            frame_cycles_left -= executor->run(frame_cycles_left);
+        }
+        else {
+            frame_cycles_left -= processor.run(frame_cycles_left);
+        }
+    }
+    frame_end_pending = false;
+
+    // VBLANK
+    if (irq_enabled)
+        processor.setIrqLine(true);
+    ++frames;
+    return true;
+}
+
+
+uint8_t PacmanMachine::read(uint16_t address) {
+    const uint16_t offset = address & 0x7FFF;
+
+    // The hole between color RAM and work RAM floats high
+    if (offset >= 0x4800 && offset < 0x4C00)
+        return 0xBF;
+
+    if (offset >= 0x5000 && offset < 0x5100) {
+        switch (offset & 0xC0) {
+        case 0x00: return inputs.in0;
+        case 0x40: return inputs.in1;
+        case 0x80: return dip_switches;
+        default: return 0xFF;
+        }
+    }
+    return 0xFF;
+}
+
+
+void PacmanMachine::write(uint16_t address, uint8_t value) {
+    const uint16_t offset = address & 0x7FFF;
+    if (offset < 0x5000 || offset >= 0x5100)
+        return;
+
+    const uint8_t reg = offset & 0xFF;
+
+    if (reg < 0x40) {
+        // 74LS259 latch
+        switch (reg & 7) {
+        case 0:
+            irq_enabled = value & 1;
+            if (!irq_enabled)
+                processor.setIrqLine(false);
+            break;
+        case 3:
+            flip_screen = value & 1;
+            break;
+        default:
+            break;
+        }
+    }
+    else if (reg < 0x60) {
+        sound_registers[reg - 0x40] = value & 0x0F;
+    }
+    else if (reg < 0x70) {
+        sprite_coords[reg - 0x60] = value;
+    }
+    // 0x50C0 is the watchdog; there is nothing to reset
+}
@@ -0,0 +1,126 @@
+#ifndef PACMAN_MACHINE_HPP
+#define PACMAN_MACHINE_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include "../core/MemoryBus.hpp"
+#include "../core/Z80Cpu.hpp"
+#include "../core/Z80Debugger.hpp"
+#include "../recomp/Z80Executor.hpp"
+
+/* PacmanMachine is the Pac-Man board around the Z80: memory map, input ports,
+ * DIP switches, interrupt latch and the write-only video/sound registers.
+ *
+ *   0x0000-0x3FFF  program ROM (0x8000-0xBFFF for the Ms. Pac-Man bootleg)
+ *   0x4000-0x43FF  video RAM (tile codes)
+ *   0x4400-0x47FF  color RAM (tile palettes)
+ *   0x4C00-0x4FEF  work RAM, 0x4FF0-0x4FFF sprite code/color
+ *   0x5000-0x50FF  inputs/DIPs on read; IRQ enable, sound, sprite coords on write
+ *
+ * The program ROM is only referenced, so many machines can share one image.
+ * The 0x4000-0x4FFF block can live in caller-owned storage (see PacmanEnvBatch).
+ * No audio is produced; sound register writes are latched and otherwise ignored.
+ *
+ * With an executor attached, frames run block by block through it (generated
+ * code, cached translations of RAM code) instead of the plain interpreter.
+ */
+
+constexpr uint32_t PACMAN_CPU_CLOCK = 3072000;
+constexpr int PACMAN_CYCLES_PER_FRAME = 50688;        // 384 x 264 pixel clocks / 2
+
+constexpr uint16_t PACMAN_RAM_BASE = 0x4000;
+constexpr size_t PACMAN_RAM_SIZE = 0x1000;            // video, color, hole, work RAM
+constexpr uint16_t PACMAN_VIDEO_RAM = 0x4000;
+constexpr uint16_t PACMAN_COLOR_RAM = 0x4400;
+constexpr uint16_t PACMAN_SPRITE_RAM = 0x4FF0;
+
+// Active-low input bits
+constexpr uint8_t PACMAN_IN0_UP = 0x01;
+constexpr uint8_t PACMAN_IN0_LEFT = 0x02;
+constexpr uint8_t PACMAN_IN0_RIGHT = 0x04;
+constexpr uint8_t PACMAN_IN0_DOWN = 0x08;
+constexpr uint8_t PACMAN_IN0_COIN1 = 0x20;
+constexpr uint8_t PACMAN_IN1_START1 = 0x20;
+constexpr uint8_t PACMAN_IN1_START2 = 0x40;
+
+struct PacmanInput {
+    uint8_t in0 = 0xFF;
+    uint8_t in1 = 0xFF;
+};
+
+
+class PacmanMachine : private BusDevice {
+    public:
+    // 'program' must outlive the machine. 'ram' (PACMAN_RAM_SIZE bytes) is optional external storage.
+    explicit PacmanMachine(std::span<const uint8_t> program, uint8_t* ram = nullptr);
+
+    PacmanMachine(const PacmanMachine&) = delete;
+    PacmanMachine& operator=(const PacmanMachine&) = delete;
+
+    void reset();
+
+    // Runs one video frame of CPU time, then raises VBLANK. Returns false when an
+    // attached debugger stopped the CPU; the next call finishes the same frame.
+    bool runFrame();
+
+    // The debugger is only consulted while it is armed
+    void attachDebugger(Z80Debugger* debugger_) { debugger = debugger_; }
+
+    // An armed debugger still takes precedence; reset() flushes the executor's translations
+    void attachExecutor(Z80Executor* executor_) { executor = executor_; }
+
+    void setInput(PacmanInput input) { inputs = input; }
+    void setDipSwitches(uint8_t value) { dip_switches = value; }
+
+    std::span<const uint8_t> ram() const { return { ram_block, PACMAN_RAM_SIZE }; }
+    std::span<const uint8_t> videoRam() const { return ram().subspan(PACMAN_VIDEO_RAM - PACMAN_RAM_BASE, 0x400); }
+    std::span<const uint8_t> colorRam() const { return ram().subspan(PACMAN_COLOR_RAM - PACMAN_RAM_BASE, 0x400); }
+    std::span<const uint8_t> spriteRam() const { return ram().subspan(PACMAN_SPRITE_RAM - PACMAN_RAM_BASE, 0x10); }
+    std::span<const uint8_t> spriteCoords() const { return sprite_coords; }
+    bool flipScreen() const { return flip_screen; }
+
+    Z80Cpu& cpu() { return processor; }
+    MemoryBus& bus() { return memory; }
+    uint64_t frameCount() const { return frames; }
+
+    private:
+    uint8_t read(uint16_t address) override;
+    void write(uint16_t address, uint8_t value) override;
+
+    // Port writes: OUT (0),A sets the IM 2 vector byte
+    class Ports : public BusDevice {
+        public:
+        explicit Ports(Z80Cpu& cpu) : cpu(cpu) {}
+        uint8_t read(uint16_t) override { return 0xFF; }
+        void write(uint16_t port, uint8_t value) override {
+            if ((port & 0xFF) == 0)
+                cpu.setInterruptData(value);
+        }
+        private:
+        Z80Cpu& cpu;
+    };
+
+    std::span<const uint8_t> program;
+    std::array<uint8_t, PACMAN_RAM_SIZE> owned_ram{};
+    uint8_t* ram_block;
+
+    MemoryBus memory;
+    Z80Cpu processor;
+    Ports ports;
+
+    PacmanInput inputs;
+    uint8_t dip_switches = 0xC9;        // 1 coin/1 credit, 3 lives, bonus at 10000, normal
+    bool irq_enabled = false;
+    bool flip_screen = false;
+    std::array<uint8_t, 0x20> sound_registers{};
+    std::array<uint8_t, 0x10> sprite_coords{};
+    uint64_t frames = 0;
+    int frame_cycles_left = 0;          // negative: overshoot of the previous frame
+    bool frame_end_pending = false;     // stopped on the frame's last instruction, VBLANK not raised yet
+    Z80Debugger* debugger = nullptr;
+    Z80Executor* executor = nullptr;
+};
+
+
+#endif
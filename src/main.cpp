@@ -1,48 +1,148 @@
+#include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include "io/BakedRomSet.hpp"
 #include "io/RomManager.hpp"
 #include "utils/RomDumper.hpp"
 #include "core/Z80Disassembler.hpp"
+#include "core/Z80Analysis.hpp"
+#include "core/Z80Classification.hpp"
+#include "core/SymbolTable.hpp"
+#include "io/RomPatch.hpp"
+#include "recomp/Z80Emitter.hpp"
+#include "rl/PacmanEnv.hpp"
+#include "video/ColorLut.hpp"
+#include "video/FrameDumper.hpp"
+
+
+// A baked build reaches its first frame without touching the rom folder
+static bool runBakedFirstFrame() {
+    const BakedRomSet* baked = bakedRomSet();
+    if (!baked)
+        return false;
+
+    const auto start = std::chrono::steady_clock::now();
+    auto assets = std::make_shared<PacmanEnvAssets>();
+    if (!loadBakedPacmanEnvAssets(*assets))
+        return false;
+    PacmanEnv env(assets);
+    env.step({});
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Baked rom set " << baked->set_name << ": first frame after " << elapsed.count() << " ms ("
+              << baked->blocks.size() << " generated blocks)\n";
+    return true;
+}
 
 
 int main() {
+    const bool baked = runBakedFirstFrame();
+
     RomManager rom_manager("../roms");
 
     if (!rom_manager.verifyRequiredRoms()) {
+        if (baked)
+            return 0;
         std::cerr << "Please make sure all ROM files are in the 'roms/' folder.\n";
         return 1;
     }
 
-    // Load roms into memory
-    std::unordered_map<std::string, std::vector<uint8_t>> roms = rom_manager.loadRoms();
+    // Assemble the memory regions described by the rom set; every file is read once
+    RomSetImage rom_image;
+    if (!rom_manager.loadRegions(rom_image))
+        return 1;
 
     // dump roms into txt files
-    dumpRomsForDebug(roms);
+    dumpRomsForDebug(rom_image.files);
 
     // clear rom_dumps folder
     // clearRomDumpFolder();
 
+    // Decode color and palette PROMs into the packed lookup table
+    ColorLut color_lut;
+    if (!buildColorLut(rom_image.region(RomRegion::Color), color_lut))
+        return 1;
+    exportColorLut(color_lut, "../rom_dumps/color_lut.txt");
+
+    // Record the first second of attract mode headless; finish() reports backpressure
+    auto env_assets = std::make_shared<PacmanEnvAssets>();
+    if (loadPacmanEnvAssets(rom_image, *env_assets)) {
+        FrameDumper dumper({ .output_file = "../rom_dumps/attract.y4m", .keyframe_folder = "../rom_dumps",
+                             .keyframe_interval = 30 });
+        if (dumper.start()) {
+            PacmanEnv env(env_assets);
+            env.attachFrameDumper(&dumper);
+            env.step({}, 60);
+            dumper.finish();
+        }
+    }
 
     // Combine the core rom files
-    const std::vector<std::string> pacman_rom_order = {
-        "pacman.6e",
-        "pacman.6f",
-        "pacman.6h",
-        "pacman.6j"
-    };
-
-    concatenateRoms(roms, pacman_rom_order, "../roms/pacman_program.rom");
+    concatenateRoms(rom_image.files, rom_manager.romSet().filesInRegion(RomRegion::Code), "../roms/pacman_program.rom");
     convertCombinedRomToText(
         "../roms/pacman_program.rom",
         "../rom_dumps/pacman_program.txt"
     );
 
-    // convert combined rom file into asm file
-    std::vector<uint8_t> pacman_rom = loadRomFile("../roms/pacman_program.rom");
+    // convert the code region into asm file
+    std::span<const uint8_t> code_region = rom_image.region(RomRegion::Code);
+    std::vector<uint8_t> pacman_rom(code_region.begin(), code_region.end());
     if (pacman_rom.empty())
         return 1;
 
-    disassembleZ80(pacman_rom,"../roms/pacman.asm");
+    // optional labels and comments for known routines
+    SymbolTable symbols;
+    if (std::filesystem::exists("../roms/pacman.sym"))
+        loadSymbolFile("../roms/pacman.sym", symbols);
+
+    disassembleZ80(pacman_rom,"../roms/pacman.asm", &symbols);
+
+    // find basic blocks and jump tables; the board has no NMI, the IM 2 handlers are found from the code
+    Z80AnalysisOptions analysis_options;
+    analysis_options.entry_points = { 0x0000, 0x0038 };
+    analysis_options.interrupt_vector_port = 0x00;
+    Z80Analysis analysis(pacman_rom, 0x0000, analysis_options);
+    analysis.analyze();
+    std::cout << "Analysis found " << analysis.blocks().size() << " basic blocks, "
+              << analysis.jumpTables().size() << " jump tables, "
+              << analysis.interruptHandlers().size() << " interrupt handlers\n";
+
+    // generate C++ for every analysed block, one file per block
+    const Z80EmitOptions emit_options{ .optimize = true, .symbols = &symbols };
+    Z80EmittedFiles generated;
+    Z80EmitStats emitted = emitZ80ProgramFiles(analysis, generated, emit_options);
+    std::cout << "Generated " << emitted.blocks << " blocks from " << emitted.source_instructions
+              << " instructions (" << emitted.interpreted << " interpreted): "
+              << emitted.optimized.folded << " folded, " << emitted.optimized.removed << " removed, "
+              << emitted.optimized.merged << " merged\n";
+
+    // apply optional patches; only the blocks they touch get re-analysed and re-emitted
+    if (std::filesystem::exists("../roms/pacman.patch")) {
+        for (const RomPatch& patch : loadRomPatches("../roms/pacman.patch")) {
+            Z80PatchResult result = analysis.applyPatch(patch.address, patch.bytes);
+            Z80EmitStats regenerated = emitZ80PatchedFiles(analysis, result, generated, emit_options);
+            std::cout << "Patched " << std::hex << patch.address << std::dec << ": "
+                      << result.changed_blocks.size() << " blocks changed, "
+                      << result.removed_blocks.size() << " removed, "
+                      << regenerated.blocks << " regenerated\n";
+        }
+    }
+
+    // classify every byte and keep only reachable code in the listing
+    Z80Classification classification(analysis);
+    std::cout << "Classified " << classification.count(ByteClass::Code) << " code, "
+              << classification.count(ByteClass::Data) << " data, "
+              << classification.count(ByteClass::JumpTable) << " jump table, "
+              << classification.count(ByteClass::Unknown) << " unknown bytes\n";
+
+    std::ofstream code_asm("../roms/pacman_code.asm");
+    if (code_asm)
+        disassembleReachable(analysis, classification, code_asm, &symbols);
+
+    // only files whose contents changed are rewritten, so the rebuild only compiles those
+    const size_t written = writeZ80Files(generated, "../roms/recomp");
+    std::cout << "Wrote " << written << " of " << generated.size() << " generated files\n";
 
     return 0;
 }
\ No newline at end of file
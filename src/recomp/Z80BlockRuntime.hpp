@@ -0,0 +1,36 @@
+#ifndef Z80_BLOCK_RUNTIME_HPP
+#define Z80_BLOCK_RUNTIME_HPP
+
+#include <cstdint>
+#include <span>
+#include "../core/Z80Alu.hpp"
+#include "../core/Z80Cpu.hpp"
+
+/* Z80BlockRuntime is the contract between generated code and the machine.
+ *
+ * A generated block runs one basic block against a Z80Cpu and returns the PC
+ * to continue at. It adds its own T-states to cpu.total_cycles and advances R,
+ * so cycle pacing matches the interpreter. Interrupts are only taken between
+ * blocks; a block ending in EI also runs the instruction after it, so the EI
+ * delay does not outlive it. Register state is only valid in cpu.regs after the
+ * block returns.
+ */
+
+using Z80BlockFunction = uint16_t (*)(Z80Cpu& cpu);
+
+struct Z80GeneratedBlock {
+    uint16_t start = 0;
+    uint16_t end = 0;                   // one past the last byte
+    Z80BlockFunction run = nullptr;
+};
+
+// R advances by one per opcode fetch; bit 7 is kept
+inline void z80AdvanceRefresh(Z80Registers& regs, unsigned fetches) {
+    regs.r = static_cast<uint8_t>((regs.r & 0x80) | ((regs.r + fetches) & 0x7F));
+}
+
+// Every block of the generated translation unit, sorted by start address
+std::span<const Z80GeneratedBlock> z80GeneratedBlocks();
+
+
+#endif
@@ -0,0 +1,514 @@
+#include "Z80Emitter.hpp"
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+
+static const char* const SLOT_NAMES[IR_SLOT_COUNT] = { "a", "f", "b", "c", "d", "e", "h", "l", "t", "sp" };
+static const char* const ROTATES[4] = { "rlca", "rrca", "rla", "rra" };
+static constexpr uint16_t FLAGS = irSlotBit(IrReg::F);
+
+
+// "0x0A" / "0x1234"
+static std::string hex(unsigned value, int digits = 2) {
+    std::ostringstream text;
+    text << "0x" << std::hex << std::uppercase << std::setw(digits) << std::setfill('0') << value;
+    return text.str();
+}
+
+static std::string slotName(IrReg reg) { return SLOT_NAMES[static_cast<size_t>(reg)]; }
+
+
+namespace {
+
+class BlockEmitter {
+    public:
+    BlockEmitter(std::ostream& out, const IrBlock& block) : out(out), block(block) {}
+
+    void emit(const std::string& name, bool exported);
+
+    private:
+    enum class Slot : uint8_t {
+        Unloaded,       // only in cpu.regs
+        Loaded,         // local matches cpu.regs
+        Dirty           // local is newer
+    };
+
+    void line(const std::string& text) { out << "    " << text << "\n"; }
+
+    void load(uint16_t slots);
+    void modified(uint16_t slots);
+    void writeBack();
+    void forget() { slots.fill(Slot::Unloaded); }
+    std::string account(const IrInstruction& inst, uint16_t cycles) const;
+
+    std::string value(const IrOperand& operand) const;
+    std::string flags(const IrInstruction& inst) const { return inst.flags_dead ? "dead_f" : "f"; }
+    void setPair(const IrOperand& dst, const std::string& expression);
+
+    void instruction(const IrInstruction& inst, const IrInstruction* following);
+    void terminator(const IrInstruction& inst);
+
+    std::ostream& out;
+    const IrBlock& block;
+    std::array<Slot, IR_SLOT_COUNT> slots{};
+    uint16_t accounted = 0;                 // T-states already added to total_cycles
+};
+
+
+void BlockEmitter::load(uint16_t mask) {
+    for (size_t slot = 0; slot < IR_SLOT_COUNT; ++slot) {
+        // The scratch byte is always written first and never lives in cpu.regs
+        if (!(mask & (1u << slot)) || slots[slot] != Slot::Unloaded || slot == static_cast<size_t>(IrReg::T))
+            continue;
+        line(std::string(SLOT_NAMES[slot]) + " = cpu.regs." + SLOT_NAMES[slot] + ";");
+        slots[slot] = Slot::Loaded;
+    }
+}
+
+
+void BlockEmitter::modified(uint16_t mask) {
+    for (size_t slot = 0; slot < IR_SLOT_COUNT; ++slot)
+        if (mask & (1u << slot))
+            slots[slot] = Slot::Dirty;
+}
+
+
+void BlockEmitter::writeBack() {
+    for (size_t slot = 0; slot < IR_SLOT_COUNT; ++slot) {
+        if (slots[slot] != Slot::Dirty || slot == static_cast<size_t>(IrReg::T))
+            continue;
+        line(std::string("cpu.regs.") + SLOT_NAMES[slot] + " = " + SLOT_NAMES[slot] + ";");
+        slots[slot] = Slot::Loaded;
+    }
+}
+
+
+// Cycle and refresh bookkeeping for leaving the block (or entering the interpreter) at 'inst'
+std::string BlockEmitter::account(const IrInstruction& inst, uint16_t cycles) const {
+    std::string code;
+    if (cycles != accounted)
+        code += "cpu.total_cycles += " + std::to_string(cycles - accounted) + "; ";
+    if (inst.fetches)
+        code += "z80AdvanceRefresh(cpu.regs, " + std::to_string(inst.fetches) + "); ";
+    return code;
+}
+
+
+std::string BlockEmitter::value(const IrOperand& operand) const {
+    switch (operand.kind) {
+    case IrOperandKind::Reg8:
+        return SLOT_NAMES[operand.reg];
+    case IrOperandKind::Pair: {
+        const IrPair pair = static_cast<IrPair>(operand.reg);
+        if (pair == IrPair::SP)
+            return "sp";
+        return "static_cast<uint16_t>((" + slotName(irPairHigh(pair)) + " << 8) | " + slotName(irPairLow(pair)) + ")";
+    }
+    case IrOperandKind::Imm:
+        return hex(operand.value, operand.value > 0xFF ? 4 : 2);
+    default:
+        return "0";
+    }
+}
+
+
+// Pairs are stored as their two halves, so the host compiler sees plain byte locals
+void BlockEmitter::setPair(const IrOperand& dst, const std::string& expression) {
+    const IrPair pair = static_cast<IrPair>(dst.reg);
+    if (pair == IrPair::SP) {
+        line("sp = " + expression + ";");
+        return;
+    }
+    line("{ const uint16_t value = " + expression + "; " + slotName(irPairHigh(pair)) + " = static_cast<uint8_t>(value >> 8); " +
+         slotName(irPairLow(pair)) + " = static_cast<uint8_t>(value); }");
+}
+
+
+void BlockEmitter::instruction(const IrInstruction& inst, const IrInstruction* following) {
+    if (inst.op == IrOp::Interpret) {
+        writeBack();
+        line(account(inst, inst.cycles) + "cpu.regs.pc = " + hex(inst.address, 4) + "; cpu.executeInstruction();");
+        accounted = inst.cycles;
+        forget();
+        // An interpreted EI only delays interrupts until the next instruction has run;
+        // at the end of the block that instruction runs in the interpreter before returning
+        if (following && following->op == IrOp::FallThrough)
+            line("if (cpu.interruptDelayed()) { cpu.step(); return cpu.regs.pc; }");
+        else if (following && following->op != IrOp::Stop)
+            line("cpu.endInterruptDelay();");
+        return;
+    }
+
+    load(irLiveReads(inst));
+    if (inst.flags_dead && (irReads(inst) & FLAGS) && irFlagsAffectValue(inst))
+        line("dead_f = f;");
+
+    const std::string dst = value(inst.dst);
+    const std::string src = value(inst.src);
+    const std::string addr = value(inst.addr);
+    const std::string f = flags(inst);
+    const std::string sub = std::to_string(inst.sub);
+
+    switch (inst.op) {
+    case IrOp::Move8:
+        line(dst + " = " + src + ";");
+        break;
+    case IrOp::Move16: {
+        const IrPair pair = static_cast<IrPair>(inst.src.reg);
+        if (inst.src.kind == IrOperandKind::Pair && pair != IrPair::SP && !inst.dst.isPair(IrPair::SP)) {
+            const IrPair to = static_cast<IrPair>(inst.dst.reg);
+            line(slotName(irPairHigh(to)) + " = " + slotName(irPairHigh(pair)) + "; " +
+                 slotName(irPairLow(to)) + " = " + slotName(irPairLow(pair)) + ";");
+        }
+        else {
+            setPair(inst.dst, src);
+        }
+        break;
+    }
+    case IrOp::Load8:
+        line(dst + " = bus.read8(" + addr + ");");
+        break;
+    case IrOp::Store8:
+        line("bus.write8(" + addr + ", " + src + ");");
+        break;
+    case IrOp::Load16:
+        setPair(inst.dst, "bus.read16(" + addr + ")");
+        break;
+    case IrOp::Store16:
+        line("bus.write16(" + addr + ", " + src + ");");
+        break;
+    case IrOp::Push16:
+        line("sp -= 2; bus.write16(sp, " + src + ");");
+        break;
+    case IrOp::Pop16:
+        setPair(inst.dst, "bus.read16(sp)");
+        line("sp += 2;");
+        break;
+    case IrOp::Exchange:
+        line("std::swap(d, h); std::swap(e, l);");
+        break;
+    case IrOp::Alu8:
+        line("a = Z80Alu::alu8(" + sub + ", a, " + src + ", " + f + ");");
+        break;
+    case IrOp::Inc8:
+        line(dst + " = Z80Alu::inc8(" + dst + ", " + f + ");");
+        break;
+    case IrOp::Dec8:
+        line(dst + " = Z80Alu::dec8(" + dst + ", " + f + ");");
+        break;
+    case IrOp::Add16:
+        setPair(inst.dst, "Z80Alu::add16(" + dst + ", " + src + ", " + f + ")");
+        break;
+    case IrOp::Rotate:
+        line(std::string("a = Z80Alu::") + ROTATES[inst.sub & 3] + "(a, " + f + ");");
+        break;
+    case IrOp::Shift:
+        line(dst + " = Z80Alu::shift8(" + sub + ", " + dst + ", " + f + ");");
+        break;
+    case IrOp::Bit:
+        line("Z80Alu::bit(" + sub + ", " + src + ", " + f + ");");
+        break;
+    case IrOp::Daa:
+        line("a = Z80Alu::daa(a, " + f + ");");
+        break;
+    case IrOp::Cpl:
+        line("a = Z80Alu::cpl(a, " + f + ");");
+        break;
+    case IrOp::Scf:
+        line("Z80Alu::scf(a, " + f + ");");
+        break;
+    case IrOp::Ccf:
+        line("Z80Alu::ccf(a, " + f + ");");
+        break;
+    case IrOp::Inc16:
+        setPair(inst.dst, "static_cast<uint16_t>(" + dst + " + 1)");
+        break;
+    case IrOp::Dec16:
+        setPair(inst.dst, "static_cast<uint16_t>(" + dst + " - 1)");
+        break;
+    case IrOp::SetBit:
+        line(dst + " = static_cast<uint8_t>(" + dst + " | " + hex(1u << inst.sub) + ");");
+        break;
+    case IrOp::ResetBit:
+        line(dst + " = static_cast<uint8_t>(" + dst + " & " + hex(~(1u << inst.sub) & 0xFF) + ");");
+        break;
+    default:
+        break;
+    }
+
+    modified(irLiveWrites(inst));
+}
+
+
+void BlockEmitter::terminator(const IrInstruction& inst) {
+    const std::string taken = account(inst, inst.cycles);
+    const std::string not_taken = account(inst, inst.cycles_alt);
+    const std::string condition = "Z80Alu::condition(" + std::to_string(inst.sub) + ", f)";
+
+    switch (inst.op) {
+    case IrOp::JumpIf:
+    case IrOp::CallIf:
+    case IrOp::ReturnIf:
+        load(FLAGS);
+        break;
+    case IrOp::JumpIndirect:
+        load(irOperandSlots(inst.src));
+        break;
+    case IrOp::Djnz:
+        load(irSlotBit(IrReg::B));
+        line("b = static_cast<uint8_t>(b - 1);");
+        modified(irSlotBit(IrReg::B));
+        break;
+    default:
+        break;
+    }
+
+    // Stack terminators work on cpu.regs.sp once everything is written back
+    writeBack();
+    const std::string push = "cpu.regs.sp -= 2; bus.write16(cpu.regs.sp, " + hex(inst.next, 4) + "); ";
+    const std::string target = hex(inst.target, 4);
+    const std::string next = hex(inst.next, 4);
+    const std::string pop = "const uint16_t pc = bus.read16(cpu.regs.sp); cpu.regs.sp += 2; ";
+
+    switch (inst.op) {
+    case IrOp::Jump:
+        line(taken + "return " + target + ";");
+        break;
+    case IrOp::JumpIf:
+        line("if (" + condition + ") { " + taken + "return " + target + "; }");
+        line(not_taken + "return " + next + ";");
+        break;
+    case IrOp::JumpIndirect:
+        line(taken + "return " + value(inst.src) + ";");
+        break;
+    case IrOp::Call:
+    case IrOp::Restart:
+        line(push + taken + "return " + target + ";");
+        break;
+    case IrOp::CallIf:
+        line("if (" + condition + ") { " + push + taken + "return " + target + "; }");
+        line(not_taken + "return " + next + ";");
+        break;
+    case IrOp::Return:
+        line(pop + taken + "return pc;");
+        break;
+    case IrOp::ReturnIf:
+        line("if (" + condition + ") { " + pop + taken + "return pc; }");
+        line(not_taken + "return " + next + ";");
+        break;
+    case IrOp::Djnz:
+        line("if (b != 0) { " + taken + "return " + target + "; }");
+        line(not_taken + "return " + next + ";");
+        break;
+    case IrOp::Stop:
+        line(taken + "return cpu.regs.pc;");
+        break;
+    default:
+        line(taken + "return " + next + ";");
+        break;
+    }
+}
+
+
+void BlockEmitter::emit(const std::string& name, bool exported) {
+    // Only the locals the block touches are declared
+    uint16_t used = 0;
+    bool dead_flags = false;
+    for (const IrInstruction& inst : block.code) {
+        if (!inst.isBarrier())
+            used |= irLiveReads(inst) | irLiveWrites(inst);
+        dead_flags |= inst.flags_dead;
+    }
+    for (const IrInstruction& inst : block.code) {
+        if (inst.op == IrOp::JumpIf || inst.op == IrOp::CallIf || inst.op == IrOp::ReturnIf)
+            used |= FLAGS;
+        else if (inst.op == IrOp::Djnz)
+            used |= irSlotBit(IrReg::B);
+        else if (inst.op == IrOp::JumpIndirect)
+            used |= irOperandSlots(inst.src);
+    }
+
+    std::string bytes;
+    for (size_t slot = 0; slot < IR_SLOT_COUNT; ++slot)
+        if ((used & (1u << slot)) && slot != static_cast<size_t>(IrReg::SP) && slot != static_cast<size_t>(IrReg::T))
+            bytes += std::string(bytes.empty() ? "" : ", ") + SLOT_NAMES[slot];
+
+    out << "// " << hex(block.start, 4) << "-" << hex(block.end, 4) << ": " << block.source_instructions
+        << " instructions, " << block.interpreted << " interpreted\n";
+    out << (exported ? "uint16_t " : "static uint16_t ") << name << "(Z80Cpu& cpu) {\n";
+    line("[[maybe_unused]] MemoryBus& bus = cpu.bus();");
+    if (!bytes.empty())
+        line("uint8_t " + bytes + ";");
+    // A read-modify-write whose result is dead still loads the byte, for the bus access
+    if (used & irSlotBit(IrReg::T))
+        line("[[maybe_unused]] uint8_t t;");
+    if (used & irSlotBit(IrReg::SP))
+        line("uint16_t sp;");
+    if (dead_flags)
+        line("uint8_t dead_f = 0;");
+
+    forget();
+    accounted = 0;
+    for (size_t i = 0; i < block.code.size(); ++i) {
+        const IrInstruction& inst = block.code[i];
+        if (inst.isTerminator())
+            terminator(inst);
+        else
+            instruction(inst, i + 1 < block.code.size() ? &block.code[i + 1] : nullptr);
+    }
+    out << "}\n\n";
+}
+
+}   // namespace
+
+
+void emitZ80Block(std::ostream& out, const IrBlock& block, const std::string& name, bool exported) {
+    BlockEmitter(out, block).emit(name, exported);
+}
+
+
+static const SymbolTable& emitSymbols(const Z80EmitOptions& options) {
+    static const SymbolTable no_symbols;
+    return options.symbols ? *options.symbols : no_symbols;
+}
+
+
+static IrBlock lowerForEmit(const Z80BasicBlock& block, const Z80EmitOptions& options, Z80EmitStats& stats) {
+    IrBlock ir = lowerBlock(block);
+    if (options.optimize) {
+        const IrOptimizeStats optimized = optimizeIr(ir);
+        stats.optimized.folded += optimized.folded;
+        stats.optimized.removed += optimized.removed;
+        stats.optimized.merged += optimized.merged;
+    }
+
+    ++stats.blocks;
+    stats.source_instructions += ir.source_instructions;
+    stats.ir_instructions += ir.code.size();
+    stats.interpreted += ir.interpreted;
+    return ir;
+}
+
+
+static void emitBlockTable(std::ostream& out, const Z80Analysis& analysis, const SymbolTable& symbols) {
+    out << "\nstatic constexpr Z80GeneratedBlock GENERATED_BLOCKS[] = {\n";
+    for (const auto& [start, block] : analysis.blocks())
+        out << "    { " << hex(block.start, 4) << ", " << hex(block.end, 4) << ", " << symbols.functionName(start) << " },\n";
+    out << "};\n\n"
+        << "std::span<const Z80GeneratedBlock> z80GeneratedBlocks() {\n"
+        << "    return GENERATED_BLOCKS;\n"
+        << "}\n";
+}
+
+
+static const char* const GENERATED_HEADER =
+    "// Generated by PacmanRecomp from the analysed program ROM; do not edit.\n"
+    "#include <utility>\n"
+    "#include \"recomp/Z80BlockRuntime.hpp\"\n\n\n";
+
+
+Z80EmitStats emitZ80Program(const Z80Analysis& analysis, std::ostream& out, const Z80EmitOptions& options) {
+    const SymbolTable& symbols = emitSymbols(options);
+    Z80EmitStats stats;
+
+    out << GENERATED_HEADER;
+    for (const auto& [start, block] : analysis.blocks())
+        emitZ80Block(out, lowerForEmit(block, options, stats), symbols.functionName(start));
+
+    emitBlockTable(out, analysis, symbols);
+    return stats;
+}
+
+
+// ----- ONE FILE PER BLOCK -----
+
+std::string z80BlockFileName(uint16_t start) {
+    std::ostringstream name;
+    name << Z80_BLOCK_FILE_PREFIX << std::hex << std::setw(4) << std::setfill('0') << start << ".cpp";
+    return name.str();
+}
+
+
+static void emitBlockFile(const Z80BasicBlock& block, Z80EmittedFiles& files, const Z80EmitOptions& options,
+                          Z80EmitStats& stats) {
+    std::ostringstream out;
+    out << GENERATED_HEADER;
+    emitZ80Block(out, lowerForEmit(block, options, stats), emitSymbols(options).functionName(block.start), true);
+    files[z80BlockFileName(block.start)] = out.str();
+}
+
+
+static void emitTableFile(const Z80Analysis& analysis, Z80EmittedFiles& files, const Z80EmitOptions& options) {
+    const SymbolTable& symbols = emitSymbols(options);
+    std::ostringstream out;
+    out << GENERATED_HEADER;
+    for (const auto& [start, block] : analysis.blocks())
+        out << "uint16_t " << symbols.functionName(start) << "(Z80Cpu& cpu);\n";
+    emitBlockTable(out, analysis, symbols);
+    files[Z80_BLOCK_TABLE_FILE] = out.str();
+}
+
+
+Z80EmitStats emitZ80ProgramFiles(const Z80Analysis& analysis, Z80EmittedFiles& files, const Z80EmitOptions& options) {
+    Z80EmitStats stats;
+    files.clear();
+    for (const auto& [start, block] : analysis.blocks())
+        emitBlockFile(block, files, options, stats);
+    emitTableFile(analysis, files, options);
+    return stats;
+}
+
+
+Z80EmitStats emitZ80PatchedFiles(const Z80Analysis& analysis, const Z80PatchResult& patch, Z80EmittedFiles& files,
+                                 const Z80EmitOptions& options) {
+    Z80EmitStats stats;
+    for (uint16_t start : patch.removed_blocks)
+        files.erase(z80BlockFileName(start));
+    for (uint16_t start : patch.changed_blocks) {
+        std::map<uint16_t, Z80BasicBlock>::const_iterator it = analysis.blocks().find(start);
+        if (it != analysis.blocks().end())
+            emitBlockFile(it->second, files, options, stats);
+    }
+
+    // Starts, ends and names of every block live in the table, so it is always refreshed
+    emitTableFile(analysis, files, options);
+    return stats;
+}
+
+
+size_t writeZ80Files(const Z80EmittedFiles& files, const std::filesystem::path& directory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // Generated block files that are no longer part of the program
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error)) {
+        const std::string name = entry.path().filename().string();
+        if (name.starts_with(Z80_BLOCK_FILE_PREFIX) && !files.contains(name))
+            std::filesystem::remove(entry.path(), error);
+    }
+
+    size_t written = 0;
+    for (const auto& [name, contents] : files) {
+        const std::filesystem::path path = directory / name;
+
+        std::ifstream existing(path, std::ios::binary);
+        if (existing) {
+            const std::string current((std::istreambuf_iterator<char>(existing)), std::istreambuf_iterator<char>());
+            if (current == contents)
+                continue;
+        }
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            std::cerr << "Cannot write generated file " << path << "\n";
+            continue;
+        }
+        out << contents;
+        ++written;
+    }
+    return written;
+}
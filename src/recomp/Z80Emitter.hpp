@@ -0,0 +1,70 @@
+#ifndef Z80_EMITTER_HPP
+#define Z80_EMITTER_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <ostream>
+#include <string>
+#include "../core/SymbolTable.hpp"
+#include "../core/Z80Analysis.hpp"
+#include "Z80Ir.hpp"
+#include "Z80IrOptimizer.hpp"
+
+/* Z80Emitter writes C++ for IR blocks, one function per block (see Z80BlockRuntime.hpp).
+ *
+ * Registers live in host locals for the whole block. A register is loaded from
+ * cpu.regs right before its first read and stored back only if it was modified,
+ * at an exit or before the interpreter runs. Instructions with dead flags write
+ * a scratch local, so the host compiler can drop the flag arithmetic entirely.
+ *
+ * The program is written either as one translation unit, or as one file per block
+ * (z80_block_xxxx.cpp) plus the block table (z80_blocks.cpp). In the split form a
+ * patch only re-emits the blocks Z80Analysis::applyPatch() reports, and only files
+ * whose contents changed are written, so a rebuild only compiles those.
+ */
+
+struct Z80EmitOptions {
+    bool optimize = true;
+    const SymbolTable* symbols = nullptr;       // names the block functions
+};
+
+struct Z80EmitStats {
+    size_t blocks = 0;
+    size_t source_instructions = 0;
+    size_t ir_instructions = 0;                 // after optimization
+    size_t interpreted = 0;
+    IrOptimizeStats optimized;
+};
+
+
+// Writes 'uint16_t name(Z80Cpu& cpu)' for one block; static unless 'exported'
+void emitZ80Block(std::ostream& out, const IrBlock& block, const std::string& name, bool exported = false);
+
+// Lowers, optimizes and writes every analysed block plus the block table
+Z80EmitStats emitZ80Program(const Z80Analysis& analysis, std::ostream& out, const Z80EmitOptions& options = {});
+
+
+// ----- ONE FILE PER BLOCK -----
+
+// File name -> contents
+using Z80EmittedFiles = std::map<std::string, std::string>;
+
+inline constexpr const char* Z80_BLOCK_FILE_PREFIX = "z80_block_";
+inline constexpr const char* Z80_BLOCK_TABLE_FILE = "z80_blocks.cpp";
+
+std::string z80BlockFileName(uint16_t start);
+
+// Replaces 'files' with every analysed block plus the table
+Z80EmitStats emitZ80ProgramFiles(const Z80Analysis& analysis, Z80EmittedFiles& files, const Z80EmitOptions& options = {});
+
+// Re-emits the changed blocks of a patch, drops the removed ones and refreshes the table
+Z80EmitStats emitZ80PatchedFiles(const Z80Analysis& analysis, const Z80PatchResult& patch, Z80EmittedFiles& files,
+                                 const Z80EmitOptions& options = {});
+
+// Writes the files whose contents differ from disk and deletes block files no longer listed.
+// Returns the number of files written.
+size_t writeZ80Files(const Z80EmittedFiles& files, const std::filesystem::path& directory);
+
+
+#endif
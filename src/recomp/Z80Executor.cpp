@@ -0,0 +1,453 @@
+#include "Z80Executor.hpp"
+#include <algorithm>
+#include <utility>
+#include "../core/Z80Alu.hpp"
+#include "../core/Z80Analysis.hpp"
+#include "../core/Z80Decoder.hpp"
+#include "../utils/Crc32.hpp"
+#include "Z80IrOptimizer.hpp"
+
+
+namespace {
+
+// Register slots of one IR evaluation; 8-bit slots by IrReg, SP on its own
+struct IrRegisters {
+    std::array<uint8_t, IR_SLOT_COUNT> bytes{};
+    uint16_t sp = 0;
+    uint8_t dead_f = 0;
+
+    uint8_t& operator[](IrReg reg) { return bytes[static_cast<size_t>(reg)]; }
+
+    void load(const Z80Registers& regs) {
+        bytes = { regs.a, regs.f, regs.b, regs.c, regs.d, regs.e, regs.h, regs.l, 0, 0 };
+        sp = regs.sp;
+    }
+
+    void store(Z80Registers& regs) {
+        regs.a = bytes[0]; regs.f = bytes[1];
+        regs.b = bytes[2]; regs.c = bytes[3];
+        regs.d = bytes[4]; regs.e = bytes[5];
+        regs.h = bytes[6]; regs.l = bytes[7];
+        regs.sp = sp;
+    }
+
+    uint16_t get(const IrOperand& operand) const {
+        switch (operand.kind) {
+        case IrOperandKind::Reg8:
+            return bytes[operand.reg];
+        case IrOperandKind::Pair: {
+            const IrPair pair = static_cast<IrPair>(operand.reg);
+            if (pair == IrPair::SP)
+                return sp;
+            return static_cast<uint16_t>((bytes[static_cast<size_t>(irPairHigh(pair))] << 8) |
+                                         bytes[static_cast<size_t>(irPairLow(pair))]);
+        }
+        case IrOperandKind::Imm:
+            return operand.value;
+        default:
+            return 0;
+        }
+    }
+
+    void set(const IrOperand& operand, uint16_t value) {
+        if (operand.kind == IrOperandKind::Reg8) {
+            bytes[operand.reg] = static_cast<uint8_t>(value);
+            return;
+        }
+        const IrPair pair = static_cast<IrPair>(operand.reg);
+        if (pair == IrPair::SP) {
+            sp = value;
+            return;
+        }
+        bytes[static_cast<size_t>(irPairHigh(pair))] = static_cast<uint8_t>(value >> 8);
+        bytes[static_cast<size_t>(irPairLow(pair))] = static_cast<uint8_t>(value);
+    }
+};
+
+
+void account(Z80Cpu& cpu, const IrInstruction& inst, uint16_t cycles, uint16_t& accounted) {
+    cpu.total_cycles += static_cast<uint16_t>(cycles - accounted);
+    z80AdvanceRefresh(cpu.regs, inst.fetches);
+    accounted = cycles;
+}
+
+
+// Runs one translated block with the same semantics as its generated C++ would have
+uint16_t runIr(const IrBlock& block, Z80Cpu& cpu) {
+    MemoryBus& bus = cpu.bus();
+    IrRegisters r;
+    r.load(cpu.regs);
+    uint16_t accounted = 0;
+
+    for (size_t i = 0; i < block.code.size(); ++i) {
+        const IrInstruction& inst = block.code[i];
+        uint8_t& f = inst.flags_dead ? r.dead_f : r[IrReg::F];
+        if (inst.flags_dead && irFlagsAffectValue(inst))
+            r.dead_f = r[IrReg::F];
+
+        switch (inst.op) {
+        case IrOp::Move8:
+        case IrOp::Move16:
+            r.set(inst.dst, r.get(inst.src));
+            break;
+        case IrOp::Load8:
+            r.set(inst.dst, bus.read8(r.get(inst.addr)));
+            break;
+        case IrOp::Store8:
+            bus.write8(r.get(inst.addr), static_cast<uint8_t>(r.get(inst.src)));
+            break;
+        case IrOp::Load16:
+            r.set(inst.dst, bus.read16(r.get(inst.addr)));
+            break;
+        case IrOp::Store16:
+            bus.write16(r.get(inst.addr), r.get(inst.src));
+            break;
+        case IrOp::Push16:
+            r.sp -= 2;
+            bus.write16(r.sp, r.get(inst.src));
+            break;
+        case IrOp::Pop16:
+            r.set(inst.dst, bus.read16(r.sp));
+            r.sp += 2;
+            break;
+        case IrOp::Exchange:
+            std::swap(r[IrReg::D], r[IrReg::H]);
+            std::swap(r[IrReg::E], r[IrReg::L]);
+            break;
+        case IrOp::Alu8:
+            r[IrReg::A] = Z80Alu::alu8(inst.sub, r[IrReg::A], static_cast<uint8_t>(r.get(inst.src)), f);
+            break;
+        case IrOp::Inc8:
+            r.set(inst.dst, Z80Alu::inc8(static_cast<uint8_t>(r.get(inst.dst)), f));
+            break;
+        case IrOp::Dec8:
+            r.set(inst.dst, Z80Alu::dec8(static_cast<uint8_t>(r.get(inst.dst)), f));
+            break;
+        case IrOp::Add16:
+            r.set(inst.dst, Z80Alu::add16(r.get(inst.dst), r.get(inst.src), f));
+            break;
+        case IrOp::Rotate: {
+            constexpr uint8_t (*rotates[4])(uint8_t, uint8_t&) = { Z80Alu::rlca, Z80Alu::rrca, Z80Alu::rla, Z80Alu::rra };
+            r[IrReg::A] = rotates[inst.sub & 3](r[IrReg::A], f);
+            break;
+        }
+        case IrOp::Shift:
+            r.set(inst.dst, Z80Alu::shift8(inst.sub, static_cast<uint8_t>(r.get(inst.dst)), f));
+            break;
+        case IrOp::Bit:
+            Z80Alu::bit(inst.sub, static_cast<uint8_t>(r.get(inst.src)), f);
+            break;
+        case IrOp::Daa:
+            r[IrReg::A] = Z80Alu::daa(r[IrReg::A], f);
+            break;
+        case IrOp::Cpl:
+            r[IrReg::A] = Z80Alu::cpl(r[IrReg::A], f);
+            break;
+        case IrOp::Scf:
+            Z80Alu::scf(r[IrReg::A], f);
+            break;
+        case IrOp::Ccf:
+            Z80Alu::ccf(r[IrReg::A], f);
+            break;
+        case IrOp::Inc16:
+            r.set(inst.dst, static_cast<uint16_t>(r.get(inst.dst) + 1));
+            break;
+        case IrOp::Dec16:
+            r.set(inst.dst, static_cast<uint16_t>(r.get(inst.dst) - 1));
+            break;
+        case IrOp::SetBit:
+            r.set(inst.dst, static_cast<uint8_t>(r.get(inst.dst) | (1 << inst.sub)));
+            break;
+        case IrOp::ResetBit:
+            r.set(inst.dst, static_cast<uint8_t>(r.get(inst.dst) & ~(1 << inst.sub)));
+            break;
+
+        case IrOp::Interpret: {
+            r.store(cpu.regs);
+            account(cpu, inst, inst.cycles, accounted);
+            cpu.regs.pc = inst.address;
+            cpu.executeInstruction();
+            r.load(cpu.regs);
+            // An EI ending the block runs the instruction after it here, so the delay never leaks
+            const IrOp following = i + 1 < block.code.size() ? block.code[i + 1].op : IrOp::Stop;
+            if (following == IrOp::FallThrough && cpu.interruptDelayed()) {
+                cpu.step();
+                return cpu.regs.pc;
+            }
+            if (following != IrOp::Stop)
+                cpu.endInterruptDelay();
+            break;
+        }
+
+        default: {
+            // ----- TERMINATORS -----
+            if (inst.op == IrOp::Djnz)
+                --r[IrReg::B];
+            r.store(cpu.regs);
+
+            bool taken = true;
+            switch (inst.op) {
+            case IrOp::JumpIf:
+            case IrOp::CallIf:
+            case IrOp::ReturnIf:
+                taken = Z80Alu::condition(inst.sub, r[IrReg::F]);
+                break;
+            case IrOp::Djnz:
+                taken = r[IrReg::B] != 0;
+                break;
+            default:
+                break;
+            }
+
+            account(cpu, inst, taken ? inst.cycles : inst.cycles_alt, accounted);
+            if (!taken)
+                return inst.next;
+
+            switch (inst.op) {
+            case IrOp::Jump:
+            case IrOp::JumpIf:
+            case IrOp::Djnz:
+                return inst.target;
+            case IrOp::JumpIndirect:
+                return r.get(inst.src);
+            case IrOp::Call:
+            case IrOp::CallIf:
+            case IrOp::Restart:
+                cpu.regs.sp -= 2;
+                bus.write16(cpu.regs.sp, inst.next);
+                return inst.target;
+            case IrOp::Return:
+            case IrOp::ReturnIf: {
+                const uint16_t pc = bus.read16(cpu.regs.sp);
+                cpu.regs.sp += 2;
+                return pc;
+            }
+            case IrOp::Stop:
+                return cpu.regs.pc;
+            default:
+                return inst.next;
+            }
+        }
+        }
+    }
+
+    // Lowering always ends a block with a terminator
+    r.store(cpu.regs);
+    return cpu.regs.pc;
+}
+
+}   // namespace
+
+
+std::shared_ptr<const Z80BlockIndex> Z80Executor::indexBlocks(std::span<const Z80GeneratedBlock> blocks) {
+    auto index = std::make_shared<Z80BlockIndex>();
+    for (const Z80GeneratedBlock& block : blocks) {
+        if (block.start >= index->size())
+            index->resize(block.start + 1u);
+        (*index)[block.start] = block.run;
+    }
+    return index;
+}
+
+
+Z80Executor::Z80Executor(Z80Cpu& cpu, std::shared_ptr<const Z80BlockIndex> index)
+    : cpu(cpu), bus(cpu.bus()), static_blocks(index ? std::move(index) : std::make_shared<const Z80BlockIndex>()) {
+
+    // Pages sharing one backing store (Pac-Man mirrors 0x4000 at 0xC000) are one page for invalidation
+    for (size_t page = 0; page < MemoryBus::PAGE_COUNT; ++page) {
+        backing_page[page] = static_cast<uint8_t>(page);
+        const uint8_t* data = bus.pageData(static_cast<uint8_t>(page));
+        for (size_t first = 0; data && first < page; ++first) {
+            if (bus.pageData(static_cast<uint8_t>(first)) == data) {
+                backing_page[page] = static_cast<uint8_t>(first);
+                break;
+            }
+        }
+    }
+
+    watcher_slot = bus.attachWatcher(this);
+}
+
+
+Z80Executor::~Z80Executor() {
+    bus.detachWatcher(watcher_slot);
+}
+
+
+int Z80Executor::run(int cycles) {
+    const uint64_t start = cpu.total_cycles;
+
+    while (cpu.total_cycles - start < static_cast<uint64_t>(cycles)) {
+        const int left = cycles - static_cast<int>(cpu.total_cycles - start);
+
+        // A halted CPU idles in the interpreter until the interrupt
+        if (cpu.regs.halted && !cpu.interruptPending()) {
+            cpu.run(left);
+            continue;
+        }
+        // Interrupts are taken in the interpreter; so is the instruction after an EI still
+        // waiting when the block ran out (EI; EI)
+        if (cpu.interruptPending() || cpu.interruptDelayed()) {
+            cpu.step();
+            ++counters.steps;
+            continue;
+        }
+
+        const uint16_t pc = cpu.regs.pc;
+        const bool ram = bus.isWritable(static_cast<uint8_t>(pc >> MemoryBus::PAGE_SHIFT));
+
+        const Z80BlockIndex& index = *static_blocks;
+        if (!ram && pc < index.size() && index[pc]) {
+            cpu.regs.pc = index[pc](cpu);
+            ++counters.static_blocks;
+            continue;
+        }
+
+        const auto it = active.find(pc);
+        const IrBlock* block = it != active.end() ? it->second : translate(pc);
+        if (!block) {
+            cpu.step();
+            ++counters.steps;
+            continue;
+        }
+
+        cpu.regs.pc = runIr(*block, cpu);
+        ++counters.translated_blocks;
+        if (ram)
+            ++counters.ram_blocks;
+    }
+
+    return static_cast<int>(cpu.total_cycles - start);
+}
+
+
+const IrBlock* Z80Executor::translate(uint16_t pc) {
+    std::array<uint8_t, MAX_BLOCK_BYTES> bytes;
+    for (size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] = bus.peek8(static_cast<uint16_t>(pc + i));
+
+    Z80BasicBlock block;
+    block.start = pc;
+    uint16_t address = pc;
+    while (block.instructions.size() < MAX_BLOCK_INSTRUCTIONS) {
+        Z80DecodedInstruction inst;
+        if (!decodeZ80At(bytes, pc, address, inst))
+            break;
+        block.instructions.push_back(inst);
+        address = inst.nextAddress();
+        if (inst.endsBlock())
+            break;
+    }
+    if (block.instructions.empty())
+        return nullptr;
+    block.end = address;
+
+    const size_t length = static_cast<uint16_t>(block.end - pc);
+    const std::span<const uint8_t> source = std::span(bytes).first(length);
+    const uint64_t key = (static_cast<uint64_t>(pc) << 32) | crc32(source);
+
+    // The CRC only finds a candidate; a collision is translated again and replaces it
+    auto it = translations.find(key);
+    if (it != translations.end() && std::ranges::equal(it->second->source, source)) {
+        ++counters.reused;
+    }
+    else {
+        if (it == translations.end() && translations.size() >= MAX_TRANSLATIONS)
+            flush();
+
+        auto ir = std::make_unique<IrBlock>(lowerBlock(block));
+        optimizeIr(*ir);
+        ir->source.assign(source.begin(), source.end());
+        it = translations.insert_or_assign(key, std::move(ir)).first;
+        ++counters.translations;
+    }
+
+    active[pc] = it->second.get();
+    watch(pc, block.end);
+    return it->second.get();
+}
+
+
+// Traps writes to the RAM pages a new translation was decoded from
+void Z80Executor::watch(uint16_t start, uint16_t end) {
+    const uint16_t last = static_cast<uint16_t>(end - 1);
+    uint8_t page = static_cast<uint8_t>(start >> MemoryBus::PAGE_SHIFT);
+
+    while (true) {
+        if (bus.isWritable(page)) {
+            std::vector<uint16_t>& starts = page_blocks[backing_page[page]];
+            if (starts.empty()) {
+                for (size_t mirror = 0; mirror < MemoryBus::PAGE_COUNT; ++mirror)
+                    if (backing_page[mirror] == backing_page[page])
+                        bus.trapPage(watcher_slot, static_cast<uint8_t>(mirror), BUS_WRITE);
+            }
+            starts.push_back(start);
+        }
+        if (page == (last >> MemoryBus::PAGE_SHIFT))
+            break;
+        ++page;
+    }
+}
+
+
+// Drops 'start' from the other RAM pages it spans: left there, every translation of it
+// after an invalidation through 'written' would add it to those lists again
+void Z80Executor::unwatch(uint16_t start, uint16_t end, uint8_t written) {
+    const uint16_t last = static_cast<uint16_t>(end - 1);
+    uint8_t page = static_cast<uint8_t>(start >> MemoryBus::PAGE_SHIFT);
+
+    while (true) {
+        const uint8_t backing = backing_page[page];
+        if (bus.isWritable(page) && backing != written) {
+            std::vector<uint16_t>& starts = page_blocks[backing];
+            std::erase(starts, start);
+            if (starts.empty())
+                release(backing);
+        }
+        if (page == (last >> MemoryBus::PAGE_SHIFT))
+            break;
+        ++page;
+    }
+}
+
+
+void Z80Executor::release(uint8_t backing) {
+    for (size_t mirror = 0; mirror < MemoryBus::PAGE_COUNT; ++mirror)
+        if (backing_page[mirror] == backing)
+            bus.releasePage(watcher_slot, static_cast<uint8_t>(mirror), BUS_WRITE);
+}
+
+
+void Z80Executor::onWrite(uint16_t address, uint8_t) {
+    const uint8_t backing = backing_page[address >> MemoryBus::PAGE_SHIFT];
+    std::vector<uint16_t>& starts = page_blocks[backing];
+
+    for (uint16_t start : starts) {
+        const auto it = active.find(start);
+        if (it == active.end())
+            continue;
+        unwatch(start, it->second->end, backing);
+        active.erase(it);
+        ++counters.invalidations;
+    }
+    starts.clear();
+    release(backing);
+}
+
+
+size_t Z80Executor::watchedBlocks() const {
+    size_t count = 0;
+    for (const std::vector<uint16_t>& starts : page_blocks)
+        count += starts.size();
+    return count;
+}
+
+
+void Z80Executor::flush() {
+    active.clear();
+    translations.clear();
+    for (size_t page = 0; page < MemoryBus::PAGE_COUNT; ++page) {
+        page_blocks[page].clear();
+        bus.releasePage(watcher_slot, static_cast<uint8_t>(page), BUS_WRITE);
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef Z80_EXECUTOR_HPP
+#define Z80_EXECUTOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "../core/MemoryBus.hpp"
+#include "../core/Z80Cpu.hpp"
+#include "Z80BlockRuntime.hpp"
+#include "Z80Ir.hpp"
+
+/* Z80Executor runs the CPU block by block instead of instruction by instruction.
+ *
+ * At each block entry the PC picks the path:
+ *   - a generated block, when one starts there and the page is ROM
+ *   - otherwise a translation: the bytes at PC are decoded up to the next branch,
+ *     lowered and optimized to IR, and the IR is run by a small evaluator that
+ *     hands unsupported instructions to the interpreter
+ *   - interrupts and HALT go through Z80Cpu::step()
+ *
+ * This is what lets patched sets and homebrew run code copied to RAM (0x4C00+)
+ * or ROM the static analysis never reached.
+ *
+ * Translations are cached by start address and CRC-32 of their bytes. A
+ * translation on a RAM page traps writes to that page (and its mirrors); the
+ * first write deactivates every translation on the page, also on the other
+ * pages it spans, and releases the trap.
+ * When the same routine is copied there again, its bytes hash the same, the
+ * bytes kept with the IR compare equal, and the cached IR is reused instead of
+ * being lowered again. A block that writes
+ * over its own remaining bytes only sees the new code from its next entry.
+ */
+
+struct Z80ExecutorStats {
+    uint64_t static_blocks = 0;         // generated blocks run
+    uint64_t translated_blocks = 0;     // cached translations run
+    uint64_t ram_blocks = 0;            // of those, started on a RAM page
+    uint64_t steps = 0;                 // single interpreter steps (interrupts, HALT, undecodable)
+    uint64_t translations = 0;          // blocks lowered to IR
+    uint64_t reused = 0;                // translations found again by content hash
+    uint64_t invalidations = 0;         // translations deactivated by writes
+};
+
+
+// Generated block functions by start address; one index can serve many executors
+using Z80BlockIndex = std::vector<Z80BlockFunction>;
+
+
+class Z80Executor : private BusWatcher {
+    public:
+    static constexpr size_t MAX_BLOCK_BYTES = 64;
+    static constexpr size_t MAX_BLOCK_INSTRUCTIONS = 32;
+    static constexpr size_t MAX_TRANSLATIONS = 512;      // the whole cache is flushed beyond this
+
+    // 'blocks' are generated blocks for the ROM as mapped on the CPU's bus; may be empty
+    explicit Z80Executor(Z80Cpu& cpu, std::span<const Z80GeneratedBlock> blocks = {})
+        : Z80Executor(cpu, indexBlocks(blocks)) {}
+    Z80Executor(Z80Cpu& cpu, std::shared_ptr<const Z80BlockIndex> index);
+    ~Z80Executor() override;
+
+    Z80Executor(const Z80Executor&) = delete;
+    Z80Executor& operator=(const Z80Executor&) = delete;
+
+    // Runs like Z80Cpu::run(): whole blocks until at least 'cycles' T-states have run
+    int run(int cycles);
+
+    // Drops every translation, e.g. after memory was changed behind the bus
+    void flush();
+
+    static std::shared_ptr<const Z80BlockIndex> indexBlocks(std::span<const Z80GeneratedBlock> blocks);
+
+    const Z80ExecutorStats& stats() const { return counters; }
+    size_t cachedTranslations() const { return translations.size(); }
+    size_t watchedBlocks() const;       // active translations per RAM page they span, summed
+
+    private:
+    void onWrite(uint16_t address, uint8_t value) override;
+
+    const IrBlock* translate(uint16_t pc);
+    void watch(uint16_t start, uint16_t end);
+    void unwatch(uint16_t start, uint16_t end, uint8_t written);
+    void release(uint8_t backing);
+
+    Z80Cpu& cpu;
+    MemoryBus& bus;
+    int watcher_slot = -1;
+
+    std::shared_ptr<const Z80BlockIndex> static_blocks;          // never null
+    std::unordered_map<uint64_t, std::unique_ptr<IrBlock>> translations;     // (address << 32) | crc
+    std::unordered_map<uint16_t, const IrBlock*> active;        // current translation per address
+
+    // Writes are tracked per backing page, so a mirror of a RAM page invalidates it too
+    std::array<uint8_t, MemoryBus::PAGE_COUNT> backing_page{};
+    std::array<std::vector<uint16_t>, MemoryBus::PAGE_COUNT> page_blocks;    // active starts per backing page spanned
+
+    Z80ExecutorStats counters;
+};
+
+
+#endif
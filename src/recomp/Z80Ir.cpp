@@ -0,0 +1,593 @@
+#include "Z80Ir.hpp"
+#include <iomanip>
+#include "../core/Z80Timing.hpp"
+
+
+// r field of an opcode: B C D E H L (HL) A; (HL) is handled by the caller
+static constexpr IrReg REG8[8] = { IrReg::B, IrReg::C, IrReg::D, IrReg::E, IrReg::H, IrReg::L, IrReg::T, IrReg::A };
+
+// p field: BC DE HL SP, or AF for PUSH/POP
+static IrPair pairField(uint8_t p, bool af) {
+    constexpr IrPair pairs[4] = { IrPair::BC, IrPair::DE, IrPair::HL, IrPair::SP };
+    return (p == 3 && af) ? IrPair::AF : pairs[p & 3];
+}
+
+
+namespace {
+
+class Lowering {
+    public:
+    explicit Lowering(IrBlock& block) : block(block) {}
+
+    void lower(const Z80DecodedInstruction& inst);
+    void finish(uint16_t next);
+    bool terminated() const { return !block.code.empty() && block.code.back().isTerminator(); }
+
+    private:
+    IrInstruction make(IrOp op, const Z80DecodedInstruction& inst) const {
+        IrInstruction ir;
+        ir.op = op;
+        ir.address = inst.address;
+        ir.next = inst.nextAddress();
+        ir.target = inst.target;
+        return ir;
+    }
+
+    void emit(const IrInstruction& ir) { block.code.push_back(ir); }
+
+    // Terminators carry the static cost of the whole block for both outcomes
+    void terminate(IrInstruction ir, uint32_t taken, uint32_t not_taken) {
+        ir.cycles = static_cast<uint16_t>(cycles + taken);
+        ir.cycles_alt = static_cast<uint16_t>(cycles + not_taken);
+        ir.fetches = static_cast<uint8_t>(fetches + 1);
+        emit(ir);
+    }
+
+    void interpret(const Z80DecodedInstruction& inst);
+    void lowerMain(const Z80DecodedInstruction& inst);
+    void lowerCb(const Z80DecodedInstruction& inst);
+
+    IrBlock& block;
+    uint32_t cycles = 0;        // static T-states of the lowered (not interpreted) instructions
+    uint32_t fetches = 0;       // opcode fetches since the last barrier
+};
+
+
+void Lowering::lower(const Z80DecodedInstruction& inst) {
+    ++block.source_instructions;
+
+    switch (inst.prefix) {
+    case Z80Prefix::None:
+        lowerMain(inst);
+        break;
+    case Z80Prefix::CB:
+        lowerCb(inst);
+        break;
+    default:
+        interpret(inst);
+        break;
+    }
+}
+
+
+void Lowering::interpret(const Z80DecodedInstruction& inst) {
+    IrInstruction ir = make(IrOp::Interpret, inst);
+    ir.cycles = static_cast<uint16_t>(cycles);
+    ir.fetches = static_cast<uint8_t>(fetches);
+    emit(ir);
+    fetches = 0;
+    ++block.interpreted;
+
+    // Control flow done by the interpreter ends the block where it left PC;
+    // so do LDIR/CPIR/INIR/OTIR and friends, which repeat by moving PC back
+    const bool repeats = inst.prefix == Z80Prefix::ED && (inst.opcode & 0xF4) == 0xB0;
+    if (inst.flow != Z80Flow::Next || repeats) {
+        IrInstruction stop = make(IrOp::Stop, inst);
+        stop.cycles = stop.cycles_alt = static_cast<uint16_t>(cycles);
+        emit(stop);
+    }
+}
+
+
+void Lowering::finish(uint16_t next) {
+    if (terminated())
+        return;
+
+    IrInstruction ir;
+    ir.op = IrOp::FallThrough;
+    ir.address = ir.next = next;
+    ir.cycles = ir.cycles_alt = static_cast<uint16_t>(cycles);
+    ir.fetches = static_cast<uint8_t>(fetches);
+    emit(ir);
+}
+
+
+void Lowering::lowerMain(const Z80DecodedInstruction& inst) {
+    const uint8_t op = inst.opcode;
+    const uint8_t x = op >> 6;
+    const uint8_t y = (op >> 3) & 7;
+    const uint8_t z = op & 7;
+    const uint8_t p = y >> 1;
+    const uint8_t q = y & 1;
+    const uint32_t base = Z80_MAIN_CYCLES[op];
+
+    // Returns true when the instruction was lowered and adds its cost;
+    // terminators and the interpreter fallback account for themselves
+    auto simple = [&](std::initializer_list<IrInstruction> code) {
+        for (const IrInstruction& ir : code)
+            emit(ir);
+        cycles += base;
+        ++fetches;
+    };
+
+    IrInstruction ir = make(IrOp::Move8, inst);
+
+    switch (x) {
+    case 1: {
+        // ----- LD r,r' -----
+        if (op == 0x76) {
+            interpret(inst);
+            return;
+        }
+        if (z == 6) {
+            ir.op = IrOp::Load8;
+            ir.dst = IrOperand::reg8(REG8[y]);
+            ir.addr = IrOperand::pair(IrPair::HL);
+        }
+        else if (y == 6) {
+            ir.op = IrOp::Store8;
+            ir.addr = IrOperand::pair(IrPair::HL);
+            ir.src = IrOperand::reg8(REG8[z]);
+        }
+        else {
+            ir.dst = IrOperand::reg8(REG8[y]);
+            ir.src = IrOperand::reg8(REG8[z]);
+        }
+        simple({ ir });
+        return;
+    }
+
+    case 2: {
+        // ----- ALU A,r -----
+        IrInstruction alu = make(IrOp::Alu8, inst);
+        alu.sub = y;
+        alu.src = IrOperand::reg8(REG8[z]);
+        if (z == 6) {
+            ir.op = IrOp::Load8;
+            ir.dst = IrOperand::reg8(IrReg::T);
+            ir.addr = IrOperand::pair(IrPair::HL);
+            simple({ ir, alu });
+        }
+        else {
+            simple({ alu });
+        }
+        return;
+    }
+
+    case 0:
+        switch (z) {
+        case 0:
+            switch (y) {
+            case 0:
+                simple({});
+                return;
+            case 1:
+                interpret(inst);        // EX AF,AF'
+                return;
+            case 2:
+                terminate(make(IrOp::Djnz, inst), 13, 8);
+                return;
+            case 3:
+                terminate(make(IrOp::Jump, inst), 12, 12);
+                return;
+            default:
+                ir = make(IrOp::JumpIf, inst);
+                ir.sub = static_cast<uint8_t>(y - 4);
+                terminate(ir, 12, 7);
+                return;
+            }
+
+        case 1:
+            if (q == 0) {
+                ir.op = IrOp::Move16;
+                ir.dst = IrOperand::pair(pairField(p, false));
+                ir.src = IrOperand::imm(inst.operand);
+            }
+            else {
+                ir.op = IrOp::Add16;
+                ir.dst = IrOperand::pair(IrPair::HL);
+                ir.src = IrOperand::pair(pairField(p, false));
+            }
+            simple({ ir });
+            return;
+
+        case 2: {
+            // LD (BC),A  LD A,(BC)  LD (DE),A  LD A,(DE)  LD (nn),HL  LD HL,(nn)  LD (nn),A  LD A,(nn)
+            const IrOperand address = y < 4 ? IrOperand::pair(y < 2 ? IrPair::BC : IrPair::DE)
+                                            : IrOperand::imm(inst.operand);
+            ir.addr = address;
+            if (y == 4 || y == 5) {
+                ir.op = y == 4 ? IrOp::Store16 : IrOp::Load16;
+                (y == 4 ? ir.src : ir.dst) = IrOperand::pair(IrPair::HL);
+            }
+            else {
+                ir.op = q ? IrOp::Load8 : IrOp::Store8;
+                (q ? ir.dst : ir.src) = IrOperand::reg8(IrReg::A);
+            }
+            simple({ ir });
+            return;
+        }
+
+        case 3:
+            ir.op = q ? IrOp::Dec16 : IrOp::Inc16;
+            ir.dst = IrOperand::pair(pairField(p, false));
+            simple({ ir });
+            return;
+
+        case 4:
+        case 5: {
+            IrInstruction step = make(z == 4 ? IrOp::Inc8 : IrOp::Dec8, inst);
+            step.dst = IrOperand::reg8(REG8[y]);
+            if (y == 6) {
+                IrInstruction load = make(IrOp::Load8, inst);
+                load.dst = IrOperand::reg8(IrReg::T);
+                load.addr = IrOperand::pair(IrPair::HL);
+                IrInstruction store = make(IrOp::Store8, inst);
+                store.addr = IrOperand::pair(IrPair::HL);
+                store.src = IrOperand::reg8(IrReg::T);
+                simple({ load, step, store });
+            }
+            else {
+                simple({ step });
+            }
+            return;
+        }
+
+        case 6:
+            if (y == 6) {
+                ir.op = IrOp::Store8;
+                ir.addr = IrOperand::pair(IrPair::HL);
+            }
+            else {
+                ir.dst = IrOperand::reg8(REG8[y]);
+            }
+            ir.src = IrOperand::imm(inst.operand & 0xFF);
+            simple({ ir });
+            return;
+
+        default: {
+            constexpr IrOp misc[4] = { IrOp::Daa, IrOp::Cpl, IrOp::Scf, IrOp::Ccf };
+            ir.op = y < 4 ? IrOp::Rotate : misc[y - 4];
+            ir.sub = y;
+            simple({ ir });
+            return;
+        }
+        }
+
+    default:
+        switch (z) {
+        case 0:
+            ir = make(IrOp::ReturnIf, inst);
+            ir.sub = y;
+            terminate(ir, 11, 5);
+            return;
+
+        case 1:
+            if (q == 0) {
+                ir.op = IrOp::Pop16;
+                ir.dst = IrOperand::pair(pairField(p, true));
+                simple({ ir });
+                return;
+            }
+            switch (p) {
+            case 0:
+                terminate(make(IrOp::Return, inst), 10, 10);
+                return;
+            case 2:
+                ir = make(IrOp::JumpIndirect, inst);
+                ir.src = IrOperand::pair(IrPair::HL);
+                terminate(ir, 4, 4);
+                return;
+            case 3:
+                ir.op = IrOp::Move16;
+                ir.dst = IrOperand::pair(IrPair::SP);
+                ir.src = IrOperand::pair(IrPair::HL);
+                simple({ ir });
+                return;
+            default:
+                interpret(inst);        // EXX
+                return;
+            }
+
+        case 2:
+            ir = make(IrOp::JumpIf, inst);
+            ir.sub = y;
+            terminate(ir, 10, 10);
+            return;
+
+        case 3:
+            if (y == 0) {
+                terminate(make(IrOp::Jump, inst), 10, 10);
+            }
+            else if (y == 5) {
+                ir.op = IrOp::Exchange;
+                simple({ ir });
+            }
+            else {
+                interpret(inst);        // OUT, IN, EX (SP),HL, DI, EI
+            }
+            return;
+
+        case 4:
+            ir = make(IrOp::CallIf, inst);
+            ir.sub = y;
+            terminate(ir, 17, 10);
+            return;
+
+        case 5:
+            if (q == 0) {
+                ir.op = IrOp::Push16;
+                ir.src = IrOperand::pair(pairField(p, true));
+                simple({ ir });
+            }
+            else {
+                terminate(make(IrOp::Call, inst), 17, 17);
+            }
+            return;
+
+        case 6:
+            ir.op = IrOp::Alu8;
+            ir.sub = y;
+            ir.src = IrOperand::imm(inst.operand & 0xFF);
+            simple({ ir });
+            return;
+
+        default:
+            terminate(make(IrOp::Restart, inst), 11, 11);
+            return;
+        }
+    }
+}
+
+
+void Lowering::lowerCb(const Z80DecodedInstruction& inst) {
+    const uint8_t op = inst.opcode;
+    const uint8_t x = op >> 6;
+    const uint8_t y = (op >> 3) & 7;
+    const uint8_t z = op & 7;
+
+    constexpr IrOp ops[4] = { IrOp::Shift, IrOp::Bit, IrOp::ResetBit, IrOp::SetBit };
+    IrInstruction ir = make(ops[x], inst);
+    ir.sub = y;
+    (x == 1 ? ir.src : ir.dst) = IrOperand::reg8(REG8[z]);
+
+    if (z == 6) {
+        IrInstruction load = make(IrOp::Load8, inst);
+        load.dst = IrOperand::reg8(IrReg::T);
+        load.addr = IrOperand::pair(IrPair::HL);
+        emit(load);
+        emit(ir);
+        if (x != 1) {
+            IrInstruction store = make(IrOp::Store8, inst);
+            store.addr = IrOperand::pair(IrPair::HL);
+            store.src = IrOperand::reg8(IrReg::T);
+            emit(store);
+        }
+    }
+    else {
+        emit(ir);
+    }
+
+    cycles += z80CbCycles(op);
+    fetches += 2;
+}
+
+}   // namespace
+
+
+IrBlock lowerBlock(const Z80BasicBlock& block) {
+    IrBlock ir;
+    ir.start = block.start;
+    ir.end = block.end;
+
+    Lowering lowering(ir);
+    for (const Z80DecodedInstruction& inst : block.instructions) {
+        if (lowering.terminated())
+            break;
+        lowering.lower(inst);
+    }
+    lowering.finish(block.end);
+    return ir;
+}
+
+
+// ----- SLOT USE -----
+
+uint16_t irOperandSlots(const IrOperand& operand) {
+    switch (operand.kind) {
+    case IrOperandKind::Reg8:
+        return irSlotBit(static_cast<IrReg>(operand.reg));
+    case IrOperandKind::Pair: {
+        const IrPair pair = static_cast<IrPair>(operand.reg);
+        return irSlotBit(irPairHigh(pair)) | irSlotBit(irPairLow(pair));
+    }
+    default:
+        return 0;
+    }
+}
+
+static constexpr uint16_t ALL_REGISTERS = 0x3FF & ~irSlotBit(IrReg::T);
+static constexpr uint16_t FLAGS = irSlotBit(IrReg::F);
+
+
+uint16_t irReads(const IrInstruction& inst) {
+    const uint16_t src = irOperandSlots(inst.src);
+    const uint16_t dst = irOperandSlots(inst.dst);
+    const uint16_t addr = irOperandSlots(inst.addr);
+    const uint16_t a = irSlotBit(IrReg::A);
+    const uint16_t sp = irSlotBit(IrReg::SP);
+
+    switch (inst.op) {
+    case IrOp::Move8:
+    case IrOp::Move16:
+        return src;
+    case IrOp::Load8:
+    case IrOp::Load16:
+        return addr;
+    case IrOp::Store8:
+    case IrOp::Store16:
+        return addr | src;
+    case IrOp::Push16:
+        return src | sp;
+    case IrOp::Pop16:
+        return sp;
+    case IrOp::Exchange:
+        return irOperandSlots(IrOperand::pair(IrPair::DE)) | irOperandSlots(IrOperand::pair(IrPair::HL));
+    case IrOp::Alu8:
+        return a | src | (inst.sub == 1 || inst.sub == 3 ? FLAGS : 0);
+    case IrOp::Inc8:
+    case IrOp::Dec8:
+    case IrOp::Shift:
+        return dst | FLAGS;
+    case IrOp::Add16:
+        return dst | src | FLAGS;
+    case IrOp::Rotate:
+    case IrOp::Daa:
+    case IrOp::Cpl:
+    case IrOp::Scf:
+    case IrOp::Ccf:
+        return a | FLAGS;
+    case IrOp::Bit:
+        return src | FLAGS;
+    case IrOp::Inc16:
+    case IrOp::Dec16:
+    case IrOp::SetBit:
+    case IrOp::ResetBit:
+        return dst;
+    default:
+        // Barriers hand every register to the interpreter or the next block
+        return ALL_REGISTERS;
+    }
+}
+
+
+uint16_t irWrites(const IrInstruction& inst) {
+    const uint16_t dst = irOperandSlots(inst.dst);
+    const uint16_t a = irSlotBit(IrReg::A);
+    const uint16_t sp = irSlotBit(IrReg::SP);
+
+    switch (inst.op) {
+    case IrOp::Move8:
+    case IrOp::Move16:
+    case IrOp::Load8:
+    case IrOp::Load16:
+    case IrOp::Inc16:
+    case IrOp::Dec16:
+    case IrOp::SetBit:
+    case IrOp::ResetBit:
+        return dst;
+    case IrOp::Store8:
+    case IrOp::Store16:
+        return 0;
+    case IrOp::Push16:
+        return sp;
+    case IrOp::Pop16:
+        return dst | sp;
+    case IrOp::Exchange:
+        return irOperandSlots(IrOperand::pair(IrPair::DE)) | irOperandSlots(IrOperand::pair(IrPair::HL));
+    case IrOp::Alu8:
+        return a | FLAGS;
+    case IrOp::Inc8:
+    case IrOp::Dec8:
+    case IrOp::Shift:
+    case IrOp::Add16:
+        return dst | FLAGS;
+    case IrOp::Rotate:
+    case IrOp::Daa:
+    case IrOp::Cpl:
+        return a | FLAGS;
+    case IrOp::Scf:
+    case IrOp::Ccf:
+    case IrOp::Bit:
+        return FLAGS;
+    case IrOp::Interpret:
+        return ALL_REGISTERS;
+    case IrOp::Djnz:
+        return irSlotBit(IrReg::B);
+    case IrOp::Call:
+    case IrOp::CallIf:
+    case IrOp::Return:
+    case IrOp::ReturnIf:
+    case IrOp::Restart:
+        return sp;
+    default:
+        return 0;
+    }
+}
+
+
+bool irFlagsAffectValue(const IrInstruction& inst) {
+    switch (inst.op) {
+    case IrOp::Alu8:
+        return inst.sub == 1 || inst.sub == 3;      // ADC, SBC
+    case IrOp::Shift:
+        return inst.sub == 2 || inst.sub == 3;      // RL, RR
+    case IrOp::Rotate:
+        return inst.sub == 2 || inst.sub == 3;      // RLA, RRA
+    case IrOp::Daa:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+// ----- DUMP -----
+
+static const char* const OP_NAMES[] = {
+    "move8", "move16", "load8", "store8", "load16", "store16", "push16", "pop16", "exchange",
+    "alu8", "inc8", "dec8", "add16", "rotate", "shift", "bit", "daa", "cpl", "scf", "ccf",
+    "inc16", "dec16", "set", "res",
+    "interpret",
+    "jump", "jump_if", "jump_indirect", "call", "call_if", "return", "return_if", "djnz", "restart",
+    "fall_through", "stop"
+};
+
+static void dumpOperand(std::ostream& out, const IrOperand& operand) {
+    static const char* const regs[] = { "a", "f", "b", "c", "d", "e", "h", "l", "t", "sp" };
+    static const char* const pairs[] = { "af", "bc", "de", "hl", "sp" };
+
+    switch (operand.kind) {
+    case IrOperandKind::Reg8: out << " " << regs[operand.reg]; break;
+    case IrOperandKind::Pair: out << " " << pairs[operand.reg]; break;
+    case IrOperandKind::Imm: out << " #" << std::hex << operand.value << std::dec; break;
+    default: break;
+    }
+}
+
+
+void dumpIr(std::ostream& out, const IrBlock& block) {
+    const std::ios_base::fmtflags flags = out.flags();
+
+    for (const IrInstruction& inst : block.code) {
+        out << std::hex << std::setw(4) << std::setfill('0') << inst.address << std::dec << "  "
+            << OP_NAMES[static_cast<size_t>(inst.op)];
+        if (inst.sub)
+            out << "." << static_cast<int>(inst.sub);
+        dumpOperand(out, inst.dst);
+        dumpOperand(out, inst.src);
+        if (inst.addr.kind != IrOperandKind::None) {
+            out << " [";
+            dumpOperand(out, inst.addr);
+            out << " ]";
+        }
+        if (inst.isTerminator())
+            out << " -> " << std::hex << inst.target << "/" << inst.next << std::dec
+                << " (" << inst.cycles << "/" << inst.cycles_alt << " T)";
+        if (inst.flags_dead)
+            out << " ; flags dead";
+        out << "\n";
+    }
+
+    out.flags(flags);
+}
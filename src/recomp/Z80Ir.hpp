@@ -0,0 +1,164 @@
+#ifndef Z80_IR_HPP
+#define Z80_IR_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "../core/Z80Analysis.hpp"
+
+/* Z80Ir sits between the decoded instructions of a basic block and the C++ emitter.
+ *
+ * Each IR instruction reads and writes register slots (the eight 8-bit registers,
+ * SP and one scratch byte), immediates or memory through the bus. Register pairs
+ * are views on two 8-bit slots, so passes can reason about halves and pairs alike.
+ * A block is straight-line code that ends in exactly one terminator.
+ *
+ * Instructions the IR does not model (IX/IY, ED, I/O, EXX, EI/DI, HALT ...) become
+ * Interpret: the emitter writes every modified slot back to the CPU, lets the
+ * interpreter run that one instruction and reloads what it needs afterwards.
+ */
+
+enum class IrReg : uint8_t {
+    A, F, B, C, D, E, H, L,
+    T,          // scratch byte for read-modify-write through memory, never written back
+    SP,         // 16-bit slot
+    Count
+};
+
+constexpr size_t IR_SLOT_COUNT = static_cast<size_t>(IrReg::Count);
+
+enum class IrPair : uint8_t {
+    AF, BC, DE, HL, SP
+};
+
+enum class IrOperandKind : uint8_t {
+    None,
+    Reg8,
+    Pair,
+    Imm
+};
+
+struct IrOperand {
+    IrOperandKind kind = IrOperandKind::None;
+    uint8_t reg = 0;            // IrReg or IrPair
+    uint16_t value = 0;         // immediate
+
+    static IrOperand reg8(IrReg r) { return { IrOperandKind::Reg8, static_cast<uint8_t>(r), 0 }; }
+    static IrOperand pair(IrPair p) { return { IrOperandKind::Pair, static_cast<uint8_t>(p), 0 }; }
+    static IrOperand imm(uint16_t v) { return { IrOperandKind::Imm, 0, v }; }
+
+    bool isReg8(IrReg r) const { return kind == IrOperandKind::Reg8 && reg == static_cast<uint8_t>(r); }
+    bool isPair(IrPair p) const { return kind == IrOperandKind::Pair && reg == static_cast<uint8_t>(p); }
+    bool isImm() const { return kind == IrOperandKind::Imm; }
+};
+
+enum class IrOp : uint8_t {
+    // ----- DATA -----
+    Move8,          // dst = src
+    Move16,         // dst pair = src
+    Load8,          // dst = mem[addr]
+    Store8,         // mem[addr] = src
+    Load16,         // dst pair = mem16[addr]
+    Store16,        // mem16[addr] = src
+    Push16,         // SP -= 2, mem16[SP] = src
+    Pop16,          // dst pair = mem16[SP], SP += 2
+    Exchange,       // EX DE,HL
+
+    // ----- ARITHMETIC (write F) -----
+    Alu8,           // A = alu(sub, A, src), sub is the opcode's ALU field
+    Inc8,           // dst = dst + 1
+    Dec8,           // dst = dst - 1
+    Add16,          // dst pair = dst + src
+    Rotate,         // A = RLCA/RRCA/RLA/RRA (sub 0-3) of A
+    Shift,          // dst = CB rotate/shift 'sub' of dst
+    Bit,            // flags from bit 'sub' of src
+    Daa,
+    Cpl,
+    Scf,
+    Ccf,
+
+    // ----- NO FLAGS -----
+    Inc16,          // dst pair += 1
+    Dec16,          // dst pair -= 1
+    SetBit,         // dst |= 1 << sub
+    ResetBit,       // dst &= ~(1 << sub)
+
+    // ----- INTERPRETER -----
+    Interpret,      // run the instruction at 'address' in the interpreter
+
+    // ----- TERMINATORS -----
+    Jump,           // PC = target
+    JumpIf,         // condition 'sub': PC = target, else next
+    JumpIndirect,   // PC = src pair
+    Call,           // push next, PC = target
+    CallIf,
+    Return,
+    ReturnIf,
+    Djnz,           // --B != 0: PC = target, else next
+    Restart,        // push next, PC = target
+    FallThrough,    // PC = next
+    Stop            // the interpreter already set PC (Interpret as the last instruction)
+};
+
+struct IrInstruction {
+    IrOp op = IrOp::Move8;
+    uint8_t sub = 0;                // ALU/shift/rotate field, bit number or condition
+    IrOperand dst;
+    IrOperand src;
+    IrOperand addr;                 // memory address for Load/Store
+    uint16_t address = 0;           // Z80 address of the instruction this came from
+    uint16_t next = 0;              // address after it
+    uint16_t target = 0;            // branch target
+
+    // Set on Interpret and terminators, which are the only places that leave the block:
+    uint16_t cycles = 0;            // static T-states up to here (taken path for terminators)
+    uint16_t cycles_alt = 0;        // terminators: T-states of the not-taken path
+    uint8_t fetches = 0;            // opcode fetches (R increments) since the previous barrier
+
+    bool flags_dead = false;        // F result is never read; set by the optimizer
+
+    bool isTerminator() const { return op >= IrOp::Jump; }
+    bool isBarrier() const { return op >= IrOp::Interpret; }
+};
+
+struct IrBlock {
+    uint16_t start = 0;
+    uint16_t end = 0;
+    std::vector<IrInstruction> code;
+    size_t source_instructions = 0;
+    size_t interpreted = 0;
+    std::vector<uint8_t> source;        // bytes start-end, kept by callers that cache blocks by content
+};
+
+
+// Builds the IR of one analysed block. Always succeeds; unsupported instructions become Interpret.
+IrBlock lowerBlock(const Z80BasicBlock& block);
+
+// Slots an operand names: one for a register, two for a pair, none for an immediate
+uint16_t irOperandSlots(const IrOperand& operand);
+
+// Slot bitmasks (bit = IrReg) an instruction reads and writes. Barriers read and write every register.
+uint16_t irReads(const IrInstruction& inst);
+uint16_t irWrites(const IrInstruction& inst);
+
+// Whether the F value going into an instruction changes its non-flag result (ADC, RL, DAA ...)
+bool irFlagsAffectValue(const IrInstruction& inst);
+
+// Human-readable dump, one instruction per line
+void dumpIr(std::ostream& out, const IrBlock& block);
+
+constexpr uint16_t irSlotBit(IrReg r) { return static_cast<uint16_t>(1u << static_cast<unsigned>(r)); }
+
+// High and low slot of a pair; SP has no halves
+inline IrReg irPairHigh(IrPair p) {
+    constexpr IrReg high[] = { IrReg::A, IrReg::B, IrReg::D, IrReg::H, IrReg::SP };
+    return high[static_cast<size_t>(p)];
+}
+
+inline IrReg irPairLow(IrPair p) {
+    constexpr IrReg low[] = { IrReg::F, IrReg::C, IrReg::E, IrReg::L, IrReg::SP };
+    return low[static_cast<size_t>(p)];
+}
+
+
+#endif
@@ -0,0 +1,448 @@
+#include "Z80IrOptimizer.hpp"
+#include <array>
+#include "../core/Z80Alu.hpp"
+
+
+static constexpr uint16_t FLAGS = irSlotBit(IrReg::F);
+static constexpr int32_t UNKNOWN = -1;
+
+using KnownValues = std::array<int32_t, IR_SLOT_COUNT>;
+
+
+uint16_t irLiveReads(const IrInstruction& inst) {
+    const uint16_t reads = irReads(inst);
+    if (inst.flags_dead && !irFlagsAffectValue(inst))
+        return reads & ~FLAGS;
+    return reads;
+}
+
+
+uint16_t irLiveWrites(const IrInstruction& inst) {
+    const uint16_t writes = irWrites(inst);
+    return inst.flags_dead ? (writes & ~FLAGS) : writes;
+}
+
+
+// Instructions that only touch registers and may be dropped when their results are dead
+static bool isRegisterOnly(IrOp op) {
+    switch (op) {
+    case IrOp::Move8:
+    case IrOp::Move16:
+    case IrOp::Exchange:
+    case IrOp::Alu8:
+    case IrOp::Inc8:
+    case IrOp::Dec8:
+    case IrOp::Add16:
+    case IrOp::Rotate:
+    case IrOp::Shift:
+    case IrOp::Bit:
+    case IrOp::Daa:
+    case IrOp::Cpl:
+    case IrOp::Scf:
+    case IrOp::Ccf:
+    case IrOp::Inc16:
+    case IrOp::Dec16:
+    case IrOp::SetBit:
+    case IrOp::ResetBit:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+// ----- FLAGS -----
+
+void markDeadFlags(IrBlock& block) {
+    uint16_t live = 0;
+
+    for (auto it = block.code.rbegin(); it != block.code.rend(); ++it) {
+        IrInstruction& inst = *it;
+        // Only flags computed by arithmetic; AF as a plain destination is left to dead code
+        const bool computed = !inst.dst.isPair(IrPair::AF) && !inst.dst.isReg8(IrReg::F);
+        if (!inst.isBarrier())
+            inst.flags_dead = computed && (irWrites(inst) & FLAGS) && !(live & FLAGS);
+        live = static_cast<uint16_t>((live & ~irLiveWrites(inst)) | irLiveReads(inst));
+    }
+}
+
+
+// ----- CONSTANTS -----
+
+static bool knownOperand(const IrOperand& operand, const KnownValues& known, uint16_t& value) {
+    switch (operand.kind) {
+    case IrOperandKind::Imm:
+        value = operand.value;
+        return true;
+    case IrOperandKind::Reg8: {
+        const int32_t v = known[operand.reg];
+        value = static_cast<uint16_t>(v);
+        return v != UNKNOWN;
+    }
+    case IrOperandKind::Pair: {
+        const IrPair pair = static_cast<IrPair>(operand.reg);
+        if (pair == IrPair::SP) {
+            value = static_cast<uint16_t>(known[static_cast<size_t>(IrReg::SP)]);
+            return known[static_cast<size_t>(IrReg::SP)] != UNKNOWN;
+        }
+        const int32_t high = known[static_cast<size_t>(irPairHigh(pair))];
+        const int32_t low = known[static_cast<size_t>(irPairLow(pair))];
+        value = static_cast<uint16_t>((high << 8) | low);
+        return high != UNKNOWN && low != UNKNOWN;
+    }
+    default:
+        return false;
+    }
+}
+
+
+static void substitute(IrOperand& operand, const KnownValues& known) {
+    uint16_t value = 0;
+    if (operand.kind != IrOperandKind::Imm && knownOperand(operand, known, value))
+        operand = IrOperand::imm(value);
+}
+
+
+// Records the result of an instruction that was evaluated at generation time
+static void setKnown(KnownValues& known, const IrOperand& dst, uint16_t value) {
+    if (dst.kind == IrOperandKind::Reg8) {
+        known[dst.reg] = static_cast<uint8_t>(value);
+        return;
+    }
+    const IrPair pair = static_cast<IrPair>(dst.reg);
+    if (pair == IrPair::SP) {
+        known[static_cast<size_t>(IrReg::SP)] = value;
+        return;
+    }
+    known[static_cast<size_t>(irPairHigh(pair))] = static_cast<uint8_t>(value >> 8);
+    known[static_cast<size_t>(irPairLow(pair))] = static_cast<uint8_t>(value);
+}
+
+
+static void forgetWrites(KnownValues& known, uint16_t writes) {
+    for (size_t slot = 0; slot < IR_SLOT_COUNT; ++slot)
+        if (writes & (1u << slot))
+            known[slot] = UNKNOWN;
+}
+
+
+static IrInstruction makeMove(const IrInstruction& from, IrOperand dst, uint16_t value) {
+    IrInstruction move;
+    move.op = dst.kind == IrOperandKind::Pair ? IrOp::Move16 : IrOp::Move8;
+    move.dst = dst;
+    move.src = IrOperand::imm(value);
+    move.address = from.address;
+    move.next = from.next;
+    return move;
+}
+
+
+// Computes an arithmetic instruction whose live inputs are all known.
+// Appends moves of the results to 'out'; returns false when it cannot.
+static bool evaluate(const IrInstruction& inst, KnownValues& known, std::vector<IrInstruction>& out) {
+    const uint16_t reads = irLiveReads(inst);
+    for (size_t slot = 0; slot < IR_SLOT_COUNT; ++slot)
+        if ((reads & (1u << slot)) && known[slot] == UNKNOWN)
+            return false;
+
+    const IrOperand a_reg = IrOperand::reg8(IrReg::A);
+    uint8_t a = static_cast<uint8_t>(known[static_cast<size_t>(IrReg::A)]);
+    uint8_t f = (reads & FLAGS) ? static_cast<uint8_t>(known[static_cast<size_t>(IrReg::F)]) : 0;
+    uint16_t src = 0;
+    uint16_t dst = 0;
+    knownOperand(inst.src, known, src);
+    knownOperand(inst.dst, known, dst);
+
+    IrOperand result_reg = inst.dst;
+    uint16_t result = 0;
+
+    switch (inst.op) {
+    case IrOp::Alu8:
+        result_reg = a_reg;
+        result = Z80Alu::alu8(inst.sub, a, static_cast<uint8_t>(src), f);
+        break;
+    case IrOp::Inc8:
+        result = Z80Alu::inc8(static_cast<uint8_t>(dst), f);
+        break;
+    case IrOp::Dec8:
+        result = Z80Alu::dec8(static_cast<uint8_t>(dst), f);
+        break;
+    case IrOp::Rotate: {
+        constexpr uint8_t (*rotates[4])(uint8_t, uint8_t&) = { Z80Alu::rlca, Z80Alu::rrca, Z80Alu::rla, Z80Alu::rra };
+        result_reg = a_reg;
+        result = rotates[inst.sub & 3](a, f);
+        break;
+    }
+    case IrOp::Shift:
+        result = Z80Alu::shift8(inst.sub, static_cast<uint8_t>(dst), f);
+        break;
+    case IrOp::Daa:
+        result_reg = a_reg;
+        result = Z80Alu::daa(a, f);
+        break;
+    case IrOp::Cpl:
+        result_reg = a_reg;
+        result = Z80Alu::cpl(a, f);
+        break;
+    case IrOp::Add16:
+        result = Z80Alu::add16(dst, src, f);
+        break;
+    case IrOp::Inc16:
+        result = static_cast<uint16_t>(dst + 1);
+        break;
+    case IrOp::Dec16:
+        result = static_cast<uint16_t>(dst - 1);
+        break;
+    case IrOp::SetBit:
+        result = static_cast<uint8_t>(dst | (1 << inst.sub));
+        break;
+    case IrOp::ResetBit:
+        result = static_cast<uint8_t>(dst & ~(1 << inst.sub));
+        break;
+    case IrOp::Scf:
+        result_reg = {};
+        Z80Alu::scf(a, f);
+        break;
+    case IrOp::Ccf:
+        result_reg = {};
+        Z80Alu::ccf(a, f);
+        break;
+    case IrOp::Bit:
+        result_reg = {};
+        Z80Alu::bit(inst.sub, static_cast<uint8_t>(src), f);
+        break;
+    default:
+        return false;
+    }
+
+    if (result_reg.kind != IrOperandKind::None) {
+        out.push_back(makeMove(inst, result_reg, result));
+        setKnown(known, result_reg, result);
+    }
+    if (irLiveWrites(inst) & FLAGS) {
+        out.push_back(makeMove(inst, IrOperand::reg8(IrReg::F), f));
+        known[static_cast<size_t>(IrReg::F)] = f;
+    }
+    return true;
+}
+
+
+// Resolves a conditional terminator whose condition is known
+static void foldBranch(IrInstruction& inst, bool taken) {
+    if (taken) {
+        constexpr IrOp unconditional[] = { IrOp::Jump, IrOp::Call, IrOp::Return };
+        inst.op = unconditional[inst.op == IrOp::JumpIf ? 0 : inst.op == IrOp::CallIf ? 1 : 2];
+        inst.cycles_alt = inst.cycles;
+    }
+    else {
+        inst.op = IrOp::FallThrough;
+        inst.cycles = inst.cycles_alt;
+    }
+    inst.sub = 0;
+}
+
+
+size_t foldConstants(IrBlock& block) {
+    KnownValues known;
+    known.fill(UNKNOWN);
+    std::vector<IrInstruction> out;
+    out.reserve(block.code.size());
+    size_t folded = 0;
+
+    for (IrInstruction inst : block.code) {
+        if (inst.isBarrier()) {
+            uint16_t value = 0;
+            switch (inst.op) {
+            case IrOp::JumpIf:
+            case IrOp::CallIf:
+            case IrOp::ReturnIf:
+                if (known[static_cast<size_t>(IrReg::F)] != UNKNOWN) {
+                    foldBranch(inst, Z80Alu::condition(inst.sub, static_cast<uint8_t>(known[static_cast<size_t>(IrReg::F)])));
+                    ++folded;
+                }
+                break;
+            case IrOp::JumpIndirect:
+                if (knownOperand(inst.src, known, value)) {
+                    inst.op = IrOp::Jump;
+                    inst.target = value;
+                    inst.src = {};
+                    ++folded;
+                }
+                break;
+            default:
+                break;
+            }
+            out.push_back(inst);
+            known.fill(UNKNOWN);
+            continue;
+        }
+
+        // Memory addresses and the values of stores and pushes become immediates
+        substitute(inst.addr, known);
+        switch (inst.op) {
+        case IrOp::Move8:
+        case IrOp::Move16:
+        case IrOp::Store8:
+        case IrOp::Store16:
+        case IrOp::Push16:
+        case IrOp::Alu8:
+        case IrOp::Bit:
+        case IrOp::Add16:
+            substitute(inst.src, known);
+            break;
+        default:
+            break;
+        }
+
+        if (inst.op == IrOp::Move8 || inst.op == IrOp::Move16) {
+            forgetWrites(known, irWrites(inst));
+            if (inst.src.isImm())
+                setKnown(known, inst.dst, inst.src.value);
+            out.push_back(inst);
+            continue;
+        }
+
+        if (inst.op == IrOp::Exchange) {
+            std::swap(known[static_cast<size_t>(IrReg::D)], known[static_cast<size_t>(IrReg::H)]);
+            std::swap(known[static_cast<size_t>(IrReg::E)], known[static_cast<size_t>(IrReg::L)]);
+            out.push_back(inst);
+            continue;
+        }
+
+        if (isRegisterOnly(inst.op) && evaluate(inst, known, out)) {
+            ++folded;
+            continue;
+        }
+
+        forgetWrites(known, irWrites(inst));
+        out.push_back(inst);
+    }
+
+    block.code = std::move(out);
+    return folded;
+}
+
+
+// ----- DEAD CODE -----
+
+size_t eliminateDeadCode(IrBlock& block) {
+    std::vector<IrInstruction> kept;
+    kept.reserve(block.code.size());
+    uint16_t live = 0;
+    size_t removed = 0;
+
+    for (auto it = block.code.rbegin(); it != block.code.rend(); ++it) {
+        const IrInstruction& inst = *it;
+        if (isRegisterOnly(inst.op) && !(irLiveWrites(inst) & live)) {
+            ++removed;
+            continue;
+        }
+        live = static_cast<uint16_t>((live & ~irLiveWrites(inst)) | irLiveReads(inst));
+        kept.push_back(inst);
+    }
+
+    block.code.assign(kept.rbegin(), kept.rend());
+    return removed;
+}
+
+
+// ----- PAIRS -----
+
+// Pair whose high (or low) half is 'reg', if any; SP and the scratch slot have none
+static bool pairOfHalf(const IrOperand& operand, bool high, IrPair& pair) {
+    if (operand.kind != IrOperandKind::Reg8)
+        return false;
+    for (IrPair p : { IrPair::AF, IrPair::BC, IrPair::DE, IrPair::HL }) {
+        if (operand.reg == static_cast<uint8_t>(high ? irPairHigh(p) : irPairLow(p))) {
+            pair = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// LD H,x followed by LD L,y (either order) as one 16-bit move, when x and y are
+// both immediates or the two halves of another pair
+static bool mergeMoves(const IrInstruction& first, const IrInstruction& second, IrInstruction& merged) {
+    if (first.op != IrOp::Move8 || second.op != IrOp::Move8)
+        return false;
+
+    for (bool high_first : { true, false }) {
+        const IrInstruction& high = high_first ? first : second;
+        const IrInstruction& low = high_first ? second : first;
+
+        IrPair dst_high, dst_low;
+        if (!pairOfHalf(high.dst, true, dst_high) || !pairOfHalf(low.dst, false, dst_low) || dst_high != dst_low)
+            continue;
+
+        merged = first;
+        merged.op = IrOp::Move16;
+        merged.dst = IrOperand::pair(dst_high);
+        merged.next = second.next;
+
+        if (high.src.isImm() && low.src.isImm()) {
+            merged.src = IrOperand::imm(static_cast<uint16_t>((high.src.value << 8) | (low.src.value & 0xFF)));
+            return true;
+        }
+
+        IrPair src_high, src_low;
+        if (pairOfHalf(high.src, true, src_high) && pairOfHalf(low.src, false, src_low) &&
+            src_high == src_low && src_high != dst_high) {
+            merged.src = IrOperand::pair(src_high);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+size_t mergePairs(IrBlock& block) {
+    std::vector<IrInstruction> out;
+    out.reserve(block.code.size());
+    size_t merged = 0;
+
+    for (size_t i = 0; i < block.code.size(); ++i) {
+        const IrInstruction& inst = block.code[i];
+
+        // LD r,r does nothing
+        if (inst.op == IrOp::Move8 && inst.src.kind == IrOperandKind::Reg8 && inst.src.reg == inst.dst.reg) {
+            ++merged;
+            continue;
+        }
+
+        if (i + 1 < block.code.size()) {
+            const IrInstruction& next = block.code[i + 1];
+            IrInstruction combined;
+
+            // EX DE,HL twice is no exchange at all
+            if (inst.op == IrOp::Exchange && next.op == IrOp::Exchange) {
+                merged += 2;
+                ++i;
+                continue;
+            }
+            if (mergeMoves(inst, next, combined)) {
+                out.push_back(combined);
+                ++merged;
+                ++i;
+                continue;
+            }
+        }
+        out.push_back(inst);
+    }
+
+    block.code = std::move(out);
+    return merged;
+}
+
+
+IrOptimizeStats optimizeIr(IrBlock& block) {
+    IrOptimizeStats stats;
+
+    markDeadFlags(block);
+    stats.folded = foldConstants(block);
+    stats.removed = eliminateDeadCode(block);
+    stats.merged = mergePairs(block);
+    markDeadFlags(block);
+    return stats;
+}
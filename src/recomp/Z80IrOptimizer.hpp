@@ -0,0 +1,42 @@
+#ifndef Z80_IR_OPTIMIZER_HPP
+#define Z80_IR_OPTIMIZER_HPP
+
+#include <cstddef>
+#include "Z80Ir.hpp"
+
+/* Z80IrOptimizer rewrites an IrBlock in place. Every pass is local to the block:
+ * barriers (Interpret and terminators) hand all registers over, so nothing is
+ * known across them and every register is live at them.
+ *
+ *   flags      marks instructions whose F result is overwritten before it is read
+ *   constants  tracks known slot values, replaces register operands with immediates,
+ *              evaluates instructions whose inputs are all known and folds branches
+ *              whose condition is known
+ *   dead code  drops register-only instructions whose results are never read
+ *   pairs      merges LD H,n / LD L,n style half moves into one 16-bit move and
+ *              cancels back-to-back EX DE,HL
+ *
+ * Memory accesses are never removed or reordered: a read may hit an input port.
+ */
+
+struct IrOptimizeStats {
+    size_t folded = 0;          // instructions evaluated or branches resolved
+    size_t removed = 0;         // dead instructions dropped
+    size_t merged = 0;          // half moves merged and exchanges cancelled
+};
+
+
+// Runs every pass in order
+IrOptimizeStats optimizeIr(IrBlock& block);
+
+void markDeadFlags(IrBlock& block);
+size_t foldConstants(IrBlock& block);
+size_t eliminateDeadCode(IrBlock& block);
+size_t mergePairs(IrBlock& block);
+
+// irReads()/irWrites() without the F slot when the instruction's flags are dead
+uint16_t irLiveReads(const IrInstruction& inst);
+uint16_t irLiveWrites(const IrInstruction& inst);
+
+
+#endif
@@ -0,0 +1,338 @@
+#include "PacmanEnv.hpp"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include "../io/BakedRomSet.hpp"
+#include "../utils/Crc32.hpp"
+
+
+std::vector<RamFeature> defaultPacmanFeatures() {
+    // Positions are (y, x) tile-pixel pairs
+    return {
+        { "ghost_positions", 0x4D00, 8 },      // red, pink, blue, orange
+        { "pacman_position", 0x4D08, 2 },
+        { "score", 0x4E80, 3 },
+        { "dots_eaten", 0x4E0E, 1 },
+        { "level", 0x4E13, 1 },
+        { "lives", 0x4E14, 1 },
+    };
+}
+
+
+uint32_t pacmanScore(std::span<const uint8_t> ram) {
+    uint32_t score = 0;
+    for (int i = 2; i >= 0; --i) {
+        const uint8_t bcd = ram[0x4E80 - PACMAN_RAM_BASE + i];
+        score = score * 100 + (bcd >> 4) * 10 + (bcd & 0x0F);
+    }
+    return score;
+}
+
+
+uint32_t pacmanDotsRemaining(std::span<const uint8_t> ram) {
+    const uint32_t eaten = ram[0x4E0E - PACMAN_RAM_BASE];
+    return eaten < PACMAN_TOTAL_DOTS ? PACMAN_TOTAL_DOTS - eaten : 0;
+}
+
+
+uint8_t pacmanLevel(std::span<const uint8_t> ram) {
+    return ram[0x4E13 - PACMAN_RAM_BASE];
+}
+
+
+uint8_t pacmanLives(std::span<const uint8_t> ram) {
+    return ram[0x4E14 - PACMAN_RAM_BASE];
+}
+
+
+bool loadPacmanEnvAssets(const RomSetImage& image, PacmanEnvAssets& out) {
+    std::span<const uint8_t> code = image.region(RomRegion::Code);
+    if (code.empty()) {
+        std::cerr << "ROM set '" << image.set_name << "' has no program code\n";
+        return false;
+    }
+    out.program.assign(code.begin(), code.end());
+
+    if (!decodeGraphics(image.region(RomRegion::Tiles), image.region(RomRegion::Sprites), out.graphics))
+        return false;
+    return buildColorLut(image.region(RomRegion::Color), out.lut);
+}
+
+
+bool loadBakedPacmanEnvAssets(PacmanEnvAssets& out) {
+    const BakedRomSet* baked = bakedRomSet();
+    if (!baked)
+        return false;
+
+    // Generated blocks are only valid for the exact program they came from
+    if (crc32(baked->program) != baked->program_crc32) {
+        std::cerr << "Baked ROM set '" << baked->set_name << "' is corrupt\n";
+        return false;
+    }
+    out.program.assign(baked->program.begin(), baked->program.end());
+
+    out.graphics.tiles.assign(baked->tiles.begin(), baked->tiles.end());
+    out.graphics.sprites.assign(baked->sprites.begin(), baked->sprites.end());
+    out.graphics.tile_count = baked->tile_count;
+    out.graphics.sprite_count = baked->sprite_count;
+
+    if (baked->colors.size() != out.lut.colors.size() || baked->color_indices.size() != out.lut.color_indices.size() ||
+        baked->rgba.size() != out.lut.rgba.size()) {
+        std::cerr << "Baked ROM set '" << baked->set_name << "' has a color table of the wrong size\n";
+        return false;
+    }
+    std::copy(baked->colors.begin(), baked->colors.end(), out.lut.colors.begin());
+    std::copy(baked->color_indices.begin(), baked->color_indices.end(), out.lut.color_indices.begin());
+    std::copy(baked->rgba.begin(), baked->rgba.end(), out.lut.rgba.begin());
+
+    out.blocks = Z80Executor::indexBlocks(baked->blocks);
+    return true;
+}
+
+
+// Drops features that fall outside the 0x4000-0x4FFF RAM block
+static void validateFeatures(std::vector<RamFeature>& features) {
+    std::erase_if(features, [](const RamFeature& f) {
+        const bool inside = f.address >= PACMAN_RAM_BASE &&
+                            f.address + f.length <= PACMAN_RAM_BASE + PACMAN_RAM_SIZE;
+        if (!inside)
+            std::cerr << "RAM feature '" << f.name << "' is outside work RAM, ignored\n";
+        return !inside;
+    });
+}
+
+
+// ----- SINGLE ENVIRONMENT -----
+
+PacmanEnv::PacmanEnv(std::shared_ptr<const PacmanEnvAssets> assets, PacmanEnvOptions options)
+    : assets(std::move(assets)), options(std::move(options)),
+      board(this->assets->program), renderer(this->assets->graphics, this->assets->lut) {
+
+    if (this->assets->blocks) {
+        executor = std::make_unique<Z80Executor>(board.cpu(), this->assets->blocks);
+        board.attachExecutor(executor.get());
+    }
+    validateFeatures(this->options.features);
+    if (this->options.framebuffer_downsample > 0) {
+        const uint32_t factor = this->options.framebuffer_downsample;
+        current.framebuffer_width = PacmanRenderer::downsampledWidth(factor);
+        current.framebuffer_height = PacmanRenderer::downsampledHeight(factor);
+        framebuffer.resize(static_cast<size_t>(current.framebuffer_width) * current.framebuffer_height);
+    }
+    current.features = &this->options.features;
+    reset();
+}
+
+
+const PacmanObservation& PacmanEnv::reset() {
+    board.reset();
+    board.setDipSwitches(options.dip_switches);
+    board.setInput({});
+    for (uint32_t i = 0; i < options.warmup_frames; ++i)
+        runFrame();
+    observe();
+    return current;
+}
+
+
+const PacmanObservation& PacmanEnv::step(PacmanInput input, uint32_t frames) {
+    board.setInput(input);
+    for (uint32_t i = 0; i < frames; ++i)
+        runFrame();
+    observe();
+    return current;
+}
+
+
+void PacmanEnv::runFrame() {
+    board.runFrame();
+    if (!dumper)
+        return;
+
+    // No free buffer: the dumper has counted it, the frame is skipped
+    Frame* frame = dumper->acquireFrame();
+    if (!frame)
+        return;
+    renderer.renderRgba(board, frame->pixels);
+    dumper->submitFrame(frame);
+}
+
+
+void PacmanEnv::observe() {
+    current.ram = board.ram();
+    current.frame = board.frameCount();
+    if (!framebuffer.empty()) {
+        renderer.renderIndicesDownsampled(board, options.framebuffer_downsample, framebuffer);
+        current.framebuffer = framebuffer;
+    }
+}
+
+
+// ----- BATCH -----
+
+PacmanEnvBatch::PacmanEnvBatch(std::shared_ptr<const PacmanEnvAssets> assets, size_t count,
+                               PacmanEnvOptions options, unsigned thread_count)
+    : assets(std::move(assets)), options(std::move(options)),
+      thread_count(thread_count ? thread_count : std::max(1u, std::thread::hardware_concurrency())) {
+
+    validateFeatures(this->options.features);
+    for (const RamFeature& f : this->options.features) {
+        feature_offsets.push_back(feature_bytes);
+        feature_bytes += f.length;
+    }
+    feature_arena.resize(feature_bytes * count);
+
+    if (this->options.framebuffer_downsample > 0)
+        framebuffer_size = static_cast<size_t>(framebufferWidth()) * framebufferHeight();
+    framebuffer_arena.resize(framebuffer_size * count);
+
+    const size_t slices = std::clamp<size_t>(count / MIN_ENVS_PER_WORKER, 1, this->thread_count);
+    slice_size = count ? (count + slices - 1) / slices : 0;
+    for (size_t i = 0; i < slices; ++i)
+        renderers.push_back(std::make_unique<PacmanRenderer>(this->assets->graphics, this->assets->lut));
+
+    ram_arena.resize(PACMAN_RAM_SIZE * count);
+    machines.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        machines.push_back(std::make_unique<PacmanMachine>(this->assets->program, ram_arena.data() + i * PACMAN_RAM_SIZE));
+
+    if (this->assets->blocks) {
+        executors.reserve(count);
+        for (const std::unique_ptr<PacmanMachine>& machine : machines) {
+            executors.push_back(std::make_unique<Z80Executor>(machine->cpu(), this->assets->blocks));
+            machine->attachExecutor(executors.back().get());
+        }
+    }
+
+    reset();
+
+    workers.reserve(slices - 1);
+    for (size_t slice = 1; slice < slices; ++slice)
+        workers.emplace_back(&PacmanEnvBatch::workerLoop, this, slice);
+}
+
+
+PacmanEnvBatch::~PacmanEnvBatch() {
+    stopping.store(true, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    generation.notify_all();
+    workers.clear();
+}
+
+
+void PacmanEnvBatch::reset() {
+    for (size_t env = 0; env < machines.size(); ++env)
+        reset(env);
+}
+
+
+void PacmanEnvBatch::reset(size_t env) {
+    PacmanMachine& machine = *machines[env];
+    machine.reset();
+    machine.setDipSwitches(options.dip_switches);
+    machine.setInput({});
+    for (uint32_t i = 0; i < options.warmup_frames; ++i)
+        machine.runFrame();
+
+    observe(env, renderers[0].get());
+}
+
+
+void PacmanEnvBatch::step(std::span<const PacmanInput> inputs, uint32_t frames) {
+    if (inputs.size() < machines.size()) {
+        std::cerr << "PacmanEnvBatch::step needs one input per environment\n";
+        return;
+    }
+
+    step_inputs = inputs;
+    step_frames = frames;
+    if (workers.empty()) {
+        runSlice(0);
+        return;
+    }
+
+    // The release on generation publishes the step; the workers' acq_rel decrement publishes their results
+    busy_workers.store(workers.size(), std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    generation.notify_all();
+
+    runSlice(0);
+    for (size_t busy = busy_workers.load(std::memory_order_acquire); busy != 0;
+         busy = busy_workers.load(std::memory_order_acquire))
+        busy_workers.wait(busy, std::memory_order_acquire);
+}
+
+
+// Contiguous slices, so each thread touches its own part of every arena
+void PacmanEnvBatch::runSlice(size_t slice) {
+    const size_t begin = std::min(slice * slice_size, machines.size());
+    const size_t end = std::min(begin + slice_size, machines.size());
+    PacmanRenderer* renderer = framebuffer_size ? renderers[slice].get() : nullptr;
+
+    for (size_t env = begin; env < end; ++env) {
+        PacmanMachine& machine = *machines[env];
+        machine.setInput(step_inputs[env]);
+        for (uint32_t i = 0; i < step_frames; ++i)
+            machine.runFrame();
+        observe(env, renderer);
+    }
+}
+
+
+void PacmanEnvBatch::workerLoop(size_t slice) {
+    uint32_t seen = 0;
+    while (true) {
+        generation.wait(seen, std::memory_order_acquire);
+        seen = generation.load(std::memory_order_acquire);
+        if (stopping.load(std::memory_order_relaxed))
+            return;
+
+        runSlice(slice);
+        if (busy_workers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            busy_workers.notify_one();
+    }
+}
+
+
+void PacmanEnvBatch::observe(size_t env, PacmanRenderer* renderer) {
+    const size_t count = machines.size();
+    const uint8_t* ram = ram_arena.data() + env * PACMAN_RAM_SIZE;
+
+    for (size_t f = 0; f < options.features.size(); ++f) {
+        const RamFeature& feature = options.features[f];
+        const uint8_t* source = ram + (feature.address - PACMAN_RAM_BASE);
+        for (size_t b = 0; b < feature.length; ++b)
+            feature_arena[(feature_offsets[f] + b) * count + env] = source[b];
+    }
+
+    if (renderer && framebuffer_size) {
+        std::span<uint8_t> out(framebuffer_arena.data() + env * framebuffer_size, framebuffer_size);
+        renderer->renderIndicesDownsampled(*machines[env], options.framebuffer_downsample, out);
+    }
+}
+
+
+std::span<const uint8_t> PacmanEnvBatch::featureColumn(size_t feature, size_t byte) const {
+    const size_t count = machines.size();
+    return { feature_arena.data() + (feature_offsets[feature] + byte) * count, count };
+}
+
+
+std::span<const uint8_t> PacmanEnvBatch::ram(size_t env) const {
+    return { ram_arena.data() + env * PACMAN_RAM_SIZE, PACMAN_RAM_SIZE };
+}
+
+
+std::span<const uint8_t> PacmanEnvBatch::framebuffer(size_t env) const {
+    return { framebuffer_arena.data() + env * framebuffer_size, framebuffer_size };
+}
+
+
+uint32_t PacmanEnvBatch::framebufferWidth() const {
+    return options.framebuffer_downsample ? PacmanRenderer::downsampledWidth(options.framebuffer_downsample) : 0;
+}
+
+
+uint32_t PacmanEnvBatch::framebufferHeight() const {
+    return options.framebuffer_downsample ? PacmanRenderer::downsampledHeight(options.framebuffer_downsample) : 0;
+}
@@ -0,0 +1,180 @@
+#ifndef PACMAN_ENV_HPP
+#define PACMAN_ENV_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../io/RomSet.hpp"
+#include "../machine/PacmanMachine.hpp"
+#include "../recomp/Z80Executor.hpp"
+#include "../video/ColorLut.hpp"
+#include "../video/FrameDumper.hpp"
+#include "../video/PacmanRenderer.hpp"
+#include "../video/TileDecoder.hpp"
+
+/* PacmanEnv runs Pac-Man as a reinforcement-learning environment.
+ *
+ * step() advances N frames with one input and returns an observation. The RAM
+ * features in it are spans into the emulated RAM itself, so nothing is copied;
+ * they stay valid until the next step() or reset(). No audio or video encoding
+ * happens, and the framebuffer is only drawn when options ask for one.
+ *
+ * PacmanEnvBatch keeps thousands of environments side by side: all RAM in one
+ * arena, features gathered column-wise (structure of arrays) after each step,
+ * and the environments split across worker threads while stepping. The workers
+ * are started once and park between steps, so a step costs a wake-up, not a
+ * thread creation; a batch too small to split runs on the calling thread.
+ *
+ * A FrameDumper attached to a PacmanEnv receives every emulated frame, warmup
+ * included, as RGBA. Frames the writer has no buffer for are skipped and show
+ * up in its stats().backpressure; emulation never waits for the disk.
+ *
+ * Assets with generated blocks (a baked build, see BakedRomSet.hpp) give every
+ * machine a Z80Executor over one shared block index.
+ */
+
+struct RamFeature {
+    std::string name;
+    uint16_t address = 0;      // Z80 address, inside 0x4000-0x4FFF
+    uint16_t length = 1;
+};
+
+// Ghost and Pac-Man positions, score, dots eaten, level and lives
+std::vector<RamFeature> defaultPacmanFeatures();
+
+// Interpreting the default features
+constexpr uint32_t PACMAN_TOTAL_DOTS = 244;
+uint32_t pacmanScore(std::span<const uint8_t> ram);             // 0x4E80, 3 bytes BCD, low byte first
+uint32_t pacmanDotsRemaining(std::span<const uint8_t> ram);
+uint8_t pacmanLevel(std::span<const uint8_t> ram);
+uint8_t pacmanLives(std::span<const uint8_t> ram);
+
+struct PacmanEnvOptions {
+    std::vector<RamFeature> features = defaultPacmanFeatures();
+    uint32_t framebuffer_downsample = 0;    // 0 = no framebuffer, 1 = full 224x288, N = every Nth pixel
+    uint32_t warmup_frames = 0;             // frames run with no input by reset()
+    uint8_t dip_switches = 0xC9;
+};
+
+// Everything decoded from the ROM set once and shared by all environments
+struct PacmanEnvAssets {
+    std::vector<uint8_t> program;
+    DecodedGraphics graphics;
+    ColorLut lut;
+    std::shared_ptr<const Z80BlockIndex> blocks;    // generated code for 'program'; null = interpreter only
+};
+
+bool loadPacmanEnvAssets(const RomSetImage& image, PacmanEnvAssets& out);
+
+// Copies the tables compiled into a baked build; false when the build has none
+bool loadBakedPacmanEnvAssets(PacmanEnvAssets& out);
+
+struct PacmanObservation {
+    std::span<const uint8_t> ram;               // 0x4000-0x4FFF
+    std::span<const uint8_t> framebuffer;       // color numbers, empty when disabled
+    uint32_t framebuffer_width = 0;
+    uint32_t framebuffer_height = 0;
+    uint64_t frame = 0;
+    const std::vector<RamFeature>* features = nullptr;
+
+    std::span<const uint8_t> feature(size_t index) const {
+        const RamFeature& f = (*features)[index];
+        return ram.subspan(f.address - PACMAN_RAM_BASE, f.length);
+    }
+};
+
+
+class PacmanEnv {
+    public:
+    PacmanEnv(std::shared_ptr<const PacmanEnvAssets> assets, PacmanEnvOptions options = {});
+
+    const PacmanObservation& reset();
+    const PacmanObservation& step(PacmanInput input, uint32_t frames = 1);
+
+    const PacmanObservation& observation() const { return current; }
+    PacmanMachine& machine() { return board; }
+
+    // 'dumper' must be started and stay alive while attached; nullptr detaches
+    void attachFrameDumper(FrameDumper* dumper_) { dumper = dumper_; }
+
+    private:
+    void runFrame();
+    void observe();
+
+    std::shared_ptr<const PacmanEnvAssets> assets;
+    PacmanEnvOptions options;
+    PacmanMachine board;
+    std::unique_ptr<Z80Executor> executor;
+    PacmanRenderer renderer;
+    std::vector<uint8_t> framebuffer;
+    PacmanObservation current;
+    FrameDumper* dumper = nullptr;
+};
+
+
+class PacmanEnvBatch {
+    public:
+    // thread_count 0 = hardware concurrency
+    PacmanEnvBatch(std::shared_ptr<const PacmanEnvAssets> assets, size_t count, PacmanEnvOptions options = {},
+                   unsigned thread_count = 0);
+    ~PacmanEnvBatch();
+
+    PacmanEnvBatch(const PacmanEnvBatch&) = delete;
+    PacmanEnvBatch& operator=(const PacmanEnvBatch&) = delete;
+
+    void reset();
+    void reset(size_t env);
+
+    // One input per environment
+    void step(std::span<const PacmanInput> inputs, uint32_t frames = 1);
+
+    size_t size() const { return machines.size(); }
+
+    // Byte 'byte' of feature 'feature' for every environment, one value per env
+    std::span<const uint8_t> featureColumn(size_t feature, size_t byte = 0) const;
+
+    std::span<const uint8_t> ram(size_t env) const;
+    std::span<const uint8_t> framebuffer(size_t env) const;
+    uint32_t framebufferWidth() const;
+    uint32_t framebufferHeight() const;
+    const std::vector<RamFeature>& features() const { return options.features; }
+
+    // Fewer environments than this per thread are not worth a worker
+    static constexpr size_t MIN_ENVS_PER_WORKER = 2;
+
+    private:
+    void runSlice(size_t slice);
+    void workerLoop(size_t slice);
+    void observe(size_t env, PacmanRenderer* renderer);
+
+    std::shared_ptr<const PacmanEnvAssets> assets;
+    PacmanEnvOptions options;
+    unsigned thread_count;
+
+    std::vector<uint8_t> ram_arena;                 // count x PACMAN_RAM_SIZE
+    std::vector<std::unique_ptr<PacmanMachine>> machines;
+    std::vector<std::unique_ptr<Z80Executor>> executors;  // one per machine when assets have blocks
+    std::vector<size_t> feature_offsets;            // first column of each feature
+    size_t feature_bytes = 0;
+    std::vector<uint8_t> feature_arena;             // feature_bytes columns x count
+    std::vector<uint8_t> framebuffer_arena;         // count x framebuffer size
+    size_t framebuffer_size = 0;
+
+    // Current step, read by the workers after a generation bump
+    std::span<const PacmanInput> step_inputs;
+    uint32_t step_frames = 0;
+    size_t slice_size = 0;                          // contiguous environments per slice
+
+    std::vector<std::unique_ptr<PacmanRenderer>> renderers;     // one per slice
+    std::atomic<uint32_t> generation{0};            // bumped to start a step or to stop
+    std::atomic<size_t> busy_workers{0};
+    std::atomic<bool> stopping{false};
+    std::vector<std::jthread> workers;              // slice i + 1; last member, joined first
+};
+
+
+#endif
@@ -0,0 +1,152 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+#include "../core/Z80Analysis.hpp"
+#include "../io/RomManager.hpp"
+#include "../recomp/Z80Emitter.hpp"
+#include "../utils/Crc32.hpp"
+#include "../video/ColorLut.hpp"
+#include "../video/TileDecoder.hpp"
+
+/* PacmanBake turns a ROM folder into C++ sources for a baked build (see BakedRomSet.hpp).
+ *
+ *     PacmanBake <rom folder> <output folder> [set name | description file]
+ *
+ * Writes baked_rom_set.cpp (constant tables), baked_blocks.cpp (generated code)
+ * and baked.d, a depfile listing the ROM files so the build re-bakes when one changes.
+ */
+
+
+namespace {
+
+// 'name' = { 0x.., ... }; as a constant array, 'per_line' values per line
+template <typename T>
+void writeArray(std::ostream& out, const char* type, const char* name, std::span<const T> values, size_t per_line) {
+    static constexpr char DIGITS[] = "0123456789abcdef";
+    out << "alignas(64) constexpr " << type << ' ' << name << "[" << values.size() << "] = {";
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i % per_line == 0)
+            out << "\n   ";
+        std::string value = " 0x";
+        for (int shift = static_cast<int>(sizeof(T) * 8) - 4; shift >= 0; shift -= 4)
+            value += DIGITS[(values[i] >> shift) & 0xF];
+        out << value << ',';
+    }
+    out << "\n};\n\n";
+}
+
+
+void writeRomSet(std::ostream& out, const std::string& set_name, std::span<const uint8_t> program,
+                 const DecodedGraphics& graphics, const ColorLut& lut) {
+    out << "// Generated by PacmanBake from ROM set '" << set_name << "'. Do not edit.\n"
+        << "#include \"io/BakedRomSet.hpp\"\n\n\n"
+        << "namespace {\n\n";
+    writeArray<uint8_t>(out, "uint8_t", "PROGRAM", program, 16);
+    writeArray<uint8_t>(out, "uint8_t", "TILES", graphics.tiles, 32);
+    writeArray<uint8_t>(out, "uint8_t", "SPRITES", graphics.sprites, 32);
+    writeArray<uint32_t>(out, "uint32_t", "COLORS", lut.colors, 8);
+    writeArray<uint8_t>(out, "uint8_t", "COLOR_INDICES", lut.color_indices, 16);
+    writeArray<uint32_t>(out, "uint32_t", "RGBA", lut.rgba, 8);
+    out << "}   // namespace\n\n\n"
+        << "const BakedRomSet* bakedRomSet() {\n"
+        << "    static const BakedRomSet baked{\n"
+        << "        .set_name = \"" << set_name << "\",\n"
+        << "        .program = PROGRAM,\n"
+        << "        .program_crc32 = 0x" << std::hex << crc32(program) << std::dec << ",\n"
+        << "        .tiles = TILES,\n"
+        << "        .sprites = SPRITES,\n"
+        << "        .tile_count = " << graphics.tile_count << ",\n"
+        << "        .sprite_count = " << graphics.sprite_count << ",\n"
+        << "        .colors = COLORS,\n"
+        << "        .color_indices = COLOR_INDICES,\n"
+        << "        .rgba = RGBA,\n"
+        << "        .blocks = z80GeneratedBlocks(),\n"
+        << "    };\n"
+        << "    return &baked;\n"
+        << "}\n";
+}
+
+
+// Make-style depfile; spaces in paths are escaped
+std::string depfilePath(const std::filesystem::path& path) {
+    std::string escaped;
+    for (char c : std::filesystem::absolute(path).generic_string()) {
+        if (c == ' ' || c == '#')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+}   // namespace
+
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 4) {
+        std::cerr << "Usage: PacmanBake <rom folder> <output folder> [set name | description file]\n";
+        return 1;
+    }
+    const std::filesystem::path rom_folder = argv[1];
+    const std::filesystem::path output_folder = argv[2];
+    const std::string set_argument = argc == 4 ? argv[3] : "pacman";
+
+    RomSetDescription rom_set;
+    std::vector<std::filesystem::path> inputs;
+    if (const RomSetDescription* builtin = findBuiltinRomSet(set_argument)) {
+        rom_set = *builtin;
+    } else if (loadRomSetDescription(set_argument, rom_set)) {
+        inputs.push_back(set_argument);
+    } else {
+        std::cerr << "Unknown ROM set: " << set_argument << "\n";
+        return 1;
+    }
+
+    RomSetImage image;
+    if (!RomManager(rom_folder.string(), rom_set).loadRegions(image))
+        return 1;
+    for (const RomFileSpec& file : rom_set.files)
+        inputs.push_back(rom_folder / file.name);
+
+    std::span<const uint8_t> code = image.region(RomRegion::Code);
+    if (code.empty()) {
+        std::cerr << "ROM set '" << rom_set.name << "' has no program code\n";
+        return 1;
+    }
+
+    DecodedGraphics graphics;
+    ColorLut lut;
+    if (!decodeGraphics(image.region(RomRegion::Tiles), image.region(RomRegion::Sprites), graphics) ||
+        !buildColorLut(image.region(RomRegion::Color), lut))
+        return 1;
+
+    Z80Analysis analysis(std::vector<uint8_t>(code.begin(), code.end()));
+    analysis.analyze();
+
+    std::filesystem::create_directories(output_folder);
+    const std::filesystem::path rom_set_source = output_folder / "baked_rom_set.cpp";
+    const std::filesystem::path blocks_source = output_folder / "baked_blocks.cpp";
+
+    std::ofstream tables(rom_set_source);
+    std::ofstream blocks(blocks_source);
+    std::ofstream depfile(output_folder / "baked.d");
+    if (!tables || !blocks || !depfile) {
+        std::cerr << "Cannot write to " << output_folder << "\n";
+        return 1;
+    }
+
+    writeRomSet(tables, rom_set.name, code, graphics, lut);
+    Z80EmitStats emitted = emitZ80Program(analysis, blocks);
+
+    depfile << depfilePath(rom_set_source) << ' ' << depfilePath(blocks_source) << ':';
+    for (const std::filesystem::path& input : inputs)
+        depfile << " \\\n  " << depfilePath(input);
+    depfile << '\n';
+
+    std::cout << "Baked " << rom_set.name << ": " << code.size() << " program bytes, "
+              << graphics.tile_count << " tiles, " << graphics.sprite_count << " sprites, "
+              << emitted.blocks << " generated blocks\n";
+    return 0;
+}
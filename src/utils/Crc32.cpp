@@ -0,0 +1,24 @@
+#include "Crc32.hpp"
+#include <array>
+
+
+static constexpr std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+        table[n] = c;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, 256> CRC_TABLE = makeCrcTable();
+
+
+uint32_t crc32(std::span<const uint8_t> data, uint32_t crc) {
+    crc = ~crc;
+    for (uint8_t byte : data)
+        crc = CRC_TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
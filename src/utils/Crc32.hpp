@@ -0,0 +1,11 @@
+#ifndef CRC32_HPP
+#define CRC32_HPP
+
+#include <cstdint>
+#include <span>
+
+// Standard CRC-32 (zlib/PNG polynomial). Pass the previous result to continue a running checksum.
+uint32_t crc32(std::span<const uint8_t> data, uint32_t crc = 0);
+
+
+#endif
@@ -4,12 +4,13 @@
 #include <iostream>
 
 
-void dumpRomsForDebug(const std::unordered_map<std::string, std::vector<uint8_t>>& roms,
+void dumpRomsForDebug(const std::unordered_map<std::string, RomData>& roms,
                       const std::string& output_folder) {
 
     std::filesystem::create_directories(output_folder);
 
-    for (const auto& [name, data] : roms) {
+    for (const auto& [name, rom] : roms) {
+        const std::vector<uint8_t>& data = *rom;
         std::filesystem::path output_folder_path = std::filesystem::path(output_folder) / (name + ".txt");
 
         std::ofstream output_file(output_folder_path);
@@ -38,7 +39,7 @@ void clearRomDumpFolder(const std::string& folder) {
 }
 
 
-void concatenateRoms(const std::unordered_map<std::string, std::vector<uint8_t>>& roms,
+void concatenateRoms(const std::unordered_map<std::string, RomData>& roms,
                       const std::vector<std::string>& rom_order,
                       const std::string& output_folder) {
 
@@ -48,12 +49,13 @@ void concatenateRoms(const std::unordered_map<std::string, std::vector<uint8_t>>
     }
 
     for (const std::string& rom_name : rom_order) {
-        std::unordered_map<std::string, std::vector<uint8_t>>::const_iterator it = roms.find(rom_name);
+        std::unordered_map<std::string, RomData>::const_iterator it = roms.find(rom_name);
         if (it == roms.end()) {
             std::cerr << "Failed to find rom: " << rom_name << "\n";
+            continue;
         }
 
-        const std::vector<uint8_t>& data = it->second;
+        const std::vector<uint8_t>& data = *it->second;
 
         output_file.write(reinterpret_cast<const char*>(data.data()), data.size());
 
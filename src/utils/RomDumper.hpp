@@ -5,16 +5,17 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include "../io/RomSet.hpp"
 
-// Function takes the unordered_map from RomManager and creates txt files for each rom file loaded in memory
-void dumpRomsForDebug(const std::unordered_map<std::string, std::vector<uint8_t>>& roms,
+// Creates a txt file for each rom file of a loaded set (RomSetImage::files)
+void dumpRomsForDebug(const std::unordered_map<std::string, RomData>& roms,
                       const std::string& output_folder = "../rom_dumps");
 
 // clears out the newly created folder
 void clearRomDumpFolder(const std::string& folder = "../rom_dumps");
 
 // creates a new rom file by combining certain rom files
-void concatenateRoms(const std::unordered_map<std::string, std::vector<uint8_t>>& roms,
+void concatenateRoms(const std::unordered_map<std::string, RomData>& roms,
                      const std::vector<std::string>& rom_order,
                      const std::string& output_folder = "../rom_dumps");
 
@@ -0,0 +1,59 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/* Lock-free ring buffer for exactly one producer thread and one consumer thread.
+ * push() and pop() never block; they fail when the ring is full or empty.
+ * The capacity is rounded up to a power of two.
+ */
+
+template <typename T>
+class SpscQueue {
+    public:
+    explicit SpscQueue(size_t capacity) : slots(roundUp(capacity)), mask(slots.size() - 1) {}
+
+    bool push(const T& value) {
+        const size_t tail = write_index.load(std::memory_order_relaxed);
+        if (tail - read_index.load(std::memory_order_acquire) == slots.size())
+            return false;
+
+        slots[tail & mask] = value;
+        write_index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        const size_t head = read_index.load(std::memory_order_relaxed);
+        if (head == write_index.load(std::memory_order_acquire))
+            return false;
+
+        value = slots[head & mask];
+        read_index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return read_index.load(std::memory_order_acquire) == write_index.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return slots.size(); }
+
+    private:
+    static size_t roundUp(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        return size;
+    }
+
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> read_index{0};
+    alignas(64) std::atomic<size_t> write_index{0};
+};
+
+
+#endif
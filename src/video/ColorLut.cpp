@@ -0,0 +1,96 @@
+#include "ColorLut.hpp"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+
+/* The RGB outputs drive the monitor through 1k/470/220 ohm resistors
+ * (blue only has the 470 and 220 ones). Each bit contributes in proportion
+ * to the conductance of its resistor, normalised so all bits set give 255.
+ */
+template <size_t N>
+static constexpr std::array<uint8_t, N> resistorWeights(const double (&resistances)[N]) {
+    double total = 0.0;
+    for (double r : resistances)
+        total += 1.0 / r;
+
+    std::array<uint8_t, N> weights{};
+    for (size_t i = 0; i < N; ++i)
+        weights[i] = static_cast<uint8_t>(255.0 * (1.0 / resistances[i]) / total + 0.5);
+    return weights;
+}
+
+static constexpr double RG_RESISTANCES[3] = { 1000.0, 470.0, 220.0 };
+static constexpr double B_RESISTANCES[2] = { 470.0, 220.0 };
+
+static constexpr std::array<uint8_t, 3> RG_WEIGHTS = resistorWeights(RG_RESISTANCES);
+static constexpr std::array<uint8_t, 2> B_WEIGHTS = resistorWeights(B_RESISTANCES);
+
+
+uint32_t decodePromColor(uint8_t value) {
+    const uint32_t r = ((value >> 0) & 1) * RG_WEIGHTS[0] + ((value >> 1) & 1) * RG_WEIGHTS[1] +
+                       ((value >> 2) & 1) * RG_WEIGHTS[2];
+    const uint32_t g = ((value >> 3) & 1) * RG_WEIGHTS[0] + ((value >> 4) & 1) * RG_WEIGHTS[1] +
+                       ((value >> 5) & 1) * RG_WEIGHTS[2];
+    const uint32_t b = ((value >> 6) & 1) * B_WEIGHTS[0] + ((value >> 7) & 1) * B_WEIGHTS[1];
+
+    return r | (g << 8) | (b << 16) | 0xFF000000u;
+}
+
+
+bool buildColorLut(std::span<const uint8_t> color_region, ColorLut& out) {
+    if (color_region.size() < PALETTE_PROM_OFFSET + COLOR_LUT_SIZE) {
+        std::cerr << "Color region too small for color and palette PROMs ("
+                  << color_region.size() << " bytes)\n";
+        return false;
+    }
+
+    for (size_t i = 0; i < COLOR_COUNT; ++i)
+        out.colors[i] = decodePromColor(color_region[COLOR_PROM_OFFSET + i]);
+
+    // Only the low nibble of the palette PROM is wired, so colors 16-31 are never selected
+    for (size_t i = 0; i < COLOR_LUT_SIZE; ++i) {
+        out.color_indices[i] = color_region[PALETTE_PROM_OFFSET + i] & 0x0F;
+        out.rgba[i] = out.colors[out.color_indices[i]];
+    }
+
+    return true;
+}
+
+
+bool exportColorLut(const ColorLut& lut, const std::filesystem::path& output_file) {
+    const bool binary = output_file.extension() == ".bin";
+    std::ofstream out(output_file, binary ? std::ios::binary : std::ios::out);
+
+    if (!out) {
+        std::cerr << "Failed to create color lut file: " << output_file << "\n";
+        return false;
+    }
+
+    if (binary) {
+        for (uint32_t color : lut.rgba) {
+            const uint8_t bytes[4] = {
+                static_cast<uint8_t>(color), static_cast<uint8_t>(color >> 8),
+                static_cast<uint8_t>(color >> 16), static_cast<uint8_t>(color >> 24)
+            };
+            out.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+        }
+    }
+    else {
+        // One palette per line: "pp: rrggbb rrggbb rrggbb rrggbb"
+        out << std::hex << std::setfill('0');
+        for (size_t palette = 0; palette < PALETTE_COUNT; ++palette) {
+            out << std::setw(2) << palette << ":";
+            for (size_t pen = 0; pen < PENS_PER_PALETTE; ++pen) {
+                const uint32_t color = lut.rgba[palette * PENS_PER_PALETTE + pen];
+                out << " " << std::setw(2) << (color & 0xFF)
+                    << std::setw(2) << ((color >> 8) & 0xFF)
+                    << std::setw(2) << ((color >> 16) & 0xFF);
+            }
+            out << "\n";
+        }
+    }
+
+    std::cout << "Color lut written to " << output_file << "\n";
+    return true;
+}
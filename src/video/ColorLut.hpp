@@ -0,0 +1,54 @@
+#ifndef COLOR_LUT_HPP
+#define COLOR_LUT_HPP
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+/* ColorLut decodes the color PROM (82s123.7f) and the palette PROM (82s126.4a) once.
+ *
+ * Color PROM: 32 bytes, each a resistor-weighted BBGGGRRR value.
+ * Palette PROM: 64 palettes x 4 pens, the low nibble selects a color.
+ *
+ * The result is one packed table indexed by (palette << 2) | pen, so a renderer
+ * resolves a pixel with a single load. RGBA is packed as 0xAABBGGRR, i.e. the
+ * bytes R, G, B, A in memory on little-endian hosts.
+ */
+
+constexpr size_t COLOR_COUNT = 32;
+constexpr size_t PALETTE_COUNT = 64;
+constexpr size_t PENS_PER_PALETTE = 4;
+constexpr size_t COLOR_LUT_SIZE = PALETTE_COUNT * PENS_PER_PALETTE;
+
+// Offsets of the two PROMs inside the color region
+constexpr size_t COLOR_PROM_OFFSET = 0x00;
+constexpr size_t PALETTE_PROM_OFFSET = 0x20;
+
+struct ColorLut {
+    std::array<uint32_t, COLOR_COUNT> colors{};              // decoded color PROM
+    std::array<uint8_t, COLOR_LUT_SIZE> color_indices{};     // palette PROM, color number per pen
+    std::array<uint32_t, COLOR_LUT_SIZE> rgba{};             // packed palette x pen -> RGBA
+
+    static constexpr size_t index(uint8_t palette, uint8_t pen) {
+        return ((palette & 0x3F) << 2) | (pen & 0x03);
+    }
+
+    uint32_t lookup(uint8_t palette, uint8_t pen) const { return rgba[index(palette, pen)]; }
+
+    // Pens that map to color 0 are transparent when drawing sprites
+    bool isTransparent(uint8_t palette, uint8_t pen) const { return color_indices[index(palette, pen)] == 0; }
+};
+
+
+// Converts one color PROM byte into RGBA
+uint32_t decodePromColor(uint8_t value);
+
+// 'color_region' holds the color PROM at 0x00 and the palette PROM at 0x20
+bool buildColorLut(std::span<const uint8_t> color_region, ColorLut& out);
+
+// Writes the table for tooling: raw RGBA bytes for a .bin path, readable hex otherwise
+bool exportColorLut(const ColorLut& lut, const std::filesystem::path& output_file);
+
+
+#endif
@@ -0,0 +1,180 @@
+#include "FrameDumper.hpp"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "PngWriter.hpp"
+
+
+FrameDumper::FrameDumper(FrameDumperOptions options)
+    : options(std::move(options)),
+      free_frames(this->options.pool_size),
+      filled_frames(this->options.pool_size) {
+
+    const size_t pixel_count = static_cast<size_t>(this->options.width) * this->options.height;
+    for (size_t i = 0; i < this->options.pool_size; ++i) {
+        pool.push_back(std::make_unique<Frame>());
+        pool.back()->pixels.assign(pixel_count, 0xFF000000u);
+        free_frames.push(pool.back().get());
+    }
+}
+
+
+FrameDumper::~FrameDumper() {
+    finish();
+}
+
+
+bool FrameDumper::start() {
+    if (writer.joinable())
+        return true;
+
+    if (!options.output_file.empty()) {
+        stream.open(options.output_file, std::ios::binary);
+        if (!stream) {
+            std::cerr << "Failed to create frame dump: " << options.output_file << "\n";
+            return false;
+        }
+
+        if (options.format == FrameFormat::Y4m) {
+            stream << "YUV4MPEG2 W" << options.width << " H" << options.height
+                   << " F" << options.fps_numerator << ":" << options.fps_denominator
+                   << " Ip A1:1 C444\n";
+        }
+    }
+
+    if (options.keyframe_interval > 0)
+        std::filesystem::create_directories(options.keyframe_folder);
+
+    stopping.store(false);
+    writer = std::thread(&FrameDumper::writerLoop, this);
+    return true;
+}
+
+
+void FrameDumper::finish() {
+    if (!writer.joinable())
+        return;
+
+    stopping.store(true);
+    wake.fetch_add(1, std::memory_order_release);
+    wake.notify_one();
+    writer.join();
+
+    stream.close();
+    std::cout << "Frame dump finished: " << written.load() << " frames, "
+              << keyframes.load() << " keyframes, " << backpressure.load() << " backpressure events\n";
+}
+
+
+Frame* FrameDumper::acquireFrame() {
+    Frame* frame = nullptr;
+    if (!free_frames.pop(frame)) {
+        backpressure.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return frame;
+}
+
+
+void FrameDumper::submitFrame(Frame* frame) {
+    frame->number = next_number++;
+
+    // Cannot fail: the ring holds at least as many slots as there are frames
+    filled_frames.push(frame);
+    submitted.fetch_add(1, std::memory_order_relaxed);
+
+    wake.fetch_add(1, std::memory_order_release);
+    wake.notify_one();
+}
+
+
+void FrameDumper::releaseFrame(Frame* frame) {
+    // The writer is the only producer of free frames, so route it through the writer
+    frame->number = UINT64_MAX;
+    filled_frames.push(frame);
+    wake.fetch_add(1, std::memory_order_release);
+    wake.notify_one();
+}
+
+
+FrameDumperStats FrameDumper::stats() const {
+    FrameDumperStats result;
+    result.submitted = submitted.load(std::memory_order_relaxed);
+    result.written = written.load(std::memory_order_relaxed);
+    result.keyframes = keyframes.load(std::memory_order_relaxed);
+    result.backpressure = backpressure.load(std::memory_order_relaxed);
+    result.write_error = write_error.load(std::memory_order_relaxed);
+    return result;
+}
+
+
+void FrameDumper::writerLoop() {
+    while (true) {
+        const uint32_t seen = wake.load(std::memory_order_acquire);
+
+        Frame* frame = nullptr;
+        while (filled_frames.pop(frame)) {
+            if (frame->number != UINT64_MAX)
+                writeFrame(*frame);
+            free_frames.push(frame);
+        }
+
+        if (stopping.load(std::memory_order_acquire) && filled_frames.empty())
+            return;
+
+        wake.wait(seen, std::memory_order_acquire);
+    }
+}
+
+
+void FrameDumper::writeFrame(const Frame& frame) {
+    const size_t pixel_count = static_cast<size_t>(options.width) * options.height;
+
+    rgb.resize(pixel_count * 3);
+    for (size_t i = 0; i < pixel_count; ++i) {
+        const uint32_t color = frame.pixels[i];
+        rgb[i * 3 + 0] = static_cast<uint8_t>(color);
+        rgb[i * 3 + 1] = static_cast<uint8_t>(color >> 8);
+        rgb[i * 3 + 2] = static_cast<uint8_t>(color >> 16);
+    }
+
+    if (stream.is_open()) {
+        if (options.format == FrameFormat::Y4m) {
+            // BT.601 studio range, full-resolution chroma
+            planes.resize(pixel_count * 3);
+            uint8_t* y_plane = planes.data();
+            uint8_t* u_plane = y_plane + pixel_count;
+            uint8_t* v_plane = u_plane + pixel_count;
+
+            for (size_t i = 0; i < pixel_count; ++i) {
+                const int r = rgb[i * 3 + 0];
+                const int g = rgb[i * 3 + 1];
+                const int b = rgb[i * 3 + 2];
+                y_plane[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                u_plane[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                v_plane[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+
+            stream << "FRAME\n";
+            stream.write(reinterpret_cast<const char*>(planes.data()), planes.size());
+        }
+        else {
+            stream.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+        }
+
+        if (!stream)
+            write_error.store(true, std::memory_order_relaxed);
+    }
+
+    if (options.keyframe_interval > 0 && frame.number % options.keyframe_interval == 0) {
+        std::ostringstream name;
+        name << "frame_" << std::setw(8) << std::setfill('0') << frame.number << ".png";
+
+        if (writePng(options.keyframe_folder / name.str(), options.width, options.height, rgb))
+            keyframes.fetch_add(1, std::memory_order_relaxed);
+        else
+            write_error.store(true, std::memory_order_relaxed);
+    }
+
+    written.fetch_add(1, std::memory_order_relaxed);
+}
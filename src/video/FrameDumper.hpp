@@ -0,0 +1,109 @@
+#ifndef FRAME_DUMPER_HPP
+#define FRAME_DUMPER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../utils/SpscQueue.hpp"
+
+/* FrameDumper moves finished frames off the emulation thread and onto disk.
+ *
+ * Frames come from a fixed pool of recycled buffers. The emulation thread takes
+ * one with acquireFrame(), fills it and hands it back with submitFrame(); a
+ * background writer encodes it and returns the buffer to the pool. Both hand-offs
+ * go through lock-free single-producer/single-consumer rings, so the emulation
+ * thread never waits on the writer or on disk.
+ *
+ * When every buffer is still queued, acquireFrame() returns nullptr and counts the
+ * event in stats().backpressure; nothing is dropped behind the caller's back.
+ *
+ * Output is one stream (Y4M 4:4:4 or raw RGB24) plus optional PNG keyframes.
+ * Use one FrameDumper per emulation thread.
+ */
+
+constexpr uint32_t SCREEN_WIDTH = 224;
+constexpr uint32_t SCREEN_HEIGHT = 288;
+
+enum class FrameFormat : uint8_t {
+    Y4m,
+    RawRgb
+};
+
+struct FrameDumperOptions {
+    std::filesystem::path output_file;            // empty = no stream, keyframes only
+    FrameFormat format = FrameFormat::Y4m;
+    std::filesystem::path keyframe_folder;        // PNGs go here when keyframe_interval > 0
+    uint32_t keyframe_interval = 0;               // every Nth frame, 0 = off
+    uint32_t width = SCREEN_WIDTH;
+    uint32_t height = SCREEN_HEIGHT;
+    uint32_t fps_numerator = 60606;               // 60.606 Hz
+    uint32_t fps_denominator = 1000;
+    size_t pool_size = 8;
+};
+
+// RGBA pixels packed as 0xAABBGGRR, same as ColorLut
+struct Frame {
+    std::vector<uint32_t> pixels;
+    uint64_t number = 0;
+};
+
+struct FrameDumperStats {
+    uint64_t submitted = 0;
+    uint64_t written = 0;
+    uint64_t keyframes = 0;
+    uint64_t backpressure = 0;    // acquireFrame() calls that found the pool empty
+    bool write_error = false;
+};
+
+
+class FrameDumper {
+    public:
+    explicit FrameDumper(FrameDumperOptions options);
+    ~FrameDumper();
+
+    FrameDumper(const FrameDumper&) = delete;
+    FrameDumper& operator=(const FrameDumper&) = delete;
+
+    // Opens the output and starts the writer thread
+    bool start();
+
+    // Writes every queued frame, then stops the writer thread
+    void finish();
+
+    // Emulation thread only. nullptr means the writer is behind (backpressure).
+    Frame* acquireFrame();
+    void submitFrame(Frame* frame);
+    void releaseFrame(Frame* frame);              // give back a frame without writing it
+
+    FrameDumperStats stats() const;
+
+    private:
+    void writerLoop();
+    void writeFrame(const Frame& frame);
+
+    FrameDumperOptions options;
+    std::vector<std::unique_ptr<Frame>> pool;
+    SpscQueue<Frame*> free_frames;                // writer -> emulation
+    SpscQueue<Frame*> filled_frames;              // emulation -> writer
+    std::atomic<uint32_t> wake{0};                // bumped on submit/stop, writer waits on it
+    std::atomic<bool> stopping{false};
+
+    std::thread writer;
+    std::ofstream stream;
+    std::vector<uint8_t> rgb;                     // writer-side scratch
+    std::vector<uint8_t> planes;
+
+    uint64_t next_number = 0;
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> keyframes{0};
+    std::atomic<uint64_t> backpressure{0};
+    std::atomic<bool> write_error{false};
+};
+
+
+#endif
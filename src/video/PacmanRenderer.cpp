@@ -0,0 +1,119 @@
+#include "PacmanRenderer.hpp"
+#include <algorithm>
+
+
+static constexpr int TILE_COLUMNS = NATIVE_WIDTH / TILE_SIZE;     // 36
+static constexpr int TILE_ROWS = NATIVE_HEIGHT / TILE_SIZE;       // 28
+static constexpr int SPRITE_COUNT = 8;
+
+
+// Video RAM offset of a tile. The two leftmost and rightmost columns (the score
+// and status lines once rotated) are stored apart from the 32-column playfield.
+static uint32_t tileOffset(int col, int row) {
+    row += 2;
+    col -= 2;
+    if (col & 0x20)
+        return static_cast<uint32_t>(row + ((col & 0x1F) << 5));
+    return static_cast<uint32_t>(col + (row << 5));
+}
+
+
+PacmanRenderer::PacmanRenderer(const DecodedGraphics& graphics, const ColorLut& lut)
+    : graphics(graphics), lut(lut), native(NATIVE_WIDTH * NATIVE_HEIGHT) {}
+
+
+void PacmanRenderer::renderNative(const PacmanMachine& machine) {
+    std::span<const uint8_t> video_ram = machine.videoRam();
+    std::span<const uint8_t> color_ram = machine.colorRam();
+
+    // ----- TILES -----
+    for (int row = 0; row < TILE_ROWS; ++row) {
+        for (int col = 0; col < TILE_COLUMNS; ++col) {
+            const uint32_t offset = tileOffset(col, row);
+            const uint8_t* pens = graphics.tile(video_ram[offset]);
+            const uint8_t* colors = &lut.color_indices[ColorLut::index(color_ram[offset] & 0x1F, 0)];
+
+            uint8_t* dest = &native[row * TILE_SIZE * NATIVE_WIDTH + col * TILE_SIZE];
+            for (size_t y = 0; y < TILE_SIZE; ++y) {
+                for (size_t x = 0; x < TILE_SIZE; ++x)
+                    dest[x] = colors[pens[y * TILE_SIZE + x]];
+                dest += NATIVE_WIDTH;
+            }
+        }
+    }
+
+    // ----- SPRITES -----
+    // Sprite 0 has the highest priority, so draw from the last one down
+    std::span<const uint8_t> sprite_ram = machine.spriteRam();
+    std::span<const uint8_t> coords = machine.spriteCoords();
+
+    for (int sprite = SPRITE_COUNT - 1; sprite >= 0; --sprite) {
+        const int offs = sprite * 2;
+        const int sx = 272 - coords[offs + 1];
+        // The first three sprites sit one line off on the real hardware
+        const int sy = coords[offs] - 31 + (sprite <= 2 ? 1 : 0);
+
+        const uint8_t attributes = sprite_ram[offs];
+        const uint8_t color = sprite_ram[offs + 1] & 0x1F;
+
+        drawSprite(attributes >> 2, color, attributes & 1, attributes & 2, sx, sy);
+        // Sprites wrap around horizontally
+        drawSprite(attributes >> 2, color, attributes & 1, attributes & 2, sx - 256, sy);
+    }
+}
+
+
+void PacmanRenderer::drawSprite(uint8_t code, uint8_t color, bool flip_x, bool flip_y, int sx, int sy) {
+    const uint8_t* pens = graphics.sprite(code);
+    const uint8_t* colors = &lut.color_indices[ColorLut::index(color, 0)];
+
+    for (int y = 0; y < static_cast<int>(SPRITE_SIZE); ++y) {
+        const int dy = sy + y;
+        if (dy < 0 || dy >= static_cast<int>(NATIVE_HEIGHT))
+            continue;
+        const int src_y = flip_y ? static_cast<int>(SPRITE_SIZE) - 1 - y : y;
+
+        for (int x = 0; x < static_cast<int>(SPRITE_SIZE); ++x) {
+            const int dx = sx + x;
+            if (dx < 0 || dx >= static_cast<int>(NATIVE_WIDTH))
+                continue;
+            const int src_x = flip_x ? static_cast<int>(SPRITE_SIZE) - 1 - x : x;
+
+            const uint8_t value = colors[pens[src_y * SPRITE_SIZE + src_x]];
+            if (value != 0)
+                native[dy * NATIVE_WIDTH + dx] = value;
+        }
+    }
+}
+
+
+void PacmanRenderer::renderIndices(const PacmanMachine& machine, std::span<uint8_t> out) {
+    renderIndicesDownsampled(machine, 1, out);
+}
+
+
+void PacmanRenderer::renderRgba(const PacmanMachine& machine, std::span<uint32_t> out) {
+    if (out.size() < SCREEN_WIDTH * SCREEN_HEIGHT)
+        return;
+
+    renderNative(machine);
+    for (uint32_t y = 0; y < SCREEN_HEIGHT; ++y) {
+        for (uint32_t x = 0; x < SCREEN_WIDTH; ++x)
+            out[y * SCREEN_WIDTH + x] = lut.colors[nativePixel(x, y) % COLOR_COUNT];
+    }
+}
+
+
+void PacmanRenderer::renderIndicesDownsampled(const PacmanMachine& machine, uint32_t factor, std::span<uint8_t> out) {
+    factor = std::max<uint32_t>(factor, 1);
+    const uint32_t width = downsampledWidth(factor);
+    const uint32_t height = downsampledHeight(factor);
+    if (out.size() < static_cast<size_t>(width) * height)
+        return;
+
+    renderNative(machine);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x)
+            out[y * width + x] = nativePixel(x * factor, y * factor);
+    }
+}
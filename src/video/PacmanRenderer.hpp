@@ -0,0 +1,54 @@
+#ifndef PACMAN_RENDERER_HPP
+#define PACMAN_RENDERER_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "ColorLut.hpp"
+#include "FrameDumper.hpp"
+#include "TileDecoder.hpp"
+#include "../machine/PacmanMachine.hpp"
+
+/* PacmanRenderer draws the tilemap and sprites of a PacmanMachine.
+ *
+ * The board scans a 288x224 landscape raster; the monitor is mounted rotated,
+ * so frames come out as SCREEN_WIDTH x SCREEN_HEIGHT portrait images. The base
+ * output is one color number (0-31, an index into ColorLut::colors) per pixel;
+ * RGBA is a lookup on top of that. Cocktail flip is not applied.
+ */
+
+constexpr uint32_t NATIVE_WIDTH = 288;
+constexpr uint32_t NATIVE_HEIGHT = 224;
+
+
+class PacmanRenderer {
+    public:
+    // 'graphics' and 'lut' must outlive the renderer
+    PacmanRenderer(const DecodedGraphics& graphics, const ColorLut& lut);
+
+    // 'out' holds SCREEN_WIDTH x SCREEN_HEIGHT color numbers
+    void renderIndices(const PacmanMachine& machine, std::span<uint8_t> out);
+
+    // 'out' holds SCREEN_WIDTH x SCREEN_HEIGHT packed RGBA pixels, e.g. a FrameDumper frame
+    void renderRgba(const PacmanMachine& machine, std::span<uint32_t> out);
+
+    // Keeps every 'factor'-th pixel in both directions; colors are indices, so nothing is blended
+    void renderIndicesDownsampled(const PacmanMachine& machine, uint32_t factor, std::span<uint8_t> out);
+
+    static uint32_t downsampledWidth(uint32_t factor) { return SCREEN_WIDTH / factor; }
+    static uint32_t downsampledHeight(uint32_t factor) { return SCREEN_HEIGHT / factor; }
+
+    private:
+    void renderNative(const PacmanMachine& machine);
+    void drawSprite(uint8_t code, uint8_t color, bool flip_x, bool flip_y, int sx, int sy);
+
+    // Portrait (x, y) -> landscape raster
+    uint8_t nativePixel(uint32_t x, uint32_t y) const { return native[(NATIVE_HEIGHT - 1 - x) * NATIVE_WIDTH + y]; }
+
+    const DecodedGraphics& graphics;
+    const ColorLut& lut;
+    std::vector<uint8_t> native;      // NATIVE_WIDTH x NATIVE_HEIGHT color numbers
+};
+
+
+#endif
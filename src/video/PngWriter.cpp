@@ -0,0 +1,97 @@
+#include "PngWriter.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../utils/Crc32.hpp"
+
+
+static void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+
+static void writeChunk(std::ofstream& out, const char type[4], const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    chunk.reserve(data.size() + 12);
+
+    putBigEndian(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+
+    // CRC covers the type and the data, not the length
+    putBigEndian(chunk, crc32(std::span<const uint8_t>(chunk).subspan(4)));
+
+    out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+
+bool writePng(const std::filesystem::path& output_file, uint32_t width, uint32_t height,
+              std::span<const uint8_t> rgb) {
+    const size_t row_bytes = static_cast<size_t>(width) * 3;
+    if (rgb.size() < row_bytes * height) {
+        std::cerr << "Not enough pixel data for png: " << output_file << "\n";
+        return false;
+    }
+
+    std::ofstream out(output_file, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to create png file: " << output_file << "\n";
+        return false;
+    }
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    // ----- IHDR -----
+    std::vector<uint8_t> header;
+    putBigEndian(header, width);
+    putBigEndian(header, height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });     // 8-bit, truecolor, deflate, no filter, no interlace
+    writeChunk(out, "IHDR", header);
+
+    // ----- IDAT -----
+    // Every scanline starts with filter type 0 (none)
+    std::vector<uint8_t> scanlines;
+    scanlines.reserve((row_bytes + 1) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        scanlines.push_back(0);
+        scanlines.insert(scanlines.end(), rgb.begin() + y * row_bytes, rgb.begin() + (y + 1) * row_bytes);
+    }
+
+    std::vector<uint8_t> zlib;
+    zlib.reserve(scanlines.size() + scanlines.size() / 65535 * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+
+    size_t offset = 0;
+    do {
+        const size_t block = std::min<size_t>(scanlines.size() - offset, 65535);
+        const bool last = offset + block == scanlines.size();
+
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(block));
+        zlib.push_back(static_cast<uint8_t>(block >> 8));
+        zlib.push_back(static_cast<uint8_t>(~block));
+        zlib.push_back(static_cast<uint8_t>(~block >> 8));
+        zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + block);
+
+        offset += block;
+    } while (offset < scanlines.size());
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : scanlines) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    putBigEndian(zlib, (b << 16) | a);
+
+    writeChunk(out, "IDAT", zlib);
+    writeChunk(out, "IEND", {});
+
+    return static_cast<bool>(out);
+}
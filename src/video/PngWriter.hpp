@@ -0,0 +1,14 @@
+#ifndef PNG_WRITER_HPP
+#define PNG_WRITER_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+// Writes 8-bit RGB pixels as a PNG. The image data is stored uncompressed
+// (deflate "stored" blocks), which keeps encoding cost close to a memcpy.
+bool writePng(const std::filesystem::path& output_file, uint32_t width, uint32_t height,
+              std::span<const uint8_t> rgb);
+
+
+#endif
@@ -0,0 +1,59 @@
+#include "TileDecoder.hpp"
+#include <iostream>
+
+
+/* Both ROMs store two bitplanes in the same byte: bits 7-4 hold plane 0 (the
+ * high bit of the pen) and bits 3-0 plane 1, four pixels per byte, MSB first.
+ * X offsets below are bit offsets inside one graphic, Y offsets bit offsets of a row.
+ */
+static constexpr uint32_t TILE_X_OFFSETS[8] = { 64, 65, 66, 67, 0, 1, 2, 3 };
+static constexpr uint32_t SPRITE_X_OFFSETS[16] = {
+    64, 65, 66, 67, 128, 129, 130, 131, 192, 193, 194, 195, 0, 1, 2, 3
+};
+static constexpr uint32_t SPRITE_Y_OFFSETS[16] = {
+    0, 8, 16, 24, 32, 40, 48, 56, 256, 264, 272, 280, 288, 296, 304, 312
+};
+
+
+static uint8_t readPen(const uint8_t* graphic, uint32_t bit) {
+    const uint8_t high = (graphic[bit / 8] >> (7 - bit % 8)) & 1;
+    const uint32_t low_bit = bit + 4;
+    const uint8_t low = (graphic[low_bit / 8] >> (7 - low_bit % 8)) & 1;
+    return static_cast<uint8_t>((high << 1) | low);
+}
+
+
+bool decodeGraphics(std::span<const uint8_t> tile_rom, std::span<const uint8_t> sprite_rom, DecodedGraphics& out) {
+    if (tile_rom.size() < TILE_BYTES || sprite_rom.size() < SPRITE_BYTES) {
+        std::cerr << "Tile or sprite ROM missing\n";
+        return false;
+    }
+
+    out.tile_count = tile_rom.size() / TILE_BYTES;
+    out.tiles.resize(out.tile_count * TILE_SIZE * TILE_SIZE);
+
+    for (size_t t = 0; t < out.tile_count; ++t) {
+        const uint8_t* graphic = tile_rom.data() + t * TILE_BYTES;
+        uint8_t* pens = out.tiles.data() + t * TILE_SIZE * TILE_SIZE;
+
+        for (size_t y = 0; y < TILE_SIZE; ++y) {
+            for (size_t x = 0; x < TILE_SIZE; ++x)
+                pens[y * TILE_SIZE + x] = readPen(graphic, TILE_X_OFFSETS[x] + static_cast<uint32_t>(y * 8));
+        }
+    }
+
+    out.sprite_count = sprite_rom.size() / SPRITE_BYTES;
+    out.sprites.resize(out.sprite_count * SPRITE_SIZE * SPRITE_SIZE);
+
+    for (size_t s = 0; s < out.sprite_count; ++s) {
+        const uint8_t* graphic = sprite_rom.data() + s * SPRITE_BYTES;
+        uint8_t* pens = out.sprites.data() + s * SPRITE_SIZE * SPRITE_SIZE;
+
+        for (size_t y = 0; y < SPRITE_SIZE; ++y) {
+            for (size_t x = 0; x < SPRITE_SIZE; ++x)
+                pens[y * SPRITE_SIZE + x] = readPen(graphic, SPRITE_X_OFFSETS[x] + SPRITE_Y_OFFSETS[y]);
+        }
+    }
+
+    return true;
+}
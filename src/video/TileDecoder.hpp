@@ -0,0 +1,34 @@
+#ifndef TILE_DECODER_HPP
+#define TILE_DECODER_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/* TileDecoder expands the 2 bits-per-pixel tile (5E) and sprite (5F) ROMs into
+ * one byte per pixel (pen 0-3), in the board's native landscape orientation.
+ * Decoding happens once; renderers then copy pens without any bit twiddling.
+ */
+
+constexpr size_t TILE_SIZE = 8;
+constexpr size_t TILE_BYTES = 16;
+constexpr size_t SPRITE_SIZE = 16;
+constexpr size_t SPRITE_BYTES = 64;
+
+struct DecodedGraphics {
+    std::vector<uint8_t> tiles;      // tile_count x 8 x 8 pens
+    std::vector<uint8_t> sprites;    // sprite_count x 16 x 16 pens
+    size_t tile_count = 0;
+    size_t sprite_count = 0;
+
+    const uint8_t* tile(size_t code) const { return tiles.data() + (code % tile_count) * TILE_SIZE * TILE_SIZE; }
+    const uint8_t* sprite(size_t code) const {
+        return sprites.data() + (code % sprite_count) * SPRITE_SIZE * SPRITE_SIZE;
+    }
+};
+
+
+bool decodeGraphics(std::span<const uint8_t> tile_rom, std::span<const uint8_t> sprite_rom, DecodedGraphics& out);
+
+
+#endif
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <memory>
+#include "Check.hpp"
+#include "io/BakedRomSet.hpp"
+#include "io/RomManager.hpp"
+#include "rl/PacmanEnv.hpp"
+
+
+#ifdef PACMAN_TEST_ROM_DIR
+
+/* Built with PACMAN_BAKE_ROMS: the baked tables must match what decoding the same
+ * ROM folder produces at runtime, and the generated blocks must run the program
+ * exactly like the interpreter does.
+ */
+
+static bool loadFromRomFolder(PacmanEnvAssets& out) {
+    RomSetDescription rom_set;
+    if (const RomSetDescription* builtin = findBuiltinRomSet(PACMAN_TEST_ROM_SET))
+        rom_set = *builtin;
+    else if (!loadRomSetDescription(PACMAN_TEST_ROM_SET, rom_set))
+        return false;
+
+    RomSetImage image;
+    return RomManager(PACMAN_TEST_ROM_DIR, rom_set).loadRegions(image) && loadPacmanEnvAssets(image, out);
+}
+
+
+static void tablesMatchRomFolder() {
+    const BakedRomSet* baked = bakedRomSet();
+    CHECK(baked != nullptr);
+    if (!baked)
+        return;
+
+    PacmanEnvAssets from_baked;
+    PacmanEnvAssets from_roms;
+    CHECK(loadBakedPacmanEnvAssets(from_baked));
+    CHECK(loadFromRomFolder(from_roms));
+
+    CHECK(from_baked.program == from_roms.program);
+    CHECK(from_baked.graphics.tiles == from_roms.graphics.tiles);
+    CHECK(from_baked.graphics.sprites == from_roms.graphics.sprites);
+    CHECK_EQ(from_baked.graphics.tile_count, from_roms.graphics.tile_count);
+    CHECK_EQ(from_baked.graphics.sprite_count, from_roms.graphics.sprite_count);
+    CHECK(from_baked.lut.colors == from_roms.lut.colors);
+    CHECK(from_baked.lut.color_indices == from_roms.lut.color_indices);
+    CHECK(from_baked.lut.rgba == from_roms.lut.rgba);
+
+    CHECK(!baked->blocks.empty());
+    CHECK(std::ranges::is_sorted(baked->blocks, {}, &Z80GeneratedBlock::start));
+    for (const Z80GeneratedBlock& block : baked->blocks) {
+        CHECK(block.start < block.end);
+        CHECK(block.end <= baked->program.size());
+    }
+    CHECK(from_baked.blocks != nullptr);
+    CHECK(from_roms.blocks == nullptr);
+}
+
+
+static void generatedCodeRunsLikeInterpreter() {
+    auto from_baked = std::make_shared<PacmanEnvAssets>();
+    auto from_roms = std::make_shared<PacmanEnvAssets>();
+    if (!loadBakedPacmanEnvAssets(*from_baked) || !loadFromRomFolder(*from_roms)) {
+        CHECK(false);
+        return;
+    }
+
+    PacmanEnvOptions options;
+    options.framebuffer_downsample = 2;
+    PacmanEnv generated(from_baked, options);
+    PacmanEnv interpreted(from_roms, options);
+
+    for (int step = 0; step < 120; ++step) {
+        const PacmanInput input{ static_cast<uint8_t>(0xFF ^ (1 << (step / 10 % 8))), 0xFF };
+        const PacmanObservation& fast = generated.step(input, 2);
+        const PacmanObservation& reference = interpreted.step(input, 2);
+        if (!std::ranges::equal(fast.ram, reference.ram) || !std::ranges::equal(fast.framebuffer, reference.framebuffer)) {
+            std::cerr << "Generated code diverged at step " << step << "\n";
+            CHECK(false);
+            return;
+        }
+    }
+}
+
+
+int main() {
+    tablesMatchRomFolder();
+    generatedCodeRunsLikeInterpreter();
+    return testResult("BakedRomSetBakedTest");
+}
+
+#else
+
+// Without baking the stub reports no tables and leaves the assets alone
+int main() {
+    CHECK(bakedRomSet() == nullptr);
+
+    PacmanEnvAssets assets;
+    CHECK(!loadBakedPacmanEnvAssets(assets));
+    CHECK(assets.program.empty());
+    CHECK(assets.blocks == nullptr);
+    return testResult("BakedRomSetTest");
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TEST_CHECK_HPP
+#define TEST_CHECK_HPP
+
+#include <iostream>
+
+/* Minimal checks for the unit tests. A failed CHECK reports its location and the
+ * test keeps going; testResult() turns the failure count into main()'s exit code,
+ * which is what ctest looks at.
+ */
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n";     \
+            ++testFailures();                                                                   \
+        }                                                                                       \
+    } while (false)
+
+#define CHECK_EQ(actual, expected)                                                              \
+    do {                                                                                        \
+        const auto actual_value = (actual);                                                     \
+        const auto expected_value = (expected);                                                 \
+        if (!(actual_value == expected_value)) {                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #actual " is " << +actual_value    \
+                      << ", expected " << +expected_value << "\n";                              \
+            ++testFailures();                                                                   \
+        }                                                                                       \
+    } while (false)
+
+inline int testResult(const char* name) {
+    if (testFailures() == 0)
+        return 0;
+    std::cerr << name << ": " << testFailures() << " check(s) failed\n";
+    return 1;
+}
+
+
+#endif
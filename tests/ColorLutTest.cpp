@@ -0,0 +1,80 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "Check.hpp"
+#include "video/ColorLut.hpp"
+
+
+static uint32_t rgba(uint8_t r, uint8_t g, uint8_t b) {
+    return r | (g << 8) | (b << 16) | 0xFF000000u;
+}
+
+
+// Resistor weights as in MAME's pacman driver: 0x21/0x47/0x97 for red and green, 0x51/0xae for blue
+static void promColorWeights() {
+    CHECK_EQ(decodePromColor(0x00), rgba(0, 0, 0));
+    CHECK_EQ(decodePromColor(0x01), rgba(0x21, 0, 0));
+    CHECK_EQ(decodePromColor(0x02), rgba(0x47, 0, 0));
+    CHECK_EQ(decodePromColor(0x04), rgba(0x97, 0, 0));
+    CHECK_EQ(decodePromColor(0x07), rgba(0xFF, 0, 0));
+    CHECK_EQ(decodePromColor(0x38), rgba(0, 0xFF, 0));
+    CHECK_EQ(decodePromColor(0x40), rgba(0, 0, 0x51));
+    CHECK_EQ(decodePromColor(0x80), rgba(0, 0, 0xAE));
+    CHECK_EQ(decodePromColor(0xC0), rgba(0, 0, 0xFF));
+    CHECK_EQ(decodePromColor(0xFF), rgba(0xFF, 0xFF, 0xFF));
+}
+
+
+static void indexPacking() {
+    CHECK_EQ(ColorLut::index(0, 0), 0u);
+    CHECK_EQ(ColorLut::index(1, 3), 7u);
+    CHECK_EQ(ColorLut::index(0x3F, 3), COLOR_LUT_SIZE - 1);
+    // Palette and pen are masked to the bits the board decodes
+    CHECK_EQ(ColorLut::index(0x41, 7), ColorLut::index(0x01, 3));
+}
+
+
+static void buildsFromPromRegion() {
+    std::vector<uint8_t> region(PALETTE_PROM_OFFSET + COLOR_LUT_SIZE, 0x00);
+    for (size_t i = 0; i < COLOR_COUNT; ++i)
+        region[COLOR_PROM_OFFSET + i] = static_cast<uint8_t>(i * 8);
+    for (size_t i = 0; i < COLOR_LUT_SIZE; ++i)
+        region[PALETTE_PROM_OFFSET + i] = static_cast<uint8_t>(0xF0 | (i % 16));   // high nibble is not wired
+
+    ColorLut lut;
+    CHECK(buildColorLut(region, lut));
+    CHECK_EQ(lut.colors[5], decodePromColor(5 * 8));
+    CHECK_EQ(lut.color_indices[ColorLut::index(1, 2)], 6);
+    CHECK_EQ(lut.lookup(1, 2), lut.colors[6]);
+    CHECK(lut.isTransparent(0, 0));
+    CHECK(!lut.isTransparent(0, 1));
+
+    ColorLut small;
+    CHECK(!buildColorLut(std::span<const uint8_t>(region).first(PALETTE_PROM_OFFSET), small));
+
+    // Binary export is the packed table as R, G, B, A bytes
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "pacman_color_lut_test.bin";
+    CHECK(exportColorLut(lut, path));
+    std::ifstream in(path, std::ios::binary);
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    CHECK_EQ(bytes.size(), COLOR_LUT_SIZE * 4);
+    if (bytes.size() == COLOR_LUT_SIZE * 4) {
+        const uint32_t color = lut.lookup(1, 2);
+        const size_t offset = ColorLut::index(1, 2) * 4;
+        CHECK_EQ(bytes[offset + 0], color & 0xFF);
+        CHECK_EQ(bytes[offset + 1], (color >> 8) & 0xFF);
+        CHECK_EQ(bytes[offset + 2], (color >> 16) & 0xFF);
+        CHECK_EQ(bytes[offset + 3], 0xFF);
+    }
+    in.close();
+    std::filesystem::remove(path);
+}
+
+
+int main() {
+    promColorWeights();
+    indexPacking();
+    buildsFromPromRegion();
+    return testResult("ColorLutTest");
+}
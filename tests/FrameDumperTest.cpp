@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Check.hpp"
+#include "utils/Crc32.hpp"
+#include "video/FrameDumper.hpp"
+#include "video/PngWriter.hpp"
+
+
+namespace {
+
+const std::filesystem::path TEST_DIR = std::filesystem::temp_directory_path() / "pacman_frame_dumper_test";
+
+
+std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+
+uint32_t bigEndian(const uint8_t* bytes) {
+    return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+}
+
+
+/* Reads back what writePng() produces: checks the signature, every chunk CRC, the
+ * zlib stored blocks and the Adler-32, and returns the RGB pixels (empty on error).
+ */
+std::vector<uint8_t> readPng(const std::filesystem::path& path, uint32_t& width, uint32_t& height) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    const std::vector<uint8_t> file = readFile(path);
+    if (file.size() < 8 || !std::equal(signature, signature + 8, file.begin()))
+        return {};
+
+    std::vector<uint8_t> zlib;
+    size_t offset = 8;
+    while (offset + 12 <= file.size()) {
+        const uint32_t length = bigEndian(&file[offset]);
+        const std::string type(file.begin() + offset + 4, file.begin() + offset + 8);
+        const std::span<const uint8_t> checked(file.data() + offset + 4, length + 4);
+        if (offset + 12 + length > file.size() || crc32(checked) != bigEndian(&file[offset + 8 + length]))
+            return {};
+
+        const uint8_t* data = &file[offset + 8];
+        if (type == "IHDR") {
+            width = bigEndian(data);
+            height = bigEndian(data + 4);
+        }
+        else if (type == "IDAT") {
+            zlib.insert(zlib.end(), data, data + length);
+        }
+        offset += 12 + length;
+    }
+
+    std::vector<uint8_t> scanlines;
+    size_t at = 2;
+    bool last = false;
+    while (!last && at + 5 <= zlib.size()) {
+        last = zlib[at] & 1;
+        const size_t block = zlib[at + 1] | (zlib[at + 2] << 8);
+        const size_t inverse = zlib[at + 3] | (zlib[at + 4] << 8);
+        if ((block ^ inverse) != 0xFFFF)
+            return {};
+        scanlines.insert(scanlines.end(), zlib.begin() + at + 5, zlib.begin() + at + 5 + block);
+        at += 5 + block;
+    }
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : scanlines) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    if (!last || at + 4 != zlib.size() || bigEndian(&zlib[at]) != ((b << 16) | a))
+        return {};
+
+    std::vector<uint8_t> rgb;
+    const size_t row_bytes = static_cast<size_t>(width) * 3;
+    for (size_t row = 0; row < height; ++row) {
+        if (scanlines[row * (row_bytes + 1)] != 0)
+            return {};
+        const auto start = scanlines.begin() + row * (row_bytes + 1) + 1;
+        rgb.insert(rgb.end(), start, start + row_bytes);
+    }
+    return rgb;
+}
+
+}   // namespace
+
+
+static void pngRoundTrip() {
+    // Large enough to need several stored blocks
+    const uint32_t width = SCREEN_WIDTH;
+    const uint32_t height = SCREEN_HEIGHT;
+    std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+    for (size_t i = 0; i < rgb.size(); ++i)
+        rgb[i] = static_cast<uint8_t>(i * 7);
+
+    const std::filesystem::path path = TEST_DIR / "image.png";
+    CHECK(writePng(path, width, height, rgb));
+
+    uint32_t read_width = 0;
+    uint32_t read_height = 0;
+    CHECK(readPng(path, read_width, read_height) == rgb);
+    CHECK_EQ(read_width, width);
+    CHECK_EQ(read_height, height);
+
+    CHECK(!writePng(TEST_DIR / "short.png", width, height, std::span<const uint8_t>(rgb).first(10)));
+}
+
+
+// Y4M header, one FRAME per submitted frame with BT.601 levels, PNG every other frame
+static void dumpsY4mAndKeyframes() {
+    FrameDumperOptions options;
+    options.output_file = TEST_DIR / "frames.y4m";
+    options.keyframe_folder = TEST_DIR / "keyframes";
+    options.keyframe_interval = 2;
+    options.width = 4;
+    options.height = 2;
+    options.pool_size = 2;
+
+    const uint32_t colors[3] = { 0xFFFFFFFFu, 0xFF000000u, 0xFF0000FFu };   // white, black, red
+    {
+        FrameDumper dumper(options);
+        CHECK(dumper.start());
+        for (uint32_t color : colors) {
+            Frame* frame = nullptr;
+            while (!(frame = dumper.acquireFrame()))
+                std::this_thread::yield();
+            std::fill(frame->pixels.begin(), frame->pixels.end(), color);
+            dumper.submitFrame(frame);
+        }
+        dumper.finish();
+
+        const FrameDumperStats stats = dumper.stats();
+        CHECK_EQ(stats.submitted, 3u);
+        CHECK_EQ(stats.written, 3u);
+        CHECK_EQ(stats.keyframes, 2u);
+        CHECK(!stats.write_error);
+    }
+
+    const std::string header = "YUV4MPEG2 W4 H2 F60606:1000 Ip A1:1 C444\n";
+    const size_t plane = 4 * 2;
+    const size_t frame_bytes = 6 + plane * 3;
+    const std::vector<uint8_t> stream = readFile(options.output_file);
+    CHECK_EQ(stream.size(), header.size() + 3 * frame_bytes);
+    if (stream.size() == header.size() + 3 * frame_bytes) {
+        CHECK(std::string(stream.begin(), stream.begin() + header.size()) == header);
+
+        const uint8_t expected[3][3] = { { 235, 128, 128 }, { 16, 128, 128 }, { 82, 90, 240 } };
+        for (size_t f = 0; f < 3; ++f) {
+            const size_t start = header.size() + f * frame_bytes;
+            CHECK(std::string(stream.begin() + start, stream.begin() + start + 6) == "FRAME\n");
+            for (size_t p = 0; p < 3; ++p)
+                CHECK_EQ(stream[start + 6 + p * plane], expected[f][p]);
+        }
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const std::vector<uint8_t> keyframe = readPng(options.keyframe_folder / "frame_00000002.png", width, height);
+    CHECK_EQ(keyframe.size(), plane * 3);
+    if (!keyframe.empty()) {
+        CHECK_EQ(keyframe[0], 0xFF);
+        CHECK_EQ(keyframe[1], 0x00);
+        CHECK_EQ(keyframe[2], 0x00);
+    }
+    CHECK(std::filesystem::exists(options.keyframe_folder / "frame_00000000.png"));
+    CHECK(!std::filesystem::exists(options.keyframe_folder / "frame_00000001.png"));
+}
+
+
+static void rawStreamAndBackpressure() {
+    FrameDumperOptions options;
+    options.output_file = TEST_DIR / "frames.rgb";
+    options.format = FrameFormat::RawRgb;
+    options.width = 2;
+    options.height = 2;
+    options.pool_size = 2;
+
+    FrameDumper dumper(options);
+
+    // Nothing drains the pool before start(), so the third frame is refused and counted
+    Frame* first = dumper.acquireFrame();
+    Frame* second = dumper.acquireFrame();
+    CHECK(first && second);
+    CHECK(dumper.acquireFrame() == nullptr);
+    CHECK_EQ(dumper.stats().backpressure, 1u);
+
+    CHECK(dumper.start());
+    dumper.submitFrame(first);
+    dumper.releaseFrame(second);
+    dumper.finish();
+
+    CHECK_EQ(dumper.stats().written, 1u);
+    CHECK_EQ(readFile(options.output_file).size(), 2u * 2u * 3u);
+}
+
+
+int main() {
+    std::filesystem::remove_all(TEST_DIR);
+    std::filesystem::create_directories(TEST_DIR);
+
+    pngRoundTrip();
+    dumpsY4mAndKeyframes();
+    rawStreamAndBackpressure();
+
+    std::filesystem::remove_all(TEST_DIR);
+    return testResult("FrameDumperTest");
+}
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include "Check.hpp"
+#include "rl/PacmanEnv.hpp"
+
+
+namespace {
+
+/* A stand-in program: adds IN0 to a RAM byte every iteration, counts iterations in
+ * the next byte and copies the sum into video and color RAM, so both the RAM and
+ * the framebuffer depend on the inputs of every step.
+ */
+std::shared_ptr<const PacmanEnvAssets> makeAssets() {
+    RomSetImage image;
+    image.set_name = "test";
+    image.regions[static_cast<size_t>(RomRegion::Code)].assign(0x4000, 0x00);
+    image.regions[static_cast<size_t>(RomRegion::Tiles)].resize(0x1000);
+    image.regions[static_cast<size_t>(RomRegion::Sprites)].resize(0x1000);
+    image.regions[static_cast<size_t>(RomRegion::Color)].resize(0x0120);
+
+    const uint8_t program[] = {
+        0x31, 0xF0, 0x4F,       // ld sp,4FF0h
+        0x3A, 0x00, 0x50,       // ld a,(5000h)
+        0x21, 0x00, 0x4E,       // ld hl,4E00h
+        0x86,                   // add a,(hl)
+        0x77,                   // ld (hl),a
+        0x23,                   // inc hl
+        0x34,                   // inc (hl)
+        0x32, 0x40, 0x40,       // ld (4040h),a
+        0x32, 0x40, 0x44,       // ld (4440h),a
+        0xC3, 0x03, 0x00        // jp 0003h
+    };
+    std::ranges::copy(program, image.regions[static_cast<size_t>(RomRegion::Code)].begin());
+
+    for (RomRegion region : { RomRegion::Tiles, RomRegion::Sprites, RomRegion::Color }) {
+        std::vector<uint8_t>& bytes = image.regions[static_cast<size_t>(region)];
+        for (size_t i = 0; i < bytes.size(); ++i)
+            bytes[i] = static_cast<uint8_t>(i * 13 + 7);
+    }
+
+    auto assets = std::make_shared<PacmanEnvAssets>();
+    CHECK(loadPacmanEnvAssets(image, *assets));
+    return assets;
+}
+
+
+PacmanEnvOptions testOptions() {
+    PacmanEnvOptions options;
+    options.features = { { "sum", 0x4E00, 2 }, { "score", 0x4E80, 3 } };
+    options.framebuffer_downsample = 4;
+    options.warmup_frames = 2;
+    return options;
+}
+
+
+PacmanInput inputFor(size_t step, size_t env) {
+    return { static_cast<uint8_t>(0xFF ^ (1 << ((step + env) & 7))), 0xFF };
+}
+
+}   // namespace
+
+
+static void observationViewsRam() {
+    PacmanEnv env(makeAssets(), testOptions());
+    const PacmanObservation& first = env.reset();
+    CHECK_EQ(first.frame, 2u);
+    CHECK_EQ(first.framebuffer_width, SCREEN_WIDTH / 4);
+    CHECK_EQ(first.framebuffer_height, SCREEN_HEIGHT / 4);
+    CHECK_EQ(first.framebuffer.size(), (SCREEN_WIDTH / 4) * (SCREEN_HEIGHT / 4));
+
+    const PacmanObservation& next = env.step(inputFor(0, 0), 3);
+    CHECK_EQ(next.frame, 5u);
+    CHECK(next.feature(0).data() == next.ram.data() + 0x0E00);
+    CHECK_EQ(next.feature(0).size(), 2u);
+
+    // The input reaches the program
+    PacmanEnv other(makeAssets(), testOptions());
+    other.step(inputFor(1, 0), 3);
+    CHECK(!std::ranges::equal(other.observation().ram, next.ram));
+
+    // Score is BCD, low byte first
+    std::vector<uint8_t> ram(PACMAN_RAM_SIZE, 0);
+    ram[0x0E80] = 0x50;
+    ram[0x0E81] = 0x34;
+    ram[0x0E82] = 0x12;
+    ram[0x0E0E] = 4;
+    CHECK_EQ(pacmanScore(ram), 123450u);
+    CHECK_EQ(pacmanDotsRemaining(ram), PACMAN_TOTAL_DOTS - 4);
+}
+
+
+// Every batch layout, threaded or not, gives the same results as separate environments
+static void batchMatchesSingleEnvs() {
+    const std::shared_ptr<const PacmanEnvAssets> assets = makeAssets();
+    const PacmanEnvOptions options = testOptions();
+    const size_t count = 9;
+
+    for (unsigned threads : { 1u, 4u, 16u }) {
+        PacmanEnvBatch batch(assets, count, options, threads);
+        std::vector<std::unique_ptr<PacmanEnv>> single;
+        for (size_t i = 0; i < count; ++i) {
+            single.push_back(std::make_unique<PacmanEnv>(assets, options));
+            single.back()->reset();
+        }
+        batch.reset();
+
+        std::vector<PacmanInput> inputs(count);
+        for (size_t step = 0; step < 20; ++step) {
+            for (size_t i = 0; i < count; ++i)
+                inputs[i] = inputFor(step, i);
+            batch.step(inputs, 2);
+
+            if (step == 10) {
+                batch.reset(3);
+                single[3]->reset();
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                const PacmanObservation& observed = step == 10 && i == 3 ? single[i]->observation()
+                                                                         : single[i]->step(inputs[i], 2);
+                CHECK(std::ranges::equal(observed.ram, batch.ram(i)));
+                CHECK(std::ranges::equal(observed.framebuffer, batch.framebuffer(i)));
+                CHECK_EQ(batch.featureColumn(0, 0)[i], observed.feature(0)[0]);
+                CHECK_EQ(batch.featureColumn(0, 1)[i], observed.feature(0)[1]);
+            }
+        }
+        CHECK_EQ(batch.framebufferWidth(), SCREEN_WIDTH / 4);
+    }
+}
+
+
+// Attached dumpers see every frame, warmup included
+static void feedsFrameDumper() {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "pacman_env_test.rgb";
+    FrameDumperOptions dump_options;
+    dump_options.output_file = path;
+    dump_options.format = FrameFormat::RawRgb;
+    dump_options.pool_size = 64;
+
+    {
+        FrameDumper dumper(dump_options);
+        CHECK(dumper.start());
+
+        PacmanEnv env(makeAssets(), testOptions());
+        env.attachFrameDumper(&dumper);
+        env.reset();
+        env.step(inputFor(0, 0), 5);
+        env.attachFrameDumper(nullptr);
+        env.step(inputFor(1, 0), 5);
+        dumper.finish();
+
+        CHECK_EQ(dumper.stats().submitted + dumper.stats().backpressure, 7u);
+        CHECK_EQ(std::filesystem::file_size(path), dumper.stats().written * SCREEN_WIDTH * SCREEN_HEIGHT * 3);
+    }
+    std::filesystem::remove(path);
+}
+
+
+int main() {
+    observationViewsRam();
+    batchMatchesSingleEnvs();
+    feedsFrameDumper();
+    return testResult("PacmanEnvTest");
+}
@@ -0,0 +1,62 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Check.hpp"
+#include "io/RomPatch.hpp"
+
+
+static const std::filesystem::path PATCH_FILE = std::filesystem::temp_directory_path() / "pacman_rom_patch_test.patch";
+
+
+static std::vector<RomPatch> parse(const std::string& text) {
+    std::ofstream(PATCH_FILE, std::ios::binary) << text;
+    return loadRomPatches(PATCH_FILE);
+}
+
+
+static void parsesPatchLines() {
+    const std::vector<RomPatch> patches = parse("# Pac-Man fixes\n"
+                                                "3a5c: 00 00 c9      ; comment\n"
+                                                "\n"
+                                                "  0100 :1F\t30 \r\n"
+                                                "ffff: ff\n");
+    CHECK_EQ(patches.size(), 3u);
+    if (patches.size() != 3)
+        return;
+    CHECK_EQ(patches[0].address, 0x3A5C);
+    CHECK((patches[0].bytes == std::vector<uint8_t>{ 0x00, 0x00, 0xC9 }));
+    CHECK_EQ(patches[1].address, 0x0100);
+    CHECK((patches[1].bytes == std::vector<uint8_t>{ 0x1F, 0x30 }));
+    CHECK_EQ(patches[2].address, 0xFFFF);
+}
+
+
+// One bad line rejects the whole file instead of patching part of it
+static void rejectsMalformedLines() {
+    for (const char* bad : {
+             "0100: 1F 2G 30\n",        // stops inside a token
+             "0100: ZZ 30\n",           // no byte parsed
+             "0100:\n",                 // nothing to patch
+             "0100: 1F 100\n",          // byte out of range
+             "10000: 00\n",             // address out of range
+             "01g0: 00\n",              // junk in the address
+             ": 00\n",
+             "0100 00 c9\n" }) {        // no colon
+        const std::vector<RomPatch> patches = parse(std::string("0200: c9\n") + bad);
+        if (!patches.empty())
+            std::cerr << "Accepted: " << bad;
+        CHECK(patches.empty());
+    }
+
+    std::filesystem::remove(PATCH_FILE);
+    CHECK(loadRomPatches(PATCH_FILE).empty());
+}
+
+
+int main() {
+    parsesPatchLines();
+    rejectsMalformedLines();
+    std::filesystem::remove(PATCH_FILE);
+    return testResult("RomPatchTest");
+}
@@ -0,0 +1,166 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Check.hpp"
+#include "io/RomManager.hpp"
+#include "io/RomSet.hpp"
+#include "utils/Crc32.hpp"
+
+
+namespace {
+
+const std::filesystem::path TEST_DIR = std::filesystem::temp_directory_path() / "pacman_rom_set_test";
+
+
+void writeFile(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary);
+    out << text;
+}
+
+
+void writeRom(const std::filesystem::path& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+}   // namespace
+
+
+static void crcMatchesReference() {
+    const std::string check = "123456789";
+    const std::span<const uint8_t> bytes(reinterpret_cast<const uint8_t*>(check.data()), check.size());
+    CHECK_EQ(crc32(bytes), 0xCBF43926u);
+
+    // Running checksum over two halves
+    CHECK_EQ(crc32(bytes.subspan(4), crc32(bytes.first(4))), 0xCBF43926u);
+}
+
+
+static void builtinSetsAreComplete() {
+    CHECK_EQ(builtinRomSets().size(), 3u);
+    for (const RomSetDescription& set : builtinRomSets()) {
+        CHECK(findBuiltinRomSet(set.name) == &set);
+        for (const RomFileSpec& file : set.files) {
+            if (!file.check_crc)
+                std::cerr << set.name << "/" << file.name << " has no CRC\n";
+            CHECK(file.check_crc);
+        }
+    }
+    CHECK(findBuiltinRomSet("galaga") == nullptr);
+
+    const RomSetDescription pacman = pacmanRomSet();
+    CHECK_EQ(pacman.regionSize(RomRegion::Code), 0x4000u);
+    CHECK_EQ(pacman.regionSize(RomRegion::Color), 0x0120u);
+    CHECK_EQ(mspacmanBootlegRomSet().regionSize(RomRegion::Code), 0xA000u);
+}
+
+
+static void parsesDescriptionFiles() {
+    const std::filesystem::path path = TEST_DIR / "custom.txt";
+    writeFile(path,
+        "# test set\n"
+        "set custom\n"
+        "description Custom board   # trailing comment\n"
+        "rom code   high.bin 0x1000 0x1000 -\n"
+        "rom code   low.bin  0x0000 0x1000 CBF43926\n"
+        "\n"
+        "rom color  pal.bin  0x0020 0x0100 -\n");
+
+    RomSetDescription set;
+    CHECK(loadRomSetDescription(path, set));
+    CHECK(set.name == "custom");
+    CHECK(set.description == "Custom board");
+    CHECK_EQ(set.files.size(), 3u);
+    if (set.files.size() == 3) {
+        CHECK(!set.files[0].check_crc);
+        CHECK(set.files[1].check_crc);
+        CHECK_EQ(set.files[1].crc32, 0xCBF43926u);
+        CHECK(set.files[2].region == RomRegion::Color);
+    }
+    CHECK((set.filesInRegion(RomRegion::Code) == std::vector<std::string>{ "low.bin", "high.bin" }));
+    CHECK_EQ(set.regionSize(RomRegion::Code), 0x2000u);
+    CHECK_EQ(set.regionSize(RomRegion::Sound), 0u);
+
+    // Errors leave the output untouched
+    const RomSetDescription before = set;
+    writeFile(path, "set broken\nrom nowhere a.bin 0x0000 0x0010 -\n");
+    CHECK(!loadRomSetDescription(path, set));
+    writeFile(path, "set broken\nrom code a.bin 0x0000 0x0010 12xz\n");
+    CHECK(!loadRomSetDescription(path, set));
+    writeFile(path, "set broken\nchecksum a.bin\n");
+    CHECK(!loadRomSetDescription(path, set));
+    writeFile(path, "description no name or files\n");
+    CHECK(!loadRomSetDescription(path, set));
+    CHECK(!loadRomSetDescription(TEST_DIR / "missing.txt", set));
+    CHECK(set.name == before.name);
+    CHECK_EQ(set.files.size(), before.files.size());
+}
+
+
+// Identical contents share one buffer; equal size alone does not
+static void cacheSharesIdenticalFiles() {
+    writeRom(TEST_DIR / "a.bin", std::vector<uint8_t>(64, 0x11));
+    writeRom(TEST_DIR / "b.bin", std::vector<uint8_t>(64, 0x11));
+    writeRom(TEST_DIR / "c.bin", std::vector<uint8_t>(64, 0x22));
+
+    RomCache cache;
+    const RomData a = cache.load(TEST_DIR / "a.bin");
+    const RomData b = cache.load(TEST_DIR / "b.bin");
+    const RomData c = cache.load(TEST_DIR / "c.bin");
+    CHECK(a && b && c);
+    CHECK(a == b);
+    CHECK(a != c);
+    CHECK(cache.load(TEST_DIR / "." / "a.bin") == a);
+    CHECK(cache.load(TEST_DIR / "missing.bin") == nullptr);
+    if (c)
+        CHECK_EQ((*c)[0], 0x22);
+}
+
+
+// Regions are filled with 0xFF and two managers sharing a cache share the file buffers
+static void loadsRegions() {
+    writeRom(TEST_DIR / "low.bin", std::vector<uint8_t>(0x1000, 0xAA));
+    writeRom(TEST_DIR / "pal.bin", std::vector<uint8_t>(0x0100, 0x0F));
+    writeFile(TEST_DIR / "regions.txt",
+        "set regions\n"
+        "rom code  low.bin 0x0000 0x1000 -\n"
+        "rom color pal.bin 0x0020 0x0100 -\n");
+
+    RomSetDescription set;
+    CHECK(loadRomSetDescription(TEST_DIR / "regions.txt", set));
+
+    RomCache cache;
+    RomSetImage first;
+    RomSetImage second;
+    CHECK(RomManager(TEST_DIR.string(), set).loadRegions(first, &cache));
+    CHECK(RomManager(TEST_DIR.string(), set).loadRegions(second, &cache));
+
+    CHECK(first.set_name == "regions");
+    CHECK_EQ(first.region(RomRegion::Code).size(), 0x1000u);
+    CHECK_EQ(first.region(RomRegion::Color).size(), 0x0120u);
+    CHECK_EQ(first.region(RomRegion::Color)[0x1F], 0xFF);
+    CHECK_EQ(first.region(RomRegion::Color)[0x20], 0x0F);
+    CHECK(first.region(RomRegion::Tiles).empty());
+    CHECK(first.files.at("low.bin") == second.files.at("low.bin"));
+
+    // A file of the wrong size fails the load
+    writeRom(TEST_DIR / "pal.bin", std::vector<uint8_t>(0x0080, 0x0F));
+    RomSetImage short_image;
+    CHECK(!RomManager(TEST_DIR.string(), set).loadRegions(short_image));
+}
+
+
+int main() {
+    std::filesystem::remove_all(TEST_DIR);
+    std::filesystem::create_directories(TEST_DIR);
+
+    crcMatchesReference();
+    builtinSetsAreComplete();
+    parsesDescriptionFiles();
+    cacheSharesIdenticalFiles();
+    loadsRegions();
+
+    std::filesystem::remove_all(TEST_DIR);
+    return testResult("RomSetTest");
+}
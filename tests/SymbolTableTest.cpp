@@ -0,0 +1,98 @@
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include "Check.hpp"
+#include "core/SymbolTable.hpp"
+
+
+static std::string formatted(const SymbolTable& symbols, uint16_t address) {
+    std::ostringstream out;
+    symbols.formatAddress(out, address);
+    return out.str();
+}
+
+
+// The innermost range owns an address; labels run up to the next symbol
+static void lookupFindsInnermost() {
+    SymbolTable symbols;
+    symbols.add(0x1000, 0x1FFF, "outer");
+    symbols.add(0x1200, 0x12FF, "inner", "nested");
+    symbols.addLabel(0x3000, "label");
+    symbols.addLabel(0x3100, "next");
+    symbols.build();
+
+    CHECK(symbols.lookup(0x0FFF) == nullptr);
+    CHECK(symbols.name(*symbols.lookup(0x1000)) == "outer");
+    CHECK(symbols.name(*symbols.lookup(0x1250)) == "inner");
+    CHECK(symbols.comment(*symbols.lookup(0x1250)) == "nested");
+    CHECK(symbols.name(*symbols.lookup(0x1300)) == "outer");
+    CHECK(symbols.lookup(0x2000) == nullptr);
+    CHECK(symbols.name(*symbols.lookup(0x30FF)) == "label");
+    CHECK(symbols.name(*symbols.lookup(0xFFFF)) == "next");
+
+    CHECK(symbols.at(0x1200) != nullptr);
+    CHECK(symbols.at(0x1201) == nullptr);
+
+    CHECK(formatted(symbols, 0x1200) == "inner");
+    CHECK(formatted(symbols, 0x12AB) == "inner+ab");
+    CHECK(formatted(symbols, 0x2000).empty());
+}
+
+
+// Names are unique per address and valid identifiers whatever the symbol file says
+static void functionNamesAreUnique() {
+    SymbolTable symbols;
+    symbols.addLabel(0x0100, "ghost-ai");
+    symbols.addLabel(0x0200, "ghost_ai");
+    symbols.addLabel(0x0300, "int");
+    symbols.addLabel(0x0400, "1st.loop");
+    symbols.build();
+
+    CHECK(symbols.functionName(0x0010) == "blk_0010");
+    CHECK(symbols.functionName(0x0100) == "blk_0100_ghost_ai");
+    CHECK(symbols.functionName(0x0200) == "blk_0200_ghost_ai");
+    CHECK(symbols.functionName(0x0300) == "blk_0300_int");
+    CHECK(symbols.functionName(0x0400) == "blk_0400_1st_loop");
+    CHECK(symbols.functionName(0xABCD) == "blk_abcd_1st_loop");
+
+    std::set<std::string> names;
+    for (uint16_t address : { 0x0100, 0x0101, 0x0200, 0x0300 })
+        names.insert(symbols.functionName(address));
+    CHECK_EQ(names.size(), 4u);
+}
+
+
+static void loadsSymbolFiles() {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "pacman_symbol_table_test.sym";
+    {
+        std::ofstream out(path);
+        out << "# Pac-Man\n"
+            << "0a2c-0b11  draw_maze      ; draws the maze  \n"
+            << "\n"
+            << "2fc0       sound_irq\n";
+    }
+
+    SymbolTable symbols;
+    CHECK(loadSymbolFile(path, symbols));
+    CHECK_EQ(symbols.size(), 2u);
+    CHECK(symbols.comment(*symbols.lookup(0x0B11)) == "draws the maze");
+    CHECK(symbols.lookup(0x0B12) == nullptr);
+    CHECK(symbols.name(*symbols.lookup(0x4000)) == "sound_irq");
+
+    for (const char* bad : { "0b11-0a2c reversed\n", "12g4 bad_hex\n", "10000 too_high\n", "2fc0\n" }) {
+        std::ofstream(path) << bad;
+        SymbolTable rejected;
+        CHECK(!loadSymbolFile(path, rejected));
+    }
+    std::filesystem::remove(path);
+}
+
+
+int main() {
+    lookupFindsInnermost();
+    functionNamesAreUnique();
+    loadsSymbolFiles();
+    return testResult("SymbolTableTest");
+}
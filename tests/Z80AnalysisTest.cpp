@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "Check.hpp"
+#include "core/Z80Analysis.hpp"
+
+
+namespace {
+
+// 256 bytes of RET with 'code' written at 'address'
+std::vector<uint8_t> makeImage(std::initializer_list<std::pair<uint16_t, std::vector<uint8_t>>> code) {
+    std::vector<uint8_t> image(0x100, 0xC9);
+    for (const auto& [address, bytes] : code)
+        std::copy(bytes.begin(), bytes.end(), image.begin() + address);
+    return image;
+}
+
+
+Z80AnalysisOptions resetOnly() {
+    Z80AnalysisOptions options;
+    options.entry_points = { 0x0000 };
+    options.find_interrupt_vectors = false;
+    return options;
+}
+
+
+bool contains(const std::vector<uint16_t>& list, uint16_t value) {
+    return std::find(list.begin(), list.end(), value) != list.end();
+}
+
+}   // namespace
+
+
+static void jumpIntoBlockSplitsIt() {
+    Z80Analysis analysis(makeImage({ { 0x0000, { 0x00, 0x00, 0x00, 0xC3, 0x01, 0x00 } } }), 0x0000, resetOnly());
+    analysis.analyze();
+
+    const Z80BasicBlock* head = analysis.blockAt(0x0000);
+    const Z80BasicBlock* tail = analysis.blockAt(0x0001);
+    CHECK(head && tail && head != tail);
+    if (head && tail) {
+        CHECK_EQ(head->end, 0x0001);
+        CHECK(head->successors == std::vector<uint16_t>{ 0x0001 });
+        CHECK_EQ(tail->end, 0x0006);
+        CHECK_EQ(tail->instructions.size(), 3u);
+    }
+}
+
+
+// Retargeting a call re-decodes its block, finds the new callee and drops the old one
+static void patchRetargetsCall() {
+    Z80Analysis analysis(makeImage({
+        { 0x0000, { 0xC3, 0x10, 0x00 } },           // jp 0010h
+        { 0x0010, { 0xCD, 0x20, 0x00 } },           // call 0020h
+        { 0x0013, { 0x18, 0xFE } },                 // jr $
+    }), 0x0000, resetOnly());
+    analysis.analyze();
+
+    CHECK_EQ(analysis.blocks().size(), 4u);
+    CHECK(analysis.blockAt(0x0020) != nullptr);
+    const uint32_t untouched_revision = analysis.blockAt(0x0013)->revision;
+    const uint32_t patched_revision = analysis.blockAt(0x0010)->revision;
+
+    const std::array<uint8_t, 1> target = { 0x30 };
+    const Z80PatchResult result = analysis.applyPatch(0x0011, target);
+
+    CHECK(contains(result.changed_blocks, 0x0010));
+    CHECK(contains(result.changed_blocks, 0x0030));
+    CHECK(!contains(result.changed_blocks, 0x0013));
+    CHECK(result.removed_blocks == std::vector<uint16_t>{ 0x0020 });
+
+    CHECK(analysis.blockAt(0x0020) == nullptr);
+    CHECK(analysis.blockAt(0x0030) != nullptr);
+    CHECK(analysis.blockAt(0x0010)->revision != patched_revision);
+    CHECK_EQ(analysis.blockAt(0x0013)->revision, untouched_revision);
+    CHECK_EQ(analysis.image()[0x0011], 0x30);
+
+    // Patching bytes no block covers changes nothing
+    const std::array<uint8_t, 2> filler = { 0x00, 0x00 };
+    const Z80PatchResult idle = analysis.applyPatch(0x00F0, filler);
+    CHECK(idle.changed_blocks.empty());
+    CHECK(idle.removed_blocks.empty());
+}
+
+
+// 'ld a,0 / ld i,a' and 'ld a,80h / out (0),a' select the table word at 0080h
+static void interruptVectorsFromCode() {
+    const std::vector<uint8_t> image = makeImage({
+        { 0x0000, { 0x3E, 0x00, 0xED, 0x47, 0x3E, 0x80, 0xD3, 0x00, 0xED, 0x5E, 0xFB, 0x18, 0xFE } },
+        { 0x0080, { 0x50, 0x00 } },
+    });
+
+    Z80AnalysisOptions options;
+    options.entry_points = { 0x0000 };
+    Z80Analysis analysis(image, 0x0000, options);
+    analysis.analyze();
+
+    CHECK(analysis.interruptHandlers() == std::vector<uint16_t>{ 0x0050 });
+    CHECK(analysis.blockAt(0x0050) != nullptr);
+
+    // Rewriting the table word moves the handler even though no block covers the word
+    const std::array<uint8_t, 2> vector = { 0x60, 0x00 };
+    const Z80PatchResult result = analysis.applyPatch(0x0080, vector);
+    CHECK(result.changed_blocks == std::vector<uint16_t>{ 0x0060 });
+    CHECK(result.removed_blocks == std::vector<uint16_t>{ 0x0050 });
+    CHECK(analysis.blockAt(0x0050) == nullptr);
+
+    // Without vector discovery the handler is only reached through the configured table word
+    options.find_interrupt_vectors = false;
+    Z80Analysis plain(image, 0x0000, options);
+    plain.analyze();
+    CHECK(plain.blockAt(0x0050) == nullptr);
+
+    options.interrupt_vectors = { 0x0080 };
+    Z80Analysis configured(image, 0x0000, options);
+    configured.analyze();
+    CHECK(configured.blockAt(0x0050) != nullptr);
+}
+
+
+int main() {
+    jumpIntoBlockSplitsIt();
+    patchRetargetsCall();
+    interruptVectorsFromCode();
+    return testResult("Z80AnalysisTest");
+}
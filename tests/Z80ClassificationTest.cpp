@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <vector>
+#include "Check.hpp"
+#include "core/Z80Classification.hpp"
+#include "core/Z80Disassembler.hpp"
+
+
+/* 256 bytes of erased EPROM holding:
+ *
+ *   0000  ld hl,0040h / rst 20h, then a two-entry jump table (0010h, 0018h)
+ *   0010  rst 28h with two inline argument bytes, then ret
+ *   0018  ld a,(0080h) / ret
+ *   0020  ret (RST 20h), 0028 ret (RST 28h)
+ *   0040  three bytes pointed at by ld hl; 0080 two bytes read by ld a
+ *   00c0  code nothing reaches
+ */
+static std::vector<uint8_t> makeImage() {
+    std::vector<uint8_t> image(0x100, 0xFF);
+    auto put = [&image](uint16_t address, std::initializer_list<uint8_t> bytes) {
+        std::ranges::copy(bytes, image.begin() + address);
+    };
+    put(0x0000, { 0x21, 0x40, 0x00, 0xE7, 0x10, 0x00, 0x18, 0x00 });
+    put(0x0010, { 0xEF, 0x01, 0x02, 0xC9 });
+    put(0x0018, { 0x3A, 0x80, 0x00, 0xC9 });
+    put(0x0020, { 0xC9 });
+    put(0x0028, { 0xC9 });
+    put(0x0040, { 0x01, 0x02, 0x03 });
+    put(0x0080, { 0x09, 0x0A });
+    put(0x00C0, { 0x3E, 0x01, 0xC9 });
+    return image;
+}
+
+
+static Z80AnalysisOptions resetOnly() {
+    Z80AnalysisOptions options;
+    options.entry_points = { 0x0000 };
+    options.find_interrupt_vectors = false;
+    return options;
+}
+
+
+static void checkRange(const Z80Classification& classification, uint16_t start, uint16_t end, ByteClass expected) {
+    for (uint16_t address = start; address < end; ++address) {
+        if (classification.at(address) != expected)
+            std::cerr << std::hex << address << std::dec << " is " << byteClassName(classification.at(address))
+                      << ", expected " << byteClassName(expected) << "\n";
+        CHECK(classification.at(address) == expected);
+    }
+}
+
+
+static void classifiesEveryByte() {
+    Z80Analysis analysis(makeImage(), 0x0000, resetOnly());
+    analysis.analyze();
+    const Z80Classification classification(analysis);
+
+    checkRange(classification, 0x0000, 0x0004, ByteClass::Code);
+    checkRange(classification, 0x0004, 0x0008, ByteClass::JumpTable);
+    checkRange(classification, 0x0008, 0x0010, ByteClass::Unknown);
+    checkRange(classification, 0x0010, 0x0011, ByteClass::Code);
+    checkRange(classification, 0x0011, 0x0013, ByteClass::Data);
+    checkRange(classification, 0x0013, 0x0014, ByteClass::Code);
+    checkRange(classification, 0x0018, 0x001C, ByteClass::Code);
+    checkRange(classification, 0x0040, 0x0043, ByteClass::Data);
+    checkRange(classification, 0x0043, 0x0080, ByteClass::Unknown);    // erased fill ends the data
+    checkRange(classification, 0x0080, 0x0082, ByteClass::Data);
+    checkRange(classification, 0x00C0, 0x0100, ByteClass::Unknown);
+
+    CHECK_EQ(classification.count(ByteClass::Code), 12u);
+    CHECK_EQ(classification.count(ByteClass::JumpTable), 4u);
+    CHECK_EQ(classification.count(ByteClass::Data), 7u);
+    CHECK_EQ(classification.count(ByteClass::Unknown), 0x100u - 23u);
+    CHECK(classification.at(0x0100) == ByteClass::Unknown);
+
+    // Four 2-bit classes per byte, lowest address in the low bits
+    CHECK_EQ(classification.bitmap().size(), 0x40u);
+    CHECK_EQ(classification.bitmap()[0], 0x55);
+    CHECK_EQ(classification.bitmap()[1], 0xFF);
+    CHECK_EQ(classification.bitmap()[4], 0x69);        // 0013 code, 0012-0011 data, 0010 code: 01 10 10 01
+
+    // The listing drops code nobody reaches and summarizes it instead
+    std::ostringstream listing;
+    disassembleReachable(analysis, classification, listing);
+    CHECK(listing.str().find("00c0:") == std::string::npos);
+    CHECK(listing.str().find("; 0082-00ff not referenced") != std::string::npos);
+}
+
+
+// Reclassifying after a patch follows the new pointer
+static void followsPatchedPointers() {
+    Z80Analysis analysis(makeImage(), 0x0000, resetOnly());
+    analysis.analyze();
+    Z80Classification classification(analysis);
+
+    const std::array<uint8_t, 1> pointer = { 0xC0 };
+    analysis.applyPatch(0x0019, pointer);
+    classification.classify(analysis);
+
+    checkRange(classification, 0x0080, 0x0082, ByteClass::Unknown);
+    checkRange(classification, 0x00C0, 0x00C3, ByteClass::Data);
+    checkRange(classification, 0x00C3, 0x0100, ByteClass::Unknown);
+}
+
+
+int main() {
+    classifiesEveryByte();
+    followsPatchedPointers();
+    return testResult("Z80ClassificationTest");
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Check.hpp"
+#include "core/Z80Debugger.hpp"
+#include "machine/PacmanMachine.hpp"
+
+
+// ld hl,'target' / loop: ld (hl),a / inc a / jr loop
+static std::vector<uint8_t> storeLoop(uint16_t target) {
+    std::vector<uint8_t> rom(0x4000, 0x00);
+    const uint8_t program[] = {
+        0x21, static_cast<uint8_t>(target), static_cast<uint8_t>(target >> 8),
+        0x77,
+        0x3C,
+        0x18, 0xFC
+    };
+    std::ranges::copy(program, rom.begin());
+    return rom;
+}
+
+
+// A watch set on either mirror catches writes through both
+static void watchCoversMirrors() {
+    for (uint16_t watched : { 0x4D10, 0xCD10 }) {
+        for (uint16_t written : { 0x4D10, 0xCD10 }) {
+            const std::vector<uint8_t> rom = storeLoop(written);
+            PacmanMachine machine(rom);
+            machine.reset();
+            Z80Debugger debugger(machine.cpu());
+            debugger.addWatchpoint(watched, 1);
+            CHECK_EQ(debugger.watchpoints()[0].start, 0x4D10);
+
+            // A is FFh after reset
+            for (uint8_t value : { 0xFF, 0x00, 0x01 }) {
+                debugger.run(1000);
+                const DebugStop& stop = debugger.lastStop();
+                CHECK(stop.reason == DebugStopReason::Watchpoint);
+                CHECK_EQ(stop.address, written);
+                CHECK_EQ(stop.value, value);
+                CHECK_EQ(stop.access, BUS_WRITE);
+                CHECK_EQ(stop.pc, 0x0004);
+            }
+        }
+    }
+
+    // A neighbouring address is not reported
+    const std::vector<uint8_t> rom = storeLoop(0xCD11);
+    PacmanMachine machine(rom);
+    machine.reset();
+    Z80Debugger debugger(machine.cpu());
+    debugger.addWatchpoint(0x4D10, 1);
+    CHECK_EQ(debugger.run(1000), 10 + 43 * 23 + 7);     // ends on the first instruction past the budget
+    CHECK(debugger.lastStop().reason == DebugStopReason::None);
+}
+
+
+static void breakpointsStopBeforeExecuting() {
+    const std::vector<uint8_t> rom = storeLoop(0x4D10);
+    PacmanMachine machine(rom);
+    machine.reset();
+    Z80Debugger debugger(machine.cpu());
+    debugger.addBreakpoint(0x0004);
+
+    CHECK_EQ(debugger.run(1000), 10 + 7);
+    CHECK(debugger.lastStop().reason == DebugStopReason::Breakpoint);
+    CHECK_EQ(debugger.lastStop().pc, 0x0004);
+
+    // Resuming runs over the breakpoint once, then stops on the next pass
+    CHECK_EQ(debugger.run(1000), 4 + 12 + 7);
+    CHECK_EQ(debugger.lastStop().pc, 0x0004);
+
+    debugger.removeBreakpoint(0x0004);
+    CHECK(!debugger.armed());
+}
+
+
+/* Stops return false from runFrame() and resume inside the same frame. With a stop
+ * on every loop pass some land on a frame's last instruction; frames must still be
+ * counted once and keep their length.
+ */
+static void framesSurviveStops() {
+    const std::vector<uint8_t> rom = storeLoop(0xCD10);
+    PacmanMachine machine(rom);
+    machine.reset();
+    Z80Debugger debugger(machine.cpu());
+    machine.attachDebugger(&debugger);
+    debugger.addWatchpoint(0x4D10, 1);
+
+    const uint64_t frames = 10;
+    uint64_t completed = 0;
+    uint64_t stops = 0;
+    while (completed < frames) {
+        if (machine.runFrame())
+            ++completed;
+        else
+            ++stops;
+    }
+
+    CHECK_EQ(machine.frameCount(), frames);
+    CHECK(stops > frames * 1000);
+    CHECK(machine.cpu().total_cycles >= frames * PACMAN_CYCLES_PER_FRAME);
+    CHECK(machine.cpu().total_cycles < frames * PACMAN_CYCLES_PER_FRAME + 23);
+
+    debugger.clearWatchpoints();
+    CHECK(machine.runFrame());
+    CHECK_EQ(machine.frameCount(), frames + 1);
+}
+
+
+static void traceKeepsLastInstructions() {
+    const std::vector<uint8_t> rom = storeLoop(0x4D10);
+    PacmanMachine machine(rom);
+    machine.reset();
+    Z80Debugger debugger(machine.cpu());
+    debugger.setTraceDepth(3);
+
+    for (int i = 0; i < 5; ++i)
+        debugger.stepInstruction();
+
+    CHECK_EQ(debugger.traceSize(), 3u);
+    CHECK_EQ(debugger.traceEntry(0).pc, 0x0004);
+    CHECK_EQ(debugger.traceEntry(1).pc, 0x0005);
+    CHECK_EQ(debugger.traceEntry(2).pc, 0x0003);
+    CHECK_EQ(debugger.traceEntry(2).hl, 0x4D10);
+    CHECK_EQ(debugger.traceEntry(1).bytes[0], 0x18);
+
+    std::ostringstream out;
+    debugger.writeTrace(out);
+    const std::string text = out.str();
+    CHECK_EQ(std::ranges::count(text, '\n'), 3);
+    CHECK(text.starts_with("0004: "));
+
+    debugger.setTraceDepth(0);
+    CHECK(!debugger.armed());
+}
+
+
+int main() {
+    watchCoversMirrors();
+    breakpointsStopBeforeExecuting();
+    framesSurviveStops();
+    traceKeepsLastInstructions();
+    return testResult("Z80DebuggerTest");
+}
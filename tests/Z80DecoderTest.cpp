@@ -0,0 +1,121 @@
+#include <array>
+#include <sstream>
+#include <vector>
+#include "Check.hpp"
+#include "core/Z80Decoder.hpp"
+
+
+static Z80DecodedInstruction decode(std::span<const uint8_t> bytes, uint16_t base = 0x0000) {
+    Z80DecodedInstruction inst;
+    CHECK(decodeZ80At(bytes, base, base, inst));
+    return inst;
+}
+
+
+static std::string format(const Z80DecodedInstruction& inst) {
+    std::ostringstream out;
+    formatZ80Instruction(out, inst);
+    return out.str();
+}
+
+
+// DD CB d op: four bytes, displacement before the opcode
+static void indexedBitInstructions() {
+    const std::array<uint8_t, 4> bit_ix = { 0xDD, 0xCB, 0x05, 0x46 };
+    const Z80DecodedInstruction bit = decode(bit_ix);
+    CHECK(bit.prefix == Z80Prefix::DDCB);
+    CHECK_EQ(bit.opcode, 0x46);
+    CHECK_EQ(bit.length, 4);
+    CHECK_EQ(bit.displacement, 5);
+    CHECK(bit.has_displacement);
+    CHECK(bit.flow == Z80Flow::Next);
+
+    const std::array<uint8_t, 4> rlc_iy = { 0xFD, 0xCB, 0xFE, 0x06 };
+    const Z80DecodedInstruction rlc = decode(rlc_iy);
+    CHECK(rlc.prefix == Z80Prefix::FDCB);
+    CHECK_EQ(rlc.opcode, 0x06);
+    CHECK_EQ(rlc.length, 4);
+    CHECK_EQ(rlc.displacement, -2);
+
+    // Truncated forms are rejected instead of reading past the span
+    Z80DecodedInstruction inst;
+    const std::array<uint8_t, 3> truncated = { 0xDD, 0xCB, 0x05 };
+    CHECK(!decodeZ80At(truncated, 0x0000, 0x0000, inst));
+}
+
+
+// The bit table holds lengths without the CB prefix, like the other prefixed tables
+static void bitTableLengths() {
+    for (unsigned op = 0; op < 0x100; ++op) {
+        const std::array<uint8_t, 2> bytes = { 0xCB, static_cast<uint8_t>(op) };
+        const Z80DecodedInstruction inst = decode(bytes);
+        CHECK(inst.prefix == Z80Prefix::CB);
+        CHECK_EQ(inst.length, 2);
+    }
+
+    const std::array<uint8_t, 2> bit_7_h = { 0xCB, 0x7C };
+    CHECK(format(decode(bit_7_h)).starts_with("BIT 7,H"));
+}
+
+
+static void operandsAndTargets() {
+    const std::array<uint8_t, 4> ld_ix = { 0xDD, 0x21, 0x34, 0x12 };
+    const Z80DecodedInstruction load = decode(ld_ix);
+    CHECK_EQ(load.length, 4);
+    CHECK_EQ(load.operand, 0x1234);
+    CHECK_EQ(load.operand_size, 2);
+
+    const std::array<uint8_t, 3> ld_a_ix = { 0xDD, 0x7E, 0xFB };
+    const Z80DecodedInstruction indexed = decode(ld_a_ix);
+    CHECK_EQ(indexed.length, 3);
+    CHECK(indexed.has_displacement);
+    CHECK_EQ(indexed.displacement, -5);
+
+    // Relative targets are resolved against the instruction's own address
+    const std::array<uint8_t, 2> jr_self = { 0x18, 0xFE };
+    const Z80DecodedInstruction jr = decode(jr_self, 0x8000);
+    CHECK(jr.flow == Z80Flow::Jump);
+    CHECK(jr.has_target);
+    CHECK_EQ(jr.target, 0x8000);
+
+    const std::array<uint8_t, 1> rst = { 0xE7 };
+    const Z80DecodedInstruction restart = decode(rst);
+    CHECK(restart.flow == Z80Flow::Restart);
+    CHECK_EQ(restart.target, 0x20);
+
+    const std::array<uint8_t, 2> reti = { 0xED, 0x4D };
+    CHECK(decode(reti).flow == Z80Flow::Return);
+}
+
+
+// A linear sweep stays in sync across every prefix form
+static void sweepStaysInSync() {
+    const std::vector<uint8_t> code = {
+        0xCB, 0x11,                     // RL C
+        0xDD, 0xCB, 0x01, 0xC6,         // SET 0,(IX+1)
+        0xED, 0xB0,                     // LDIR
+        0x3E, 0x42,                     // LD A,42h
+        0xC9,                           // RET
+        0xDD                            // truncated prefix ends the sweep
+    };
+
+    std::vector<uint16_t> addresses;
+    for (const Z80DecodedInstruction& inst : decodeZ80(code, 0x4000))
+        addresses.push_back(inst.address);
+
+    CHECK((addresses == std::vector<uint16_t>{ 0x4000, 0x4002, 0x4006, 0x4008, 0x400A }));
+
+    // Starting in the middle of the range
+    Z80DecodeView view(code, 0x4000, 0x4006);
+    CHECK(view.begin()->prefix == Z80Prefix::ED);
+    CHECK_EQ(view.begin()->opcode, 0xB0);
+}
+
+
+int main() {
+    indexedBitInstructions();
+    bitTableLengths();
+    operandsAndTargets();
+    sweepStaysInSync();
+    return testResult("Z80DecoderTest");
+}
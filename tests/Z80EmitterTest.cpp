@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Check.hpp"
+#include "recomp/Z80Emitter.hpp"
+
+
+// Emits the block at 'start' of 'code' (padded with RET)
+static std::string emitted(std::initializer_list<uint8_t> code, uint16_t start = 0x0000) {
+    std::vector<uint8_t> image(0x100, 0xC9);
+    std::ranges::copy(code, image.begin());
+
+    Z80AnalysisOptions options;
+    options.entry_points = { 0x0000 };
+    options.find_interrupt_vectors = false;
+    Z80Analysis analysis(image, 0x0000, options);
+    analysis.analyze();
+
+    std::ostringstream out;
+    emitZ80Block(out, lowerBlock(*analysis.blockAt(start)), "blk");
+    return out.str();
+}
+
+
+/* An interpreted EI delays interrupts for one instruction. Inside a block that is the
+ * next IR instruction; when the EI ends the block, the block runs the next one in the
+ * interpreter before returning.
+ */
+static void eiDelayEndsInsideTheBlock() {
+    // ld sp,5000h / im 1 / ei / loop: jr loop
+    const std::string idle = emitted({ 0x31, 0x00, 0x50, 0xED, 0x56, 0xFB, 0x18, 0xFE });
+    CHECK(idle.find("cpu.regs.pc = 0x0005; cpu.executeInstruction();\n"
+                    "    if (cpu.interruptDelayed()) { cpu.step(); return cpu.regs.pc; }\n") != std::string::npos);
+
+    // ei / ret
+    const std::string handler = emitted({ 0xFB, 0xC9 });
+    CHECK(handler.find("cpu.executeInstruction();\n    cpu.endInterruptDelay();\n") != std::string::npos);
+    CHECK(handler.find("cpu.interruptDelayed()") == std::string::npos);
+}
+
+
+int main() {
+    eiDelayEndsInsideTheBlock();
+    return testResult("Z80EmitterTest");
+}
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+#include "Check.hpp"
+#include "recomp/Z80Executor.hpp"
+
+
+namespace {
+
+/* ROM at 0000h, 4 KB of RAM at 4000h mirrored at C000h, like the Pac-Man board.
+ * Two of them run the same program: one through the executor, one stepped by the
+ * interpreter as the reference.
+ */
+struct TestBoard {
+    std::vector<uint8_t> rom;
+    std::array<uint8_t, 0x1000> ram{};
+    MemoryBus bus;
+    Z80Cpu cpu{ bus };
+
+    explicit TestBoard(std::vector<uint8_t> program) : rom(std::move(program)) {
+        bus.mapRom(0x0000, 0x4000, rom.data());
+        bus.mapRam(0x4000, 0x1000, ram.data());
+        bus.mapRam(0xC000, 0x1000, ram.data());
+    }
+};
+
+
+std::vector<uint8_t> makeProgram(std::initializer_list<uint8_t> main_code) {
+    std::vector<uint8_t> program(0x4000, 0x00);
+    std::ranges::copy(main_code, program.begin());
+
+    // 0020: ld a,5 / ld hl,4E00h / add a,(hl) / ld (hl),a / ret
+    const uint8_t routine[] = { 0x3E, 0x05, 0x21, 0x00, 0x4E, 0x86, 0x77, 0xC9 };
+    std::ranges::copy(routine, program.begin() + 0x20);
+    return program;
+}
+
+
+// Runs 'frames' frames on both boards and compares them after each one; 'vblank' raises the IRQ at each frame start
+bool runsLikeInterpreter(Z80Executor& executor, TestBoard& fast, TestBoard& reference, int frames, bool vblank = false) {
+    for (int frame = 0; frame < frames; ++frame) {
+        if (vblank) {
+            fast.cpu.setIrqLine(true);
+            reference.cpu.setIrqLine(true);
+        }
+        executor.run(50688);
+        while (reference.cpu.total_cycles < fast.cpu.total_cycles)
+            reference.cpu.step();
+
+        if (reference.cpu.total_cycles != fast.cpu.total_cycles ||
+            std::memcmp(&reference.cpu.regs, &fast.cpu.regs, sizeof(Z80Registers)) != 0 || reference.ram != fast.ram) {
+            std::cerr << "Executor diverged in frame " << frame << " at pc " << std::hex << fast.cpu.regs.pc
+                      << " (interpreter at " << reference.cpu.regs.pc << ")" << std::dec << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+}   // namespace
+
+
+/* Copies the routine to 4C00h, calls it, then rewrites its 'ld a,n' operand through
+ * the C000h mirror. Every rewrite must invalidate the RAM translation; once the sum
+ * settles the same byte is written back and the cached translation is found again.
+ */
+static void selfModifyingCodeIsRetranslated() {
+    const std::vector<uint8_t> program = makeProgram({
+        0x31, 0x00, 0x50,           // ld sp,5000h
+        0x21, 0x20, 0x00,           // ld hl,0020h
+        0x11, 0x00, 0x4C,           // ld de,4C00h
+        0x01, 0x08, 0x00,           // ld bc,8
+        0xED, 0xB0,                 // ldir
+        0xCD, 0x00, 0x4C,           // loop: call 4C00h
+        0x3C,                       // inc a
+        0x32, 0x01, 0xCC,           // ld (CC01h),a
+        0x18, 0xF7                  // jr loop
+    });
+    TestBoard fast(program);
+    TestBoard reference(program);
+    Z80Executor executor(fast.cpu);
+
+    CHECK(runsLikeInterpreter(executor, fast, reference, 20));
+    const Z80ExecutorStats& stats = executor.stats();
+    CHECK(stats.ram_blocks > 0);
+    CHECK(stats.invalidations > 0);
+    CHECK(stats.translations >= 3);
+    CHECK(stats.translations + stats.reused >= stats.invalidations);
+    CHECK(executor.cachedTranslations() <= Z80Executor::MAX_TRANSLATIONS);
+
+    executor.flush();
+    CHECK_EQ(executor.cachedTranslations(), 0u);
+    CHECK(runsLikeInterpreter(executor, fast, reference, 2));
+}
+
+
+// Copying the same bytes again invalidates the translation but finds it again in the cache
+static void identicalCopiesAreReused() {
+    const std::vector<uint8_t> program = makeProgram({
+        0x31, 0x00, 0x50,           // ld sp,5000h
+        0x21, 0x20, 0x00,           // loop: ld hl,0020h
+        0x11, 0x00, 0x4C,           // ld de,4C00h
+        0x01, 0x08, 0x00,           // ld bc,8
+        0xED, 0xB0,                 // ldir
+        0xCD, 0x00, 0x4C,           // call 4C00h
+        0x18, 0xF0                  // jr loop
+    });
+    TestBoard fast(program);
+    TestBoard reference(program);
+    Z80Executor executor(fast.cpu);
+
+    CHECK(runsLikeInterpreter(executor, fast, reference, 5));
+    const Z80ExecutorStats& stats = executor.stats();
+    CHECK(stats.invalidations > 100);
+    CHECK(stats.reused > 100);
+    CHECK(stats.translations < 10);
+}
+
+
+// A translation spanning two pages, invalidated through one, leaves neither page's list behind
+static void pageListsStayBounded() {
+    const std::vector<uint8_t> program = makeProgram({
+        0x31, 0x00, 0x50,           // ld sp,5000h
+        0x21, 0x20, 0x00,           // ld hl,0020h
+        0x11, 0xFC, 0x4C,           // ld de,4CFCh
+        0x01, 0x08, 0x00,           // ld bc,8
+        0xED, 0xB0,                 // ldir
+        0xCD, 0xFC, 0x4C,           // loop: call 4CFCh
+        0x32, 0x00, 0x4C,           // ld (4C00h),a
+        0x18, 0xF8                  // jr loop
+    });
+    TestBoard fast(program);
+    TestBoard reference(program);
+    Z80Executor executor(fast.cpu);
+
+    CHECK(runsLikeInterpreter(executor, fast, reference, 3));
+    CHECK(executor.stats().invalidations > 100);
+    CHECK(executor.stats().reused > 100);
+    CHECK(executor.watchedBlocks() <= 2);
+}
+
+
+static uint16_t generatedReset(Z80Cpu& cpu) {
+    cpu.regs.sp = 0x5000;
+    cpu.total_cycles += 10;
+    z80AdvanceRefresh(cpu.regs, 1);
+    return 0x0003;
+}
+
+
+// A generated block replaces the translation of its ROM range
+static void generatedBlocksRunFirst() {
+    const std::vector<uint8_t> program = makeProgram({
+        0x31, 0x00, 0x50,           // ld sp,5000h
+        0xCD, 0x20, 0x00,           // loop: call 0020h
+        0x18, 0xFB                  // jr loop
+    });
+    const Z80GeneratedBlock blocks[] = { { 0x0000, 0x0003, generatedReset } };
+
+    TestBoard fast(program);
+    TestBoard reference(program);
+    Z80Executor executor(fast.cpu, blocks);
+
+    CHECK(runsLikeInterpreter(executor, fast, reference, 3));
+    CHECK_EQ(executor.stats().static_blocks, 1u);
+    CHECK_EQ(executor.stats().ram_blocks, 0u);
+    CHECK_EQ(executor.stats().invalidations, 0u);
+}
+
+
+/* An EI that ends a translation (the 32nd instruction) leaves the interrupt delay set
+ * for the instruction after it; that one must run and clear it, or 'jr $' never takes
+ * the IRQ. The handler counts interrupts at 4C00h.
+ */
+static void interruptsFollowEi() {
+    std::vector<uint8_t> program(0x4000, 0x00);
+    const uint8_t start[] = { 0x31, 0x00, 0x50, 0xED, 0x56 };      // ld sp,5000h / im 1
+    const uint8_t idle[] = { 0xFB, 0x18, 0xFE };                    // 0022: ei / jr $
+    const uint8_t handler[] = { 0x21, 0x00, 0x4C, 0x34, 0xFB, 0xC9 };   // 0038: ld hl,4C00h / inc (hl) / ei / ret
+    std::ranges::copy(start, program.begin());
+    std::ranges::copy(idle, program.begin() + 0x22);
+    std::ranges::copy(handler, program.begin() + 0x38);
+
+    TestBoard fast(program);
+    TestBoard reference(program);
+    Z80Executor executor(fast.cpu);
+
+    CHECK(runsLikeInterpreter(executor, fast, reference, 10, true));
+    CHECK_EQ(fast.ram[0x0C00], 10);
+    CHECK(executor.stats().translated_blocks > 0);
+}
+
+
+int main() {
+    selfModifyingCodeIsRetranslated();
+    identicalCopiesAreReused();
+    pageListsStayBounded();
+    generatedBlocksRunFirst();
+    interruptsFollowEi();
+    return testResult("Z80ExecutorTest");
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <vector>
+#include "Check.hpp"
+#include "recomp/Z80Ir.hpp"
+#include "recomp/Z80IrOptimizer.hpp"
+
+
+// Lowers the block at 0000h of 'code' (padded with RET)
+static IrBlock lower(std::initializer_list<uint8_t> code) {
+    std::vector<uint8_t> image(0x100, 0xC9);
+    std::ranges::copy(code, image.begin());
+
+    Z80AnalysisOptions options;
+    options.entry_points = { 0x0000 };
+    options.find_interrupt_vectors = false;
+    Z80Analysis analysis(image, 0x0000, options);
+    analysis.analyze();
+    return lowerBlock(*analysis.blockAt(0x0000));
+}
+
+
+static std::vector<IrOp> ops(const IrBlock& block) {
+    std::vector<IrOp> result;
+    for (const IrInstruction& inst : block.code)
+        result.push_back(inst.op);
+    return result;
+}
+
+
+// Flags overwritten before anything reads them are dead; barriers read them all
+static void deadFlags() {
+    IrBlock block = lower({ 0x80, 0x81, 0xC9 });               // add a,b / add a,c / ret
+    markDeadFlags(block);
+    CHECK((ops(block) == std::vector<IrOp>{ IrOp::Alu8, IrOp::Alu8, IrOp::Return }));
+    CHECK(block.code[0].flags_dead);
+    CHECK(!block.code[1].flags_dead);
+    CHECK(!(irLiveWrites(block.code[0]) & irSlotBit(IrReg::F)));
+    CHECK(irLiveWrites(block.code[1]) & irSlotBit(IrReg::F));
+
+    // ADC reads the carry, so the flags of the add before it stay live
+    IrBlock carry = lower({ 0x80, 0x89, 0xC9 });               // add a,b / adc a,c / ret
+    markDeadFlags(carry);
+    CHECK(!carry.code[0].flags_dead);
+}
+
+
+static void constantsFold() {
+    // ld a,5 / add a,3 / jp z,0010h: the sum is 8, so the branch is never taken
+    IrBlock block = lower({ 0x3E, 0x05, 0xC6, 0x03, 0xCA, 0x10, 0x00 });
+    const uint16_t taken_cycles = block.code.back().cycles;
+    const uint16_t not_taken_cycles = block.code.back().cycles_alt;
+    markDeadFlags(block);
+    CHECK(foldConstants(block) >= 2);
+
+    CHECK(block.code.back().op == IrOp::FallThrough);
+    CHECK_EQ(block.code.back().cycles, not_taken_cycles);
+    CHECK_EQ(taken_cycles, not_taken_cycles);       // JP cc costs the same either way
+    const auto a_move = std::ranges::find_if(block.code, [](const IrInstruction& inst) {
+        return inst.op == IrOp::Move8 && inst.dst.isReg8(IrReg::A) && inst.src.isImm() && inst.src.value == 8;
+    });
+    CHECK(a_move != block.code.end());
+
+    // ld hl,0020h / jp (hl) becomes a direct jump
+    IrBlock indirect = lower({ 0x21, 0x20, 0x00, 0xE9 });
+    foldConstants(indirect);
+    CHECK(indirect.code.back().op == IrOp::Jump);
+    CHECK_EQ(indirect.code.back().target, 0x0020);
+
+    // Known addresses become immediates; loads stay loads
+    IrBlock load = lower({ 0x21, 0x00, 0x40, 0x7E, 0xC9 });    // ld hl,4000h / ld a,(hl) / ret
+    foldConstants(load);
+    CHECK(load.code[1].op == IrOp::Load8);
+    CHECK(load.code[1].addr.isImm());
+    CHECK_EQ(load.code[1].addr.value, 0x4000);
+}
+
+
+static void deadCodeGoes() {
+    IrBlock block = lower({ 0x06, 0x01, 0x06, 0x02, 0xC9 });   // ld b,1 / ld b,2 / ret
+    CHECK_EQ(eliminateDeadCode(block), 1u);
+    CHECK((ops(block) == std::vector<IrOp>{ IrOp::Move8, IrOp::Return }));
+    CHECK_EQ(block.code[0].src.value, 2);
+
+    // A load whose result is overwritten still happens: it may be a port read
+    IrBlock port = lower({ 0x3A, 0x00, 0x50, 0x3E, 0x01, 0xC9 });      // ld a,(5000h) / ld a,1 / ret
+    CHECK_EQ(eliminateDeadCode(port), 0u);
+    CHECK((ops(port) == std::vector<IrOp>{ IrOp::Load8, IrOp::Move8, IrOp::Return }));
+}
+
+
+static void pairsMerge() {
+    // ld h,12h / ld l,34h / ld d,h / ld e,l / ex de,hl / ex de,hl / ld a,a / ret
+    IrBlock block = lower({ 0x26, 0x12, 0x2E, 0x34, 0x54, 0x5D, 0xEB, 0xEB, 0x7F, 0xC9 });
+    CHECK_EQ(mergePairs(block), 5u);
+    CHECK((ops(block) == std::vector<IrOp>{ IrOp::Move16, IrOp::Move16, IrOp::Return }));
+    CHECK(block.code[0].dst.isPair(IrPair::HL));
+    CHECK_EQ(block.code[0].src.value, 0x1234);
+    CHECK(block.code[1].dst.isPair(IrPair::DE));
+    CHECK(block.code[1].src.isPair(IrPair::HL));
+
+    // Halves of different pairs are left alone
+    IrBlock mixed = lower({ 0x26, 0x12, 0x1E, 0x34, 0xC9 });   // ld h,12h / ld e,34h / ret
+    CHECK_EQ(mergePairs(mixed), 0u);
+}
+
+
+// Whole pipeline: nothing the block computes is lost at the barrier
+static void optimizeKeepsResults() {
+    // ld b,3 / ld a,b / add a,a / ld (4000h),a / ret
+    IrBlock block = lower({ 0x06, 0x03, 0x78, 0x87, 0x32, 0x00, 0x40, 0xC9 });
+    const IrOptimizeStats stats = optimizeIr(block);
+    CHECK(stats.folded >= 1);
+
+    const auto store = std::ranges::find_if(block.code, [](const IrInstruction& inst) { return inst.op == IrOp::Store8; });
+    CHECK(store != block.code.end());
+    if (store != block.code.end()) {
+        CHECK(store->src.isImm());
+        CHECK_EQ(store->src.value, 6);
+    }
+    for (IrReg reg : { IrReg::A, IrReg::B, IrReg::F }) {
+        const bool written = std::ranges::any_of(block.code, [reg](const IrInstruction& inst) {
+            return !inst.isBarrier() && (irLiveWrites(inst) & irSlotBit(reg));
+        });
+        CHECK(written);
+    }
+}
+
+
+int main() {
+    deadFlags();
+    constantsFold();
+    deadCodeGoes();
+    pairsMerge();
+    optimizeKeepsResults();
+    return testResult("Z80IrOptimizerTest");
+}